@@ -4,12 +4,15 @@
 #include <imgui_node_editor.h>
 #define IMGUI_DEFINE_MATH_OPERATORS
 #include "srrg_config_visualizer/configurable_node_manager.h"
+#include "srrg_config_visualizer/frame_profiler.h"
 #include <atomic>
+#include <cstdlib>
 #include <ax/Builders.h>
 #include <ax/Math2D.h>
 #include <ax/Widgets.h>
 #include <fstream>
 #include <imgui_internal.h>
+#include <new>
 #include <srrg_config/configurable_shell.h>
 #include <srrg_system_utils/parse_command_line.h>
 #include <thread>
@@ -27,6 +30,29 @@ static std::vector<std::string> types;
 static float types_max_size_x;
 static bool open_node_selector = false;
 static bool setup              = true;
+static bool continuous_redraw  = false;
+static bool show_search        = false;
+#ifdef SRRG_CONFIG_VISUALIZER_PROFILE
+static bool show_profiler = false;
+
+// srrg counts the allocations for the profiler, replaced in the executable only so that the
+// library never changes the allocator of whoever links it
+void* operator new(std::size_t size_) {
+  FrameProfiler::allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* ptr = std::malloc(size_ ? size_ : 1)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* ptr_) noexcept {
+  std::free(ptr_);
+}
+
+void operator delete(void* ptr_, std::size_t) noexcept {
+  std::free(ptr_);
+}
+#endif
 
 static const char* banner[] = {"Load a configuration and visualize the graph",
                                "w/ imgui-node-editor",
@@ -73,6 +99,29 @@ void displayMenuBar() {
       }
       ImGui::EndMenu();
     }
+    if (ImGui::BeginMenu("View")) {
+      if (ImGui::MenuItem("Cull off-screen nodes", nullptr, manager.culling())) {
+        manager.setCulling(!manager.culling());
+      }
+      const bool level_of_detail = manager.levelOfDetailEnabled();
+      if (ImGui::MenuItem("Simplify nodes when zoomed out", nullptr, level_of_detail)) {
+        manager.setLevelOfDetail(!level_of_detail);
+      }
+      if (ImGui::MenuItem("Incremental layout", nullptr, manager.incrementalLayout())) {
+        manager.setIncrementalLayout(!manager.incrementalLayout());
+      }
+      LayoutEngine& engine = manager.layoutEngine();
+      const bool layered   = engine.method == LayoutEngine::Method::Layered;
+      if (ImGui::MenuItem("Minimize link crossings", nullptr, layered)) {
+        engine.method = layered ? LayoutEngine::Method::Subtree : LayoutEngine::Method::Layered;
+        manager.refreshView(ImVec2(100, 100));
+      }
+      ImGui::MenuItem("Search", nullptr, &show_search);
+#ifdef SRRG_CONFIG_VISUALIZER_PROFILE
+      ImGui::MenuItem("Profiler", nullptr, &show_profiler);
+#endif
+      ImGui::EndMenu();
+    }
     ImGui::EndMenuBar();
   }
 
@@ -95,9 +144,9 @@ void displayMenuBar() {
     ImGui::PopItemWidth();
 
     if (ImGui::Button("Load")) {
-      if (manager.load(file_to_open)) {
+      if (manager.loadAsync(file_to_open)) {
         config_file = file_to_open;
-        std::cerr << "loaded file " << config_file << std::endl;
+        std::cerr << "loading file " << config_file << std::endl;
       }
       ImGui::CloseCurrentPopup();
       open_load_popup = false;
@@ -117,6 +166,7 @@ void displayMenuBar() {
     if (ImGui::Button("Save")) {
       config_file = file_to_open;
       manager.write(config_file);
+      manager.saveLayoutCache(ConfigurableNodeManager::layoutCacheFile(config_file));
       ImGui::CloseCurrentPopup();
       open_save_popup = false;
     }
@@ -125,6 +175,9 @@ void displayMenuBar() {
 }
 
 ImVec2 clicked_mouse;
+// srrg fixed texts of the node selector, measured once instead of at every frame
+static const CachedText selector_title("Select the type of node");
+static const CachedText selector_search("search");
 void bgContextMenu() {
   if (ImGui::BeginPopup("bg_context_menu")) {
     clicked_mouse = ImGui::GetIO().MouseClickedPos[1];
@@ -143,15 +196,14 @@ void bgContextMenu() {
 
   bool dummy_open = true;
 
-  types_max_size_x = std::max<float>(ImGui::CalcTextSize("Select the type of node").x + 100 +
-                                       ImGui::CalcTextSize("search").x,
-                                     types_max_size_x);
+  types_max_size_x = std::max<float>(
+    selector_title.size().x + 100 + selector_search.size().x, types_max_size_x);
   ImGui::SetNextWindowSize(ImVec2(types_max_size_x + 50, 300), ImGuiCond_FirstUseEver);
   if (ImGui::BeginPopupModal("node_selector", &dummy_open)) {
-    ImGui::Text("Select the type of node");
-    ImGui::SameLine(ImGui::GetWindowWidth() - 90 - ImGui::CalcTextSize("search").x);
+    selector_title.draw();
+    ImGui::SameLine(ImGui::GetWindowWidth() - 90 - selector_search.size().x);
     static ImGuiTextFilter filter;
-    filter.Draw("search", 70);
+    filter.Draw(selector_search.c_str(), 70);
     ImGui::SetNextWindowSize(ImVec2(types_max_size_x, 200), ImGuiCond_FirstUseEver);
     ImGui::BeginChild("ASD", ImVec2(0, 0), true);
     std::vector<bool> selected(types.size(), false);
@@ -187,7 +239,6 @@ static ed::NodeId contextNodeId = 0;
 static ed::LinkId contextLinkId = 0;
 static ed::PinId contextPinId   = 0;
 
-static std::map<void*, PropertyContainerIdentifiablePtr> nodeid_config_map;
 void nodeContextMenu() {
   std::vector<ed::NodeId> selectedNodes;
   std::vector<ed::LinkId> selectedLinks;
@@ -199,13 +250,11 @@ void nodeContextMenu() {
 
   if (ImGui::BeginPopup("node_context_menu")) {
     if (ImGui::MenuItem("Delete Node")) {
-      nodeid_config_map.clear();
-      for (auto& n : manager.nodes()) {
-        nodeid_config_map.insert(std::make_pair(n.second->ID().AsPointer(), n.first));
-      }
-
       for (const auto& node_id : selectedNodes) {
-        manager.deleteConfigurable(nodeid_config_map.at(node_id.AsPointer()));
+        ConfigNodePtr node = manager.findNode(node_id);
+        if (node) {
+          manager.deleteConfigurable(node->configurable());
+        }
       }
     }
     ImGui::EndPopup();
@@ -263,21 +312,182 @@ void displayContextMenu() {
   ed::Resume();
 }
 
+const char* loadPhaseName(const ConfigurableNodeManager::LoadPhase& phase_) {
+  using LoadPhase = ConfigurableNodeManager::LoadPhase;
+  switch (phase_) {
+    case LoadPhase::Parsing:
+      return "parsing";
+    case LoadPhase::Building:
+      return "building nodes";
+    case LoadPhase::Connecting:
+      return "connecting";
+    case LoadPhase::Layout:
+      return "layout";
+    default:
+      return "finishing";
+  }
+}
+
+// srrg progress of the background load, drawn over the editor which stays interactive
+void displayLoadOverlay() {
+  if (!manager.isLoading()) {
+    return;
+  }
+  const ImVec2 window_pos  = ImGui::GetWindowPos();
+  const ImVec2 window_size = ImGui::GetWindowSize();
+  ImGui::SetNextWindowPos(window_pos + window_size * 0.5f, ImGuiCond_Always, ImVec2(0.5f, 0.5f));
+  ImGui::SetNextWindowBgAlpha(0.85f);
+  const ImGuiWindowFlags flags = ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoMove |
+                                 ImGuiWindowFlags_AlwaysAutoResize |
+                                 ImGuiWindowFlags_NoSavedSettings;
+  if (ImGui::Begin("load_overlay", nullptr, flags)) {
+    ImGui::Text("Loading %s", config_file.c_str());
+    if (manager.loadPhase() == ConfigurableNodeManager::LoadPhase::Parsing) {
+      // srrg the parser has no progress to report, the bar only tracks building the nodes
+      ImGui::ProgressBar(0.f, ImVec2(300, 0), "parsing, no progress available");
+    } else {
+      ImGui::ProgressBar(manager.loadProgress(),
+                         ImVec2(300, 0),
+                         loadPhaseName(manager.loadPhase()));
+    }
+    if (ImGui::Button("Cancel")) {
+      manager.cancelLoad();
+    }
+  }
+  ImGui::End();
+}
+
+// srrg search panel over names, classes and property values, e.g. "tracker" or "max_iterations=5"
+void displaySearch() {
+  static char query[256]        = "";
+  static std::string last_query = "";
+  static size_t last_revision   = 0;
+  static std::vector<SearchHit> hits;
+  static size_t num_matches = 0;
+  static int current        = -1;
+
+  if (!show_search) {
+    if (!hits.empty()) {
+      hits.clear();
+      last_query = "";
+      manager.setHighlighted({});
+    }
+    return;
+  }
+
+  ImGui::SetNextWindowSize(ImVec2(420, 360), ImGuiCond_FirstUseEver);
+  if (!ImGui::Begin("Search", &show_search)) {
+    ImGui::End();
+    return;
+  }
+  if (ImGui::IsWindowAppearing()) {
+    ImGui::SetKeyboardFocusHere();
+  }
+  const bool enter =
+    ImGui::InputText("##query", query, sizeof(query), ImGuiInputTextFlags_EnterReturnsTrue);
+
+  // srrg queried again only when the text or the index changed, edits update the index
+  const SearchIndex& index = manager.searchIndex();
+  if (last_query != query || last_revision != index.revision()) {
+    SRRG_PROFILE_SCOPE(Search);
+    num_matches   = index.query(query, hits);
+    last_query    = query;
+    last_revision = index.revision();
+    current       = -1;
+    std::vector<ed::NodeId> nodes;
+    nodes.reserve(hits.size());
+    for (const SearchHit& hit : hits) {
+      nodes.push_back(ed::NodeId(hit.document));
+    }
+    manager.setHighlighted(nodes);
+  }
+
+  // srrg enter and the arrows cycle through the hits, best first
+  const int num_hits = hits.size();
+  int focus          = -1;
+  ImGui::SameLine();
+  if (ImGui::ArrowButton("previous", ImGuiDir_Up) && num_hits) {
+    focus = current <= 0 ? num_hits - 1 : current - 1;
+  }
+  ImGui::SameLine();
+  if ((ImGui::ArrowButton("next", ImGuiDir_Down) || enter) && num_hits) {
+    focus = (current + 1) % num_hits;
+  }
+  ImGui::SameLine();
+  ImGui::Text("%zu found", num_matches);
+
+  ImGui::BeginChild("hits");
+  for (int h = 0; h < num_hits; ++h) {
+    const SearchHit& hit                   = hits[h];
+    const std::vector<SearchField>* fields = index.fields(hit.document);
+    if (!fields) {
+      continue;
+    }
+    const std::string& text = (*fields)[hit.field].text;
+
+    ImGui::PushID(h);
+    const float x = ImGui::GetCursorPosX();
+    if (ImGui::Selectable("##hit", current == h)) {
+      focus = h;
+    }
+    ImGui::SameLine(x);
+    // srrg a hit in a class or a property is shown under the node name
+    if (hit.field) {
+      ImGui::TextUnformatted((*fields)[0].text.c_str());
+      ImGui::SameLine();
+    }
+    ImGui::TextUnformatted(text.c_str(), text.c_str() + hit.match_begin);
+    ImGui::SameLine(0, 0);
+    ImGui::TextColored(ImVec4(1.0f, 0.8f, 0.0f, 1.0f),
+                       "%.*s",
+                       static_cast<int>(hit.match_end - hit.match_begin),
+                       text.c_str() + hit.match_begin);
+    ImGui::SameLine(0, 0);
+    ImGui::TextUnformatted(text.c_str() + hit.match_end);
+    // srrg hidden by the lazy mode, focusing it expands the outputs above it
+    if (ConfigurableNodeManager::isHiddenDocument(hit.document)) {
+      ImGui::SameLine();
+      ImGui::TextDisabled("(hidden)");
+    }
+    ImGui::PopID();
+  }
+  ImGui::EndChild();
+  ImGui::End();
+
+  if (focus >= 0) {
+    current = focus;
+    manager.focusDocument(hits[focus].document);
+  }
+}
+
 void displayEditor() {
-  ed::Begin("My Editor", ImVec2(0.0, 0.0f));
+  {
+    SRRG_PROFILE_SCOPE(EditorBegin);
+    ed::Begin("My Editor", ImVec2(0.0, 0.0f));
+  }
 
   if (setup && config_file.length()) {
-    manager.load(config_file);
+    manager.loadAsync(config_file);
     setup = false;
   }
+  manager.updateLoad();
 
-  displayContextMenu();
+  {
+    SRRG_PROFILE_SCOPE(ContextMenu);
+    displayContextMenu();
+  }
 
   manager.showNodes();
   manager.createLink();
   manager.showLinks();
 
-  ed::End();
+  {
+    // srrg merges the node channels into the draw list
+    SRRG_PROFILE_SCOPE(EditorEnd);
+    ed::End();
+  }
+
+  displayLoadOverlay();
 }
 
 const char* srrg2_ine_Application_GetName() {
@@ -291,6 +501,8 @@ const char* srrg2_ine_Application_GetName() {
 void srrg2_ine_Application_Initialize() {
   ed::Config config;
   config.SettingsFile = nullptr;
+  // srrg node positions go to the layout cache next to the config, keyed by configurable
+  manager.configureEditor(config);
 
   g_Context = reinterpret_cast<ed::Detail::EditorContext*>(ed::CreateEditor(&config));
 
@@ -302,6 +514,15 @@ void srrg2_ine_Application_Initialize() {
     &cmd_line, "c", "conf_filename", "generates a config file", "test_config_node.config");
   ArgumentString dl_stub_file(
     &cmd_line, "dlc", "dl-config", "stub where to read/write the stub", "");
+  ArgumentFlag continuous(
+    &cmd_line, "cr", "continuous-redraw", "redraws every frame instead of waiting for events");
+  ArgumentFlag no_layout_cache(
+    &cmd_line, "nlc", "no-layout-cache", "ignores the saved node positions of the config");
+  ArgumentInt lazy_depth(&cmd_line,
+                         "ld",
+                         "lazy-depth",
+                         "levels shown below the roots, the rest is expanded on click (-1: all)",
+                         -1);
   cmd_line.parse();
   if (dl_stub_file.isSet()) {
     std::ifstream is(dl_stub_file.value());
@@ -315,6 +536,9 @@ void srrg2_ine_Application_Initialize() {
   ConfigurableNodeManager::initFactory();
   types       = ConfigurableNodeManager::listTypes();
   config_file = file.value();
+  manager.setLazyDepth(lazy_depth.value());
+  manager.setLayoutCaching(!no_layout_cache.isSet());
+  continuous_redraw = continuous.isSet();
   // // start the shell thread
   // shell_ready=false;
   // shell=new ConfigurableShell(manager);
@@ -323,6 +547,7 @@ void srrg2_ine_Application_Initialize() {
 
 void srrg2_ine_Application_Finalize() {
   ed::SetCurrentEditor(reinterpret_cast<ed::EditorContext*>(g_Context));
+  manager.saveLayoutCache();
   TEST_LOG << "manager clear\n";
   manager.clear();
   TEST_LOG << "final checkout\n";
@@ -335,13 +560,38 @@ void srrg2_ine_Application_Finalize() {
 }
 
 void srrg2_ine_Application_Frame() {
+  SRRG_PROFILE_BEGIN_FRAME();
+  SRRG_PROFILE_SCOPE(Frame);
   ed::SetCurrentEditor(reinterpret_cast<ed::EditorContext*>(g_Context));
   ImGui::PushItemWidth(120.0f);
 
-  displayMenuBar();
+  {
+    SRRG_PROFILE_SCOPE(MenuBar);
+    displayMenuBar();
+  }
   displayEditor();
+  displaySearch();
 
   ImGui::PopItemWidth();
   ed::SetCurrentEditor(nullptr);
+#ifdef SRRG_CONFIG_VISUALIZER_PROFILE
+  if (show_profiler) {
+    FrameProfiler::instance().showOverlay(&show_profiler);
+  }
+#endif
   // ImGui::ShowMetricsWindow();
 }
+
+bool srrg2_ine_Application_WantsRedraw() {
+  // srrg node editor animations (navigation, flow), blinking text cursor, loading or fresh nodes
+  return continuous_redraw || (g_Context && g_Context->HasLiveAnimations()) ||
+         ImGui::IsAnyItemActive() || manager.needsRedraw();
+}
+
+void srrg2_ine_Application_Render() {
+  {
+    SRRG_PROFILE_SCOPE(Render);
+    ImGui::Render();
+  }
+  SRRG_PROFILE_END_FRAME(manager.nodes().size(), manager.links().size());
+}
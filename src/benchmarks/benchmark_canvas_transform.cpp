@@ -0,0 +1,106 @@
+#include "benchmark_utils.h"
+#include <cmath>
+#include <imgui_canvas.h>
+#include <iomanip>
+#include <random>
+#include <srrg_system_utils/parse_command_line.h>
+#include <srrg_system_utils/system_utils.h>
+
+using namespace srrg2_core;
+using ImGuiEx::CanvasTransformKernel;
+
+const char* banner[] = {
+  "measures the kernels moving canvas vertices and clip rectangles to screen space when the",
+  "editor leaves the canvas, on buffers as large as a zoomed out graph produces",
+  "output: one line per buffer size and kernel with the time per transform and the largest",
+  "difference from the scalar kernel",
+  0};
+
+// srrg zoom and origin alternate between two views, as while panning a zoomed out canvas
+template <typename ItemType_, typename TransformType_>
+double timeTransform(std::vector<ItemType_>& items_,
+                     const int& repetitions_,
+                     TransformType_ transform_) {
+  const auto t_start = BenchmarkClock::now();
+  for (int r = 0; r < repetitions_; ++r) {
+    transform_(items_.data(),
+               items_.data() + items_.size(),
+               (r % 2) ? 0.25f : 4.f,
+               (r % 2) ? ImVec2(-30.5f, 12.25f) : ImVec2(122.f, -49.f));
+  }
+  return elapsedMs(t_start) / repetitions_;
+}
+
+int main(int argc, char** argv) {
+  srrgInit(argc, argv, "benchmark_canvas_transform");
+  ParseCommandLine cmd_line(argv, banner);
+  ArgumentInt max_vertices(&cmd_line, "n", "max-vertices", "largest vertex buffer", 10000000);
+  ArgumentInt work(&cmd_line, "w", "work", "vertices transformed per measure", 100000000);
+  cmd_line.parse();
+
+  const CanvasTransformKernel default_kernel = ImGuiEx::GetCanvasTransformKernel();
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<float> coordinate(-1e4f, 1e4f);
+
+  std::cout << "vertices commands kernel vertex_ms clip_rect_ms max_difference" << std::endl;
+  for (size_t num_vertices = 1000; num_vertices <= (size_t) max_vertices.value();
+       num_vertices *= 10) {
+    // srrg the editor issues about one draw command every hundred vertices
+    const size_t num_commands = num_vertices / 100;
+    std::vector<ImDrawVert> vertices(num_vertices);
+    for (ImDrawVert& vertex : vertices) {
+      vertex.pos = ImVec2(coordinate(rng), coordinate(rng));
+    }
+    std::vector<ImDrawCmd> commands(num_commands);
+    for (ImDrawCmd& command : commands) {
+      command.ClipRect =
+        ImVec4(coordinate(rng), coordinate(rng), coordinate(rng), coordinate(rng));
+    }
+    // srrg an even number of runs, every kernel sees the same sequence of views
+    const int repetitions = 2 * std::max<int>(work.value() / (2 * num_vertices), 1);
+
+    std::vector<ImDrawVert> scalar_vertices;
+    std::vector<ImDrawCmd> scalar_commands;
+    for (const CanvasTransformKernel kernel :
+         {CanvasTransformKernel::Scalar, CanvasTransformKernel::SSE2}) {
+      if (!ImGuiEx::IsCanvasTransformKernelSupported(kernel)) {
+        continue;
+      }
+      ImGuiEx::SetCanvasTransformKernel(kernel);
+      std::vector<ImDrawVert> kernel_vertices = vertices;
+      std::vector<ImDrawCmd> kernel_commands  = commands;
+      const double vertex_ms =
+        timeTransform(kernel_vertices, repetitions, ImGuiEx::TransformCanvasVertices);
+      const double clip_rect_ms =
+        timeTransform(kernel_commands, repetitions, ImGuiEx::TransformCanvasClipRects);
+
+      float max_difference = 0;
+      if (kernel == CanvasTransformKernel::Scalar) {
+        scalar_vertices = kernel_vertices;
+        scalar_commands = kernel_commands;
+      } else {
+        for (size_t v = 0; v < num_vertices; ++v) {
+          max_difference =
+            std::max(max_difference,
+                     std::max(std::fabs(kernel_vertices[v].pos.x - scalar_vertices[v].pos.x),
+                              std::fabs(kernel_vertices[v].pos.y - scalar_vertices[v].pos.y)));
+        }
+        for (size_t c = 0; c < num_commands; ++c) {
+          const ImVec4& lhs = kernel_commands[c].ClipRect;
+          const ImVec4& rhs = scalar_commands[c].ClipRect;
+          max_difference    = std::max(
+            max_difference,
+            std::max(std::max(std::fabs(lhs.x - rhs.x), std::fabs(lhs.y - rhs.y)),
+                     std::max(std::fabs(lhs.z - rhs.z), std::fabs(lhs.w - rhs.w))));
+        }
+      }
+
+      std::cout << std::fixed << std::setprecision(4) << num_vertices << " " << num_commands
+                << " " << (kernel == CanvasTransformKernel::SSE2 ? "sse2" : "scalar") << " "
+                << vertex_ms << " " << clip_rect_ms << " " << std::setprecision(9)
+                << max_difference << std::endl;
+    }
+  }
+  ImGuiEx::SetCanvasTransformKernel(default_kernel);
+  return 0;
+}
@@ -0,0 +1,226 @@
+#include "benchmark_utils.h"
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <srrg_system_utils/parse_command_line.h>
+#include <srrg_system_utils/system_utils.h>
+
+using namespace srrg2_core;
+
+const char* banner[] = {
+  "drives the config visualizer library on synthetic graphs, without a window",
+  "shapes: chain, fanout, shared (4 layers of shared children), random (tree),",
+  "diamond (stacked diamonds, 2^(n/3) paths from the top)",
+  "output: a json report with the timings in milliseconds and the memory in kB",
+  0};
+
+struct GraphReport {
+  std::string shape;
+  std::string layout;
+  size_t num_nodes   = 0;
+  int lazy_depth     = -1;
+  size_t num_links   = 0;
+  size_t num_built   = 0;
+  size_t num_moved   = 0;
+  size_t crossings   = 0;
+  float area         = 0;
+  double write_ms    = 0;
+  double load_ms     = 0;
+  double async_ms    = 0;
+  double stall_ms    = 0;
+  double build_ms    = 0;
+  double refresh_ms  = 0;
+  double frame_ms    = 0;
+  double add_ms      = 0;
+  double delete_ms   = 0;
+  double relayout_ms = 0;
+  size_t rss_kb      = 0;
+  size_t peak_rss_kb = 0;
+};
+
+std::vector<std::string> split(const std::string& list_) {
+  std::vector<std::string> tokens;
+  std::stringstream stream(list_);
+  std::string token;
+  while (std::getline(stream, token, ',')) {
+    if (token.length()) {
+      tokens.push_back(token);
+    }
+  }
+  return tokens;
+}
+
+GraphReport run(const std::string& shape_,
+                const size_t& num_nodes_,
+                const int& num_frames_,
+                const int& lazy_depth_,
+                const LayoutEngine::Method& method_,
+                const std::string& config_file_) {
+  // srrg the editor keeps every node it has seen, each graph gets a fresh one
+  HeadlessEditor editor;
+  GraphReport report;
+  report.shape      = shape_;
+  report.num_nodes  = num_nodes_;
+  report.lazy_depth = lazy_depth_;
+  report.layout     = method_ == LayoutEngine::Method::Layered ? "layered" : "subtree";
+
+  // srrg round trip through a config file, as the application does
+  {
+    BenchmarkNodeManager writer;
+    writer.synthesize(shape_, num_nodes_);
+    auto t_start = BenchmarkClock::now();
+    writer.write(config_file_);
+    report.write_ms = elapsedMs(t_start);
+
+    BenchmarkNodeManager reader;
+    reader.setLazyDepth(lazy_depth_);
+    editor.frame([&]() {
+      t_start = BenchmarkClock::now();
+      reader.load(config_file_);
+      report.load_ms = elapsedMs(t_start);
+    });
+    editor.frame([&]() { reader.clear(); });
+
+    // srrg the same load on the worker, stall_ms is the longest frame while it runs
+    BenchmarkNodeManager async_reader;
+    async_reader.setLazyDepth(lazy_depth_);
+    t_start = BenchmarkClock::now();
+    async_reader.loadAsync(config_file_);
+    while (async_reader.isLoading()) {
+      const auto t_frame = BenchmarkClock::now();
+      editor.frame([&]() { async_reader.updateLoad(); });
+      report.stall_ms = std::max(report.stall_ms, elapsedMs(t_frame));
+    }
+    report.async_ms = elapsedMs(t_start);
+    editor.frame([&]() { async_reader.clear(); });
+  }
+
+  BenchmarkNodeManager manager;
+  manager.setLazyDepth(lazy_depth_);
+  manager.layoutEngine().method = method_;
+  std::vector<BenchmarkModulePtr> modules = manager.synthesize(shape_, num_nodes_);
+  editor.frame([&]() {
+    const auto t_start = BenchmarkClock::now();
+    manager._buildConfigNodes();
+    report.build_ms = elapsedMs(t_start);
+  });
+  report.num_links = manager.links().size();
+  report.num_built = manager.nodes().size();
+
+  editor.frame([&]() {
+    const auto t_start = BenchmarkClock::now();
+    manager.refreshView(ImVec2(100, 100));
+    report.refresh_ms = elapsedMs(t_start);
+  });
+  report.crossings = manager.layoutEngine().stats().crossings;
+  report.area      = manager.layoutEngine().stats().area;
+
+  // srrg one frame to settle the node sizes, then the average of the steady frames
+  editor.frame([&]() {
+    manager.showNodes();
+    manager.showLinks();
+  });
+  for (int f = 0; f < num_frames_; ++f) {
+    const auto t_start = BenchmarkClock::now();
+    editor.frame([&]() {
+      manager.showNodes();
+      manager.createLink();
+      manager.showLinks();
+    });
+    report.frame_ms += elapsedMs(t_start);
+  }
+  report.frame_ms /= std::max(num_frames_, 1);
+
+  // srrg a new module attached on top of the first one, then the first one is deleted
+  editor.frame([&]() {
+    BenchmarkModulePtr root =
+      std::dynamic_pointer_cast<BenchmarkModule>(manager.create("BenchmarkModule"));
+    root->param_child.assign(modules.front());
+    const auto t_start = BenchmarkClock::now();
+    manager.addConfig(root, ImVec2(0, 0));
+    report.add_ms = elapsedMs(t_start);
+  });
+  // srrg the children of the deleted module are placed again, the other nodes stay
+  manager.setIncrementalLayout(true);
+  editor.frame([&]() {
+    const auto t_start = BenchmarkClock::now();
+    manager.deleteConfigurable(modules.front());
+    report.delete_ms = elapsedMs(t_start);
+  });
+  editor.frame([&]() {
+    const auto t_start = BenchmarkClock::now();
+    report.num_moved   = manager.relayoutDirty();
+    report.relayout_ms = elapsedMs(t_start);
+  });
+
+  report.rss_kb      = readProcessMemoryKb("VmRSS");
+  report.peak_rss_kb = readProcessMemoryKb("VmHWM");
+  editor.frame([&]() { manager.clear(); });
+  return report;
+}
+
+void writeReport(std::ostream& stream_,
+                 const std::vector<GraphReport>& reports_,
+                 const int& num_frames_) {
+  stream_ << std::fixed << std::setprecision(4);
+  stream_ << "{\n  \"benchmark\": \"config_visualizer\",\n  \"frames\": " << num_frames_
+          << ",\n  \"results\": [";
+  for (size_t i = 0; i < reports_.size(); ++i) {
+    const GraphReport& r = reports_[i];
+    stream_ << (i ? ",\n" : "\n") << "    {\"shape\": \"" << r.shape << "\", \"layout\": \""
+            << r.layout << "\", \"nodes\": " << r.num_nodes << ", \"lazy_depth\": " << r.lazy_depth
+            << ", \"built_nodes\": " << r.num_built << ", \"links\": " << r.num_links
+            << ", \"write_ms\": " << r.write_ms << ", \"load_ms\": " << r.load_ms
+            << ", \"load_async_ms\": " << r.async_ms << ", \"load_stall_ms\": " << r.stall_ms
+            << ", \"build_ms\": " << r.build_ms << ", \"refresh_ms\": " << r.refresh_ms
+            << ", \"crossings\": " << r.crossings << ", \"area\": " << r.area
+            << ", \"frame_ms\": " << r.frame_ms << ", \"add_config_ms\": " << r.add_ms
+            << ", \"delete_ms\": " << r.delete_ms << ", \"relayout_ms\": " << r.relayout_ms
+            << ", \"relayout_moved\": " << r.num_moved << ", \"rss_kb\": " << r.rss_kb
+            << ", \"peak_rss_kb\": " << r.peak_rss_kb << "}";
+  }
+  stream_ << "\n  ]\n}" << std::endl;
+}
+
+int main(int argc, char** argv) {
+  srrgInit(argc, argv, "benchmark_config_visualizer");
+  ParseCommandLine cmd_line(argv, banner);
+  ArgumentString shapes(
+    &cmd_line, "s", "shapes", "comma separated graph shapes", "chain,fanout,shared,diamond");
+  ArgumentInt min_nodes(&cmd_line, "m", "min-nodes", "smallest graph to generate", 10);
+  ArgumentInt max_nodes(&cmd_line, "n", "max-nodes", "largest graph to generate", 10000);
+  ArgumentInt num_frames(&cmd_line, "f", "frames", "frames averaged per graph", 10);
+  ArgumentInt lazy_depth(
+    &cmd_line, "l", "lazy-depth", "levels built below the roots, -1 builds every node", -1);
+  ArgumentFlag subtree_layout(
+    &cmd_line, "t", "subtree-layout", "stacks the subtrees instead of minimizing the crossings");
+  ArgumentString config_file(&cmd_line,
+                             "c",
+                             "config",
+                             "scratch file used for the load round trip",
+                             "/tmp/benchmark_config_visualizer.conf");
+  ArgumentString output_file(&cmd_line, "o", "output", "report file, stdout if empty", "");
+  cmd_line.parse();
+
+  const LayoutEngine::Method method =
+    subtree_layout.isSet() ? LayoutEngine::Method::Subtree : LayoutEngine::Method::Layered;
+  std::vector<GraphReport> reports;
+  for (const std::string& shape : split(shapes.value())) {
+    for (size_t num_nodes = std::max(min_nodes.value(), 2);
+         num_nodes <= (size_t) max_nodes.value();
+         num_nodes *= 10) {
+      std::cerr << "benchmark_config_visualizer|shape [ " << shape << " ] nodes [ " << num_nodes
+                << " ]" << std::endl;
+      reports.push_back(run(
+        shape, num_nodes, num_frames.value(), lazy_depth.value(), method, config_file.value()));
+    }
+  }
+
+  if (output_file.value().empty()) {
+    writeReport(std::cout, reports, num_frames.value());
+  } else {
+    std::ofstream stream(output_file.value());
+    writeReport(stream, reports, num_frames.value());
+  }
+  return 0;
+}
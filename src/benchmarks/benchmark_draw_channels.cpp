@@ -0,0 +1,76 @@
+#include "benchmark_utils.h"
+#include <iomanip>
+#include <srrg_system_utils/parse_command_line.h>
+#include <srrg_system_utils/system_utils.h>
+
+using namespace srrg2_core;
+namespace ed = ax::NodeEditor;
+
+const char* banner[] = {
+  "measures the draw data produced by the editor with five draw channels per node and with the",
+  "regular nodes sharing one set of layers (Config::SharedNodeChannels)",
+  "nodes with one input and one output pin fill the screen on a grid, each linked to the next",
+  "output: one line per graph and mode with the draw commands, indices and vertices after the",
+  "channel merge and the average time per frame",
+  0};
+
+// srrg a screen worth of nodes is drawn, the others are submitted and clipped
+void submitGrid(const size_t& num_nodes_, const bool& place_) {
+  for (size_t n = 0; n < num_nodes_; ++n) {
+    ed::BeginNode(n + 1);
+    if (place_) {
+      ed::SetNodePosition(n + 1, ImVec2(140.f * (n % 100), 80.f * (n / 100)));
+    }
+    ImGui::TextUnformatted("node");
+    ed::BeginPin(2 * n + 1, ed::PinKind::Input);
+    ImGui::TextUnformatted("in");
+    ed::EndPin();
+    ImGui::SameLine();
+    ed::BeginPin(2 * n + 2, ed::PinKind::Output);
+    ImGui::TextUnformatted("out");
+    ed::EndPin();
+    ed::EndNode();
+  }
+  for (size_t n = 1; n < num_nodes_; ++n) {
+    ed::Link(n, 2 * n, 2 * n + 1);
+  }
+}
+
+int main(int argc, char** argv) {
+  srrgInit(argc, argv, "benchmark_draw_channels");
+  ParseCommandLine cmd_line(argv, banner);
+  ArgumentInt max_nodes(&cmd_line, "n", "max-nodes", "largest graph to submit", 10000);
+  ArgumentInt num_frames(&cmd_line, "f", "frames", "frames averaged per graph", 20);
+  cmd_line.parse();
+
+  std::cout << "nodes mode draw_cmds indices vertices ms_per_frame" << std::endl;
+  for (size_t num_nodes = 100; num_nodes <= (size_t) max_nodes.value(); num_nodes *= 10) {
+    for (const bool shared : {false, true}) {
+      // srrg the editor keeps every node it has seen, each graph gets a fresh one
+      HeadlessEditor editor(ImVec2(1920, 1080), shared);
+      editor.frame([&]() { submitGrid(num_nodes, true); });
+
+      double total_ms = 0;
+      for (int f = 0; f < num_frames.value(); ++f) {
+        const auto t_start = BenchmarkClock::now();
+        editor.frame([&]() { submitGrid(num_nodes, false); });
+        total_ms += elapsedMs(t_start);
+      }
+
+      // srrg draw data of the last frame, the node channels are merged into the window list
+      size_t num_cmds = 0, num_indices = 0, num_vertices = 0;
+      const ImDrawData* draw_data = ImGui::GetDrawData();
+      for (int l = 0; draw_data && l < draw_data->CmdListsCount; ++l) {
+        const ImDrawList* draw_list = draw_data->CmdLists[l];
+        num_cmds += draw_list->CmdBuffer.Size;
+        num_indices += draw_list->IdxBuffer.Size;
+        num_vertices += draw_list->VtxBuffer.Size;
+      }
+
+      std::cout << std::fixed << std::setprecision(4) << num_nodes << " "
+                << (shared ? "shared" : "per_node") << " " << num_cmds << " " << num_indices << " "
+                << num_vertices << " " << total_ms / std::max(num_frames.value(), 1) << std::endl;
+    }
+  }
+  return 0;
+}
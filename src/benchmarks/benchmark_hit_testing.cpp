@@ -0,0 +1,55 @@
+#include "benchmark_utils.h"
+#include <iomanip>
+#include <srrg_system_utils/parse_command_line.h>
+#include <srrg_system_utils/system_utils.h>
+
+using namespace srrg2_core;
+
+const char* banner[] = {
+  "measures the per frame cost of the editor hit-testing on random graphs: with the mouse",
+  "outside the canvas, hovering the background (link lookup) and dragging a selection",
+  "rectangle (node lookup)",
+  "output: one line per graph with the average time per frame",
+  0};
+
+int main(int argc, char** argv) {
+  srrgInit(argc, argv, "benchmark_hit_testing");
+  ParseCommandLine cmd_line(argv, banner);
+  ArgumentInt max_nodes(&cmd_line, "n", "max-nodes", "largest graph to generate", 100000);
+  ArgumentInt num_frames(&cmd_line, "f", "frames", "frames averaged per measure", 20);
+  cmd_line.parse();
+
+  std::cout << "nodes links idle_ms_per_frame hover_ms_per_frame select_ms_per_frame" << std::endl;
+  for (size_t num_nodes = 100; num_nodes <= (size_t) max_nodes.value(); num_nodes *= 10) {
+    BenchmarkGraph graph;
+    graph.build("random", num_nodes);
+    ImGuiIO& io = ImGui::GetIO();
+
+    auto measure = [&](const ImVec2& mouse_from_, const ImVec2& mouse_to_, const bool& down_) {
+      io.MousePos     = mouse_from_;
+      io.MouseDown[0] = down_;
+      graph.show();
+      double total_ms = 0;
+      for (int f = 0; f < num_frames.value(); ++f) {
+        // srrg the mouse moves every frame, so the hovered and selected objects are searched again
+        io.MousePos = (f % 2) ? mouse_from_ : mouse_to_;
+        const auto t_start = BenchmarkClock::now();
+        graph.show();
+        total_ms += elapsedMs(t_start);
+      }
+      io.MouseDown[0] = false;
+      graph.show();
+      return total_ms / std::max(num_frames.value(), 1);
+    };
+
+    // srrg the layout starts at (100, 100), the top left corner of the canvas is background
+    const double idle_ms   = measure(ImVec2(-100, -100), ImVec2(-110, -100), false);
+    const double hover_ms  = measure(ImVec2(40, 40), ImVec2(50, 40), false);
+    const double select_ms = measure(ImVec2(40, 40), ImVec2(1800, 1000), true);
+
+    std::cout << std::fixed << std::setprecision(4) << num_nodes << " "
+              << graph.manager.links().size() << " " << idle_ms << " " << hover_ms << " "
+              << select_ms << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,116 @@
+#include "benchmark_utils.h"
+#include <crude_json.h>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <srrg_system_utils/parse_command_line.h>
+#include <srrg_system_utils/system_utils.h>
+
+using namespace srrg2_core;
+namespace json = crude_json;
+
+const char* banner[] = {
+  "measures crude_json parsing and writing generated documents shaped as editor settings and",
+  "as graph exports, written to a file and parsed back from it",
+  "output: one line per document with its size, the parse throughput into values and into an",
+  "arena document, the dump throughput and whether the parsed values dump back to the same text",
+  "and the document has all the nodes",
+  0};
+
+// srrg node positions, the selection and the view, as the editor saves them
+json::value makeSettings(const size_t& num_nodes_) {
+  json::value result;
+  json::value& nodes = result["nodes"];
+  for (size_t n = 0; n < num_nodes_; ++n) {
+    json::value& location = nodes["node:" + std::to_string(n + 1)]["location"];
+    location["x"]         = 140.0 * (n % 100) + 0.5 * (n % 7);
+    location["y"]         = 80.0 * (n / 100);
+  }
+  json::value& selection = result["selection"];
+  for (size_t n = 0; n < num_nodes_; n += 97) {
+    selection.push_back("node:" + std::to_string(n + 1));
+  }
+  result["view"]["scroll"]["x"] = -1250.25;
+  result["view"]["scroll"]["y"] = 310.0;
+  result["view"]["zoom"]        = 0.35;
+  return result;
+}
+
+// srrg configurables with their properties and connections, as a graph export would carry
+json::value makeGraph(const size_t& num_nodes_) {
+  json::value result;
+  json::value& nodes = result["nodes"];
+  for (size_t n = 0; n < num_nodes_; ++n) {
+    json::value node;
+    node["name"]                         = "module_" + std::to_string(n);
+    node["class"]                        = "BenchmarkModule";
+    node["properties"]["gain"]           = 0.5 + 1e-3 * n;
+    node["properties"]["enabled"]        = (n % 3) != 0;
+    node["properties"]["max_iterations"] = static_cast<double>(n % 50);
+    node["properties"]["topic"]          = "/benchmark/\"quoted\"/" + std::to_string(n);
+    json::value& children                = node["children"];
+    children                             = json::value(json::type_t::array);
+    for (size_t c = 1; c <= 3 && n * 3 + c < num_nodes_; ++c) {
+      children.push_back(static_cast<double>(n * 3 + c));
+    }
+    nodes.push_back(std::move(node));
+  }
+  return result;
+}
+
+int main(int argc, char** argv) {
+  srrgInit(argc, argv, "benchmark_json");
+  ParseCommandLine cmd_line(argv, banner);
+  ArgumentInt max_nodes(&cmd_line, "n", "max-nodes", "largest document to generate", 100000);
+  ArgumentInt repetitions(&cmd_line, "r", "repetitions", "runs averaged per measure", 5);
+  ArgumentString json_file(
+    &cmd_line, "j", "json", "file the documents go through, removed at the end", "benchmark.json");
+  cmd_line.parse();
+
+  const int num_runs = std::max(repetitions.value(), 1);
+  std::cout << "nodes document bytes parse_mb_s document_mb_s dump_mb_s round_trip" << std::endl;
+  for (size_t num_nodes = 1000; num_nodes <= (size_t) max_nodes.value(); num_nodes *= 10) {
+    for (const std::string document : {"settings", "graph"}) {
+      const json::value generated =
+        document == "settings" ? makeSettings(num_nodes) : makeGraph(num_nodes);
+
+      std::string text;
+      auto t_start = BenchmarkClock::now();
+      for (int r = 0; r < num_runs; ++r) {
+        text.clear();
+        generated.dump(text);
+      }
+      const double dump_ms = elapsedMs(t_start) / num_runs;
+
+      std::ofstream(json_file.value()) << text;
+      std::stringstream file_content;
+      file_content << std::ifstream(json_file.value()).rdbuf();
+      const std::string read = file_content.str();
+
+      json::value parsed;
+      t_start = BenchmarkClock::now();
+      for (int r = 0; r < num_runs; ++r) {
+        parsed = json::value::parse(read);
+      }
+      const double parse_ms = elapsedMs(t_start) / num_runs;
+
+      // srrg reused across runs, as a reader of many files would
+      json::document parsed_document;
+      t_start = BenchmarkClock::now();
+      for (int r = 0; r < num_runs; ++r) {
+        parsed_document.parse(read);
+      }
+      const double document_ms = elapsedMs(t_start) / num_runs;
+      const bool document_ok   = parsed_document.root()["nodes"].size() == num_nodes;
+
+      const double mb = read.size() / 1e6;
+      std::cout << std::fixed << std::setprecision(2) << num_nodes << " " << document << " "
+                << read.size() << " " << mb / (parse_ms * 1e-3) << " "
+                << mb / (document_ms * 1e-3) << " " << mb / (dump_ms * 1e-3) << " "
+                << (parsed.dump() == text && document_ok ? "ok" : "mismatch") << std::endl;
+    }
+  }
+  std::remove(json_file.value().c_str());
+  return 0;
+}
@@ -0,0 +1,184 @@
+#include "srrg_config_visualizer/layout_engine.h"
+#include "srrg_config_visualizer/layout_graph.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <srrg_data_structures/matrix.h>
+#include <srrg_system_utils/parse_command_line.h>
+#include <srrg_system_utils/system_utils.h>
+
+using namespace srrg2_core;
+
+const char* banner[] = {"compares the sparse node layering against the dense source peeling",
+                        "and times the subtree and the layered placement, with their crossings",
+                        "output: one line per graph with timings in milliseconds",
+                        0};
+
+// srrg dense recursive source peeling, as previously done by ConfigurableNodeManager
+void legacyLevels(const Matrix_<int>& matrix_,
+                  const std::vector<size_t>& bookkeeping_,
+                  int level_,
+                  std::vector<int>& levels_) {
+  std::vector<size_t> sources_to_delete;
+  for (size_t c = 0; c < matrix_.cols(); ++c) {
+    int c_sum = 0;
+    for (size_t r = 0; r < matrix_.rows(); ++r) {
+      c_sum += matrix_(r, c);
+    }
+    if (c_sum == 0) {
+      levels_[bookkeeping_[c]] = level_;
+      sources_to_delete.push_back(c);
+    }
+  }
+  size_t submatrix_size = matrix_.rows() - sources_to_delete.size();
+  if (!submatrix_size) {
+    return;
+  }
+  std::vector<size_t> bookkeeping;
+  for (size_t c = 0; c < bookkeeping_.size(); ++c) {
+    if (std::find(sources_to_delete.begin(), sources_to_delete.end(), c) ==
+        sources_to_delete.end()) {
+      bookkeeping.push_back(bookkeeping_[c]);
+    }
+  }
+  if (submatrix_size < 2) {
+    levels_[bookkeeping.front()] = level_ + 1;
+    return;
+  }
+  Matrix_<int> other_matrix(submatrix_size, submatrix_size);
+  int k = 0;
+  for (size_t r = 0; r < matrix_.rows(); ++r) {
+    for (size_t c = 0; c < matrix_.cols(); ++c) {
+      bool add_to_new_matrix = false;
+      for (size_t i = 0; i < sources_to_delete.size(); ++i) {
+        const size_t& idx_to_delete = sources_to_delete[i];
+        if (r == idx_to_delete || c == idx_to_delete) {
+          add_to_new_matrix = false;
+          break;
+        } else {
+          add_to_new_matrix = true;
+        }
+      }
+      if (add_to_new_matrix) {
+        other_matrix.data()[k++] = matrix_(r, c);
+      }
+    }
+  }
+  legacyLevels(other_matrix, bookkeeping, level_ + 1, levels_);
+}
+
+void makeGraph(const std::string& shape_, const size_t& num_nodes_, LayoutGraph& graph_) {
+  std::mt19937 rng(num_nodes_);
+  graph_.clear();
+  graph_.resize(num_nodes_);
+  if (shape_ == "chain") {
+    for (size_t n = 1; n < num_nodes_; ++n) {
+      graph_.addEdge(n - 1, n);
+    }
+  } else if (shape_ == "fanout") {
+    for (size_t n = 1; n < num_nodes_; ++n) {
+      graph_.addEdge(0, n);
+    }
+  } else if (shape_ == "shared") {
+    // srrg layers of 32 nodes, each one pointing to 3 random children of the next layer
+    const size_t width = 32;
+    for (size_t n = width; n < num_nodes_; ++n) {
+      const size_t layer_begin = (n / width - 1) * width;
+      for (size_t k = 0; k < 3; ++k) {
+        graph_.addEdge(layer_begin + rng() % width, n);
+      }
+    }
+  } else if (shape_ == "diamond") {
+    // srrg stacked diamonds, a traversal per path would visit 2^(n/3) nodes
+    for (size_t n = 1; n < num_nodes_; ++n) {
+      if (n % 3) {
+        graph_.addEdge((n - 1) / 3 * 3, n);
+      } else {
+        graph_.addEdge(n - 2, n);
+        graph_.addEdge(n - 1, n);
+      }
+    }
+  } else {
+    // srrg random dag, edges always go towards higher indices
+    for (size_t n = 1; n < num_nodes_; ++n) {
+      const size_t num_parents = 1 + rng() % 3;
+      for (size_t k = 0; k < num_parents; ++k) {
+        graph_.addEdge(rng() % n, n);
+      }
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  srrgInit(argc, argv, "benchmark_layering");
+  ParseCommandLine cmd_line(argv, banner);
+  ArgumentInt max_nodes(&cmd_line, "n", "max-nodes", "largest graph to generate", 100000);
+  ArgumentInt legacy_max_nodes(
+    &cmd_line, "l", "legacy-max-nodes", "largest graph fed to the dense peeling", 1000);
+  cmd_line.parse();
+
+  using Clock = std::chrono::steady_clock;
+  std::cout << "shape nodes edges levels sparse_ms subtree_ms subtree_crossings layered_ms "
+               "layered_crossings dense_ms dense_bytes match"
+            << std::endl;
+  for (const std::string shape : {"chain", "fanout", "shared", "diamond", "random"}) {
+    for (size_t num_nodes = 10; num_nodes <= (size_t) max_nodes.value(); num_nodes *= 10) {
+      LayoutGraph graph;
+      makeGraph(shape, num_nodes, graph);
+
+      auto t_start                  = Clock::now();
+      const std::vector<int> levels = computeLevels(graph);
+      const double sparse_ms =
+        std::chrono::duration<double, std::milli>(Clock::now() - t_start).count();
+      const int num_levels = 1 + *std::max_element(levels.begin(), levels.end());
+
+      LayoutEngine engine;
+      const std::vector<LayoutVec2> sizes(num_nodes, LayoutVec2(200, 100));
+      const std::vector<std::string> keys(num_nodes);
+      std::vector<LayoutVec2> positions;
+      double layout_ms[2];
+      size_t crossings[2];
+      for (const LayoutEngine::Method method :
+           {LayoutEngine::Method::Subtree, LayoutEngine::Method::Layered}) {
+        const size_t m = method == LayoutEngine::Method::Layered;
+        engine.method  = method;
+        t_start        = Clock::now();
+        engine.compute(graph, sizes, keys, LayoutVec2(100, 100), positions);
+        layout_ms[m] = std::chrono::duration<double, std::milli>(Clock::now() - t_start).count();
+        crossings[m] = engine.stats().crossings;
+      }
+
+      std::cout << std::fixed << std::setprecision(3) << shape << " " << num_nodes << " "
+                << graph.numEdges() << " " << num_levels << " " << sparse_ms << " " << layout_ms[0]
+                << " " << crossings[0] << " " << layout_ms[1] << " " << crossings[1] << " ";
+      if (num_nodes > (size_t) legacy_max_nodes.value()) {
+        std::cout << "- - -" << std::endl;
+        continue;
+      }
+
+      Matrix_<int> matrix(num_nodes, num_nodes);
+      for (size_t r = 0; r < num_nodes; ++r) {
+        for (size_t c = 0; c < num_nodes; ++c) {
+          matrix(r, c) = 0;
+        }
+        for (const size_t& c : graph.children(r)) {
+          matrix(r, c) = 1;
+        }
+      }
+      std::vector<size_t> bookkeeping(num_nodes);
+      for (size_t i = 0; i < num_nodes; ++i) {
+        bookkeeping[i] = i;
+      }
+      std::vector<int> legacy_levels(num_nodes, -1);
+      t_start = Clock::now();
+      legacyLevels(matrix, bookkeeping, 0, legacy_levels);
+      const double dense_ms =
+        std::chrono::duration<double, std::milli>(Clock::now() - t_start).count();
+      std::cout << dense_ms << " " << num_nodes * num_nodes * sizeof(int) << " "
+                << (legacy_levels == levels ? "yes" : "no") << std::endl;
+    }
+  }
+  return 0;
+}
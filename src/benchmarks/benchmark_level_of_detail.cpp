@@ -0,0 +1,90 @@
+#include "benchmark_utils.h"
+#include <iomanip>
+#include <srrg_system_utils/parse_command_line.h>
+#include <srrg_system_utils/system_utils.h>
+
+using namespace srrg2_core;
+namespace ed = ax::NodeEditor;
+
+const char* banner[] = {
+  "measures the per frame cost of the nodes at decreasing zoom, with every node drawn in full and",
+  "with the level of detail (ConfigurableNodeManager::setLevelOfDetail)",
+  "output: one line per graph, zoom and mode with the level used, the vertices drawn, the average",
+  "time per frame and whether all the node sizes match the ones of the full draw at zoom 1",
+  0};
+
+const char* levelName(const LevelOfDetail& level_) {
+  switch (level_) {
+    case LevelOfDetail::Full:
+      return "full";
+    case LevelOfDetail::Pins:
+      return "pins";
+    case LevelOfDetail::Box:
+      return "box";
+  }
+  return "";
+}
+
+int main(int argc, char** argv) {
+  srrgInit(argc, argv, "benchmark_level_of_detail");
+  ParseCommandLine cmd_line(argv, banner);
+  ArgumentInt max_nodes(&cmd_line, "n", "max-nodes", "largest graph to generate", 1000);
+  ArgumentInt num_frames(&cmd_line, "f", "frames", "frames averaged per measure", 20);
+  cmd_line.parse();
+
+  std::cout << "nodes zoom mode level vertices ms_per_frame sizes" << std::endl;
+  for (size_t num_nodes = 10; num_nodes <= (size_t) max_nodes.value(); num_nodes *= 10) {
+    for (const bool level_of_detail : {false, true}) {
+      BenchmarkGraph graph;
+      BenchmarkNodeManager& manager = graph.manager;
+      manager.setLevelOfDetail(level_of_detail);
+      graph.build("random", num_nodes);
+      graph.show(false);
+
+      // srrg sizes of the full draw, the simplified levels must keep them
+      std::map<std::string, ImVec2> full_sizes;
+      for (const auto& entry : manager.nodes()) {
+        full_sizes[entry.second->layoutKey()] = ed::GetNodeSize(entry.second->ID());
+      }
+
+      for (const float zoom : {1.f, 0.5f, 0.25f, 0.1f}) {
+        // srrg the view shrinks around the layout origin, the navigation ends on the next frame
+        const ImVec2& display = ImGui::GetIO().DisplaySize;
+        const ImVec2 view_size(display.x / zoom, display.y / zoom);
+        graph.editor.frame([&]() {
+          auto context = reinterpret_cast<ed::Detail::EditorContext*>(ed::GetCurrentEditor());
+          context->NavigateTo(ImRect(ImVec2(0, 0), view_size), true, 0.f);
+          manager.showNodes();
+        });
+        graph.show(false);
+
+        double total_ms = 0;
+        for (int f = 0; f < num_frames.value(); ++f) {
+          const auto t_start = BenchmarkClock::now();
+          graph.show();
+          total_ms += elapsedMs(t_start);
+        }
+
+        size_t num_vertices         = 0;
+        const ImDrawData* draw_data = ImGui::GetDrawData();
+        for (int l = 0; draw_data && l < draw_data->CmdListsCount; ++l) {
+          num_vertices += draw_data->CmdLists[l]->VtxBuffer.Size;
+        }
+
+        bool same_sizes = true;
+        for (const auto& entry : manager.nodes()) {
+          const ImVec2 size    = ed::GetNodeSize(entry.second->ID());
+          const ImVec2& before = full_sizes[entry.second->layoutKey()];
+          same_sizes           = same_sizes && size.x == before.x && size.y == before.y;
+        }
+
+        std::cout << std::fixed << std::setprecision(4) << num_nodes << " "
+                  << 1.f / ed::GetCurrentZoom() << " " << (level_of_detail ? "lod" : "full") << " "
+                  << levelName(manager.levelOfDetail()) << " " << num_vertices << " "
+                  << total_ms / std::max(num_frames.value(), 1) << " "
+                  << (same_sizes ? "stable" : "changed") << std::endl;
+      }
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,56 @@
+#include "benchmark_utils.h"
+#include <iomanip>
+#include <srrg_system_utils/parse_command_line.h>
+#include <srrg_system_utils/system_utils.h>
+
+using namespace srrg2_core;
+
+const char* banner[] = {"measures the per frame cost of submitting the links to the editor",
+                        "output: one line per graph with the average time per frame",
+                        0};
+
+int main(int argc, char** argv) {
+  srrgInit(argc, argv, "benchmark_links");
+  ParseCommandLine cmd_line(argv, banner);
+  ArgumentInt max_nodes(&cmd_line, "n", "max-nodes", "largest graph to generate", 10000);
+  ArgumentInt num_frames(&cmd_line, "f", "frames", "frames averaged per measure", 20);
+  cmd_line.parse();
+
+  std::cout << "nodes links resolved_ms_per_frame by_name_ms_per_frame" << std::endl;
+  for (size_t num_nodes = 100; num_nodes <= (size_t) max_nodes.value(); num_nodes *= 10) {
+    BenchmarkGraph graph;
+    BenchmarkNodeManager& manager = graph.manager;
+    graph.build("random", num_nodes, false);
+    graph.show();
+
+    double resolved_ms = 0, by_name_ms = 0;
+    for (int f = 0; f < num_frames.value(); ++f) {
+      graph.editor.frame([&]() {
+        manager.showNodes();
+        const auto t_start = BenchmarkClock::now();
+        manager.showLinks();
+        resolved_ms += elapsedMs(t_start);
+      });
+
+      // srrg previous submission, matching the parameter names of the parent pins every frame
+      graph.editor.frame([&]() {
+        manager.showNodes();
+        const auto t_start = BenchmarkClock::now();
+        for (auto l : manager.links()) {
+          for (auto op : l->parent()->outputPins()) {
+            if (op->paramName() == l->paramName()) {
+              ax::NodeEditor::Link(l->ID(), op->ID(), l->child->inputPin()->ID());
+              break;
+            }
+          }
+        }
+        by_name_ms += elapsedMs(t_start);
+      });
+    }
+
+    std::cout << std::fixed << std::setprecision(4) << num_nodes << " " << manager.links().size()
+              << " " << resolved_ms / num_frames.value() << " "
+              << by_name_ms / num_frames.value() << std::endl;
+  }
+  return 0;
+}
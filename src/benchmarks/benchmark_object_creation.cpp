@@ -0,0 +1,68 @@
+#include "benchmark_utils.h"
+#include <iomanip>
+#include <srrg_system_utils/parse_command_line.h>
+#include <srrg_system_utils/system_utils.h>
+
+using namespace srrg2_core;
+namespace ed = ax::NodeEditor;
+
+const char* banner[] = {
+  "measures how the editor copes with many objects appearing at once, as on a config load:",
+  "nodes with one input and three output pins, each chained to the next by a link",
+  "output: one line per graph with the first frame (creation) and the average steady frame",
+  0};
+
+// srrg submits the whole graph through the editor api, ids are unique per object kind
+void submitGraph(const size_t& num_nodes_, const bool& place_) {
+  for (size_t n = 0; n < num_nodes_; ++n) {
+    const size_t pin_id = 4 * n + 1;
+    ed::BeginNode(n + 1);
+    if (place_) {
+      ed::SetNodePosition(n + 1, ImVec2(300.f * (n % 100), 200.f * (n / 100)));
+    }
+    ImGui::TextUnformatted("node");
+    ed::BeginPin(pin_id, ed::PinKind::Input);
+    ImGui::TextUnformatted("in");
+    ed::EndPin();
+    for (size_t p = 1; p < 4; ++p) {
+      ed::BeginPin(pin_id + p, ed::PinKind::Output);
+      ImGui::TextUnformatted("out");
+      ed::EndPin();
+    }
+    ed::EndNode();
+  }
+  for (size_t n = 1; n < num_nodes_; ++n) {
+    ed::Link(n, 4 * (n - 1) + 2, 4 * n + 1);
+  }
+}
+
+int main(int argc, char** argv) {
+  srrgInit(argc, argv, "benchmark_object_creation");
+  ParseCommandLine cmd_line(argv, banner);
+  ArgumentInt max_pins(&cmd_line, "n", "max-pins", "largest number of pins to create", 100000);
+  ArgumentInt num_frames(&cmd_line, "f", "frames", "steady frames averaged per graph", 10);
+  cmd_line.parse();
+
+  std::cout << "pins nodes links create_ms frame_ms" << std::endl;
+  for (size_t num_pins = 1000; num_pins <= (size_t) max_pins.value(); num_pins *= 10) {
+    // srrg the editor keeps every object it has seen, each graph gets a fresh one
+    HeadlessEditor editor;
+    const size_t num_nodes = num_pins / 4;
+
+    auto t_start = BenchmarkClock::now();
+    editor.frame([&]() { submitGraph(num_nodes, true); });
+    const double create_ms = elapsedMs(t_start);
+
+    double frame_ms = 0;
+    for (int f = 0; f < num_frames.value(); ++f) {
+      t_start = BenchmarkClock::now();
+      editor.frame([&]() { submitGraph(num_nodes, false); });
+      frame_ms += elapsedMs(t_start);
+    }
+
+    std::cout << std::fixed << std::setprecision(4) << 4 * num_nodes << " " << num_nodes << " "
+              << num_nodes - 1 << " " << create_ms << " "
+              << frame_ms / std::max(num_frames.value(), 1) << std::endl;
+  }
+  return 0;
+}
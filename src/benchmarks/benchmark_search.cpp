@@ -0,0 +1,69 @@
+#include "benchmark_utils.h"
+#include <iomanip>
+#include <srrg_system_utils/parse_command_line.h>
+#include <srrg_system_utils/system_utils.h>
+
+using namespace srrg2_core;
+
+const char* banner[] = {
+  "measures the search index over the node names, classes and property values: the time to",
+  "index a whole graph, to reindex one edited node and to answer a few typical queries",
+  "output: one line per graph and query with the words indexed, the build and update times, the",
+  "documents matching and the average time per query",
+  0};
+
+int main(int argc, char** argv) {
+  srrgInit(argc, argv, "benchmark_search");
+  ParseCommandLine cmd_line(argv, banner);
+  ArgumentInt max_nodes(&cmd_line, "n", "max-nodes", "largest graph to generate", 10000);
+  ArgumentInt num_queries(&cmd_line, "q", "queries", "repetitions averaged per query", 100);
+  cmd_line.parse();
+
+  const std::vector<std::string> queries = {
+    "module_42", "max_iterations = 5", "gain=0.5", "topic=/benchmark", "benchmark module", "m"};
+
+  std::cout << "nodes words build_ms update_ms query matches ms_per_query" << std::endl;
+  for (size_t num_nodes = 100; num_nodes <= (size_t) max_nodes.value(); num_nodes *= 10) {
+    BenchmarkGraph graph;
+    BenchmarkNodeManager& manager           = graph.manager;
+    std::vector<BenchmarkModulePtr> modules = manager.synthesize("random", num_nodes);
+    for (size_t i = 0; i < modules.size(); ++i) {
+      modules[i]->param_max_iterations.setValue(i % 20);
+    }
+    graph.editor.frame([&]() { manager._buildConfigNodes(); });
+
+    // srrg the manager index is filled while building, a fresh one measures the whole graph
+    SearchIndex index;
+    auto t_start = BenchmarkClock::now();
+    for (const auto& entry : manager.nodes()) {
+      index.set(entry.second->ID().Get(), entry.second->searchFields());
+    }
+    const double build_ms = elapsedMs(t_start);
+
+    // srrg an edit reindexes the node it touched
+    const size_t num_updates = std::min<size_t>(1000, modules.size());
+    auto n_it                = manager.nodes().begin();
+    t_start                  = BenchmarkClock::now();
+    for (size_t u = 0; u < num_updates; ++u, ++n_it) {
+      BenchmarkModule* module = dynamic_cast<BenchmarkModule*>(n_it->first.get());
+      module->param_max_iterations.setValue(module->param_max_iterations.value() + 1);
+      index.set(n_it->second->ID().Get(), n_it->second->searchFields());
+    }
+    const double update_ms = elapsedMs(t_start) / num_updates;
+
+    std::vector<SearchHit> hits;
+    for (const std::string& query : queries) {
+      size_t num_matches = 0;
+      t_start            = BenchmarkClock::now();
+      for (int q = 0; q < num_queries.value(); ++q) {
+        num_matches = index.query(query, hits);
+      }
+      const double query_ms = elapsedMs(t_start) / std::max(num_queries.value(), 1);
+
+      std::cout << std::fixed << std::setprecision(4) << num_nodes << " " << index.numWords()
+                << " " << build_ms << " " << update_ms << " \"" << query << "\" " << num_matches
+                << " " << query_ms << std::endl;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,86 @@
+#include "benchmark_utils.h"
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <srrg_system_utils/parse_command_line.h>
+#include <srrg_system_utils/system_utils.h>
+
+using namespace srrg2_core;
+namespace ed = ax::NodeEditor;
+
+const char* banner[] = {
+  "measures the editor saving its settings to a file when one node is moved per frame, as",
+  "during a drag, rewriting the whole file and appending the change to a journal",
+  "(Config::SettingsJournal)",
+  "output: one line per graph and mode with the average frame time and the bytes written",
+  0};
+
+// srrg a grid of nodes, moved_ is placed on a new spot before being submitted
+void submitGrid(const size_t& num_nodes_, const size_t& moved_, const float& offset_) {
+  for (size_t n = 0; n < num_nodes_; ++n) {
+    if (n == moved_) {
+      ed::SetNodePosition(n + 1, ImVec2(140.f * (n % 100) + offset_, 80.f * (n / 100)));
+    }
+    ed::BeginNode(n + 1);
+    ImGui::TextUnformatted("node");
+    ed::EndNode();
+  }
+}
+
+size_t fileSize(const std::string& path_) {
+  std::ifstream file(path_, std::ios_base::ate | std::ios_base::binary);
+  return file ? static_cast<size_t>(file.tellg()) : 0;
+}
+
+int main(int argc, char** argv) {
+  srrgInit(argc, argv, "benchmark_settings_journal");
+  ParseCommandLine cmd_line(argv, banner);
+  ArgumentInt max_nodes(&cmd_line, "n", "max-nodes", "largest graph to submit", 10000);
+  ArgumentInt num_frames(&cmd_line, "f", "frames", "frames averaged per graph", 100);
+  ArgumentString settings_file(
+    &cmd_line, "s", "settings", "settings file, removed at the end", "benchmark_settings.json");
+  cmd_line.parse();
+
+  const std::string settings_path = settings_file.value();
+  const std::string journal_path  = settings_path + ".journal";
+  const size_t num_frames_value   = std::max(num_frames.value(), 1);
+
+  std::cout << "nodes mode ms_per_frame bytes_per_frame" << std::endl;
+  for (size_t num_nodes = 100; num_nodes <= (size_t) max_nodes.value(); num_nodes *= 10) {
+    for (const bool journal : {false, true}) {
+      std::remove(settings_path.c_str());
+      std::remove(journal_path.c_str());
+
+      ed::Config config;
+      config.SettingsFile    = settings_path.c_str();
+      config.SettingsJournal = journal;
+      // srrg no compaction while measuring, it would only add a background thread
+      config.SettingsJournalCompactLimit = 2 * num_frames_value;
+      // srrg the editor keeps every node it has seen, each graph gets a fresh one
+      HeadlessEditor editor(ImVec2(1920, 1080), config);
+      editor.frame([&]() { submitGrid(num_nodes, num_nodes, 0); });
+      editor.frame([&]() { submitGrid(num_nodes, num_nodes, 0); });
+      const size_t initial_bytes = fileSize(settings_path) + fileSize(journal_path);
+
+      size_t written_bytes = 0;
+      double total_ms      = 0;
+      for (size_t f = 0; f < num_frames_value; ++f) {
+        const auto t_start = BenchmarkClock::now();
+        editor.frame([&]() { submitGrid(num_nodes, f % num_nodes, 1.f + f); });
+        total_ms += elapsedMs(t_start);
+        // srrg the whole file is written again on every save, the journal only grows
+        written_bytes += journal ? 0 : fileSize(settings_path);
+      }
+      if (journal) {
+        written_bytes = fileSize(journal_path) + fileSize(settings_path) - initial_bytes;
+      }
+
+      std::cout << std::fixed << std::setprecision(4) << num_nodes << " "
+                << (journal ? "journal" : "full") << " " << total_ms / num_frames_value << " "
+                << written_bytes / num_frames_value << std::endl;
+    }
+  }
+  std::remove(settings_path.c_str());
+  std::remove(journal_path.c_str());
+  return 0;
+}
@@ -0,0 +1,69 @@
+#include "benchmark_utils.h"
+#include <iomanip>
+#include <srrg_system_utils/parse_command_line.h>
+#include <srrg_system_utils/system_utils.h>
+
+using namespace srrg2_core;
+namespace ed = ax::NodeEditor;
+
+const char* banner[] = {
+  "measures the per frame cost of the node titles, labels and pin names with their text sizes",
+  "cached and measured at every frame (CachedText::setCaching), culling is off so every node is",
+  "drawn in full",
+  "output: one line per graph and mode with the text measurements per frame, the average time",
+  "per frame and whether all the node sizes match the ones measured at every frame",
+  0};
+
+int main(int argc, char** argv) {
+  srrgInit(argc, argv, "benchmark_text_metrics");
+  ParseCommandLine cmd_line(argv, banner);
+  ArgumentInt max_nodes(&cmd_line, "n", "max-nodes", "largest graph to generate", 10000);
+  ArgumentInt num_frames(&cmd_line, "f", "frames", "frames averaged per graph", 20);
+  cmd_line.parse();
+
+  std::cout << "nodes mode measurements_per_frame ms_per_frame layout" << std::endl;
+  for (size_t num_nodes = 100; num_nodes <= (size_t) max_nodes.value(); num_nodes *= 10) {
+    // srrg node sizes by layout key, the uncached run is the reference
+    std::map<std::string, ImVec2> reference_sizes;
+    for (const bool caching : {false, true}) {
+      CachedText::setCaching(caching);
+      BenchmarkGraph graph;
+      BenchmarkNodeManager& manager = graph.manager;
+      manager.setCulling(false);
+      graph.build("random", num_nodes);
+      graph.show(false);
+
+      const size_t measurements_start = CachedText::measurements();
+      double total_ms                 = 0;
+      for (int f = 0; f < num_frames.value(); ++f) {
+        const auto t_start = BenchmarkClock::now();
+        graph.show(false);
+        total_ms += elapsedMs(t_start);
+      }
+      const size_t num_measurements = CachedText::measurements() - measurements_start;
+
+      bool same_layout = true;
+      for (const auto& entry : manager.nodes()) {
+        const ConfigNodePtr& node = entry.second;
+        const ImVec2 size         = ed::GetNodeSize(node->ID());
+        if (!caching) {
+          reference_sizes[node->layoutKey()] = size;
+          continue;
+        }
+        const auto reference = reference_sizes.find(node->layoutKey());
+        if (reference == reference_sizes.end() || reference->second.x != size.x ||
+            reference->second.y != size.y) {
+          same_layout = false;
+        }
+      }
+
+      std::cout << std::fixed << std::setprecision(4) << num_nodes << " "
+                << (caching ? "cached" : "uncached") << " "
+                << num_measurements / std::max(num_frames.value(), 1) << " "
+                << total_ms / std::max(num_frames.value(), 1) << " "
+                << (caching ? (same_layout ? "identical" : "differs") : "reference") << std::endl;
+    }
+  }
+  CachedText::setCaching(true);
+  return 0;
+}
@@ -0,0 +1,131 @@
+#include "benchmark_utils.h"
+#include <algorithm>
+#include <fstream>
+#include <random>
+
+namespace srrg2_core {
+
+  std::vector<BenchmarkModulePtr> BenchmarkNodeManager::synthesize(const std::string& shape_,
+                                                                   const size_t& num_nodes_) {
+    std::vector<BenchmarkModulePtr> modules(num_nodes_);
+    for (size_t i = 0; i < num_nodes_; ++i) {
+      modules[i] = std::dynamic_pointer_cast<BenchmarkModule>(create("BenchmarkModule"));
+      modules[i]->setName("module_" + std::to_string(i));
+    }
+
+    std::mt19937 rng(num_nodes_);
+    for (size_t i = 1; i < num_nodes_; ++i) {
+      if (shape_ == "chain") {
+        modules[i - 1]->param_child.assign(modules[i]);
+      } else if (shape_ == "fanout") {
+        modules[0]->param_children.pushBack(modules[i]);
+      } else if (shape_ == "shared") {
+        // srrg 4 layers, each module shared by 3 modules of the previous layer
+        const size_t width = std::max<size_t>(4, (num_nodes_ + 3) / 4);
+        if (i < width) {
+          continue;
+        }
+        const size_t layer_begin = (i / width - 1) * width;
+        for (size_t k = 0; k < 3; ++k) {
+          modules[layer_begin + (i + k * 11) % width]->param_children.pushBack(modules[i]);
+        }
+      } else if (shape_ == "diamond") {
+        // srrg stacked diamonds, the bottom of one is the top of the next: 2^(n/3) paths
+        if (i % 3) {
+          modules[(i - 1) / 3 * 3]->param_children.pushBack(modules[i]);
+        } else {
+          modules[i - 2]->param_child.assign(modules[i]);
+          modules[i - 1]->param_child.assign(modules[i]);
+        }
+      } else {
+        modules[rng() % i]->param_children.pushBack(modules[i]);
+      }
+    }
+    return modules;
+  }
+
+  HeadlessEditor::HeadlessEditor(const ImVec2& display_size_, const bool& shared_node_channels_) :
+    HeadlessEditor(display_size_, [&]() {
+      ax::NodeEditor::Config config;
+      config.SettingsFile       = nullptr;
+      config.SharedNodeChannels = shared_node_channels_;
+      return config;
+    }()) {
+  }
+
+  HeadlessEditor::HeadlessEditor(const ImVec2& display_size_,
+                                 const ax::NodeEditor::Config& config_) {
+    ImGui::CreateContext();
+    ImGuiIO& io    = ImGui::GetIO();
+    io.DisplaySize = display_size_;
+    io.IniFilename = nullptr;
+    io.DeltaTime   = 1.0f / 60.0f;
+    unsigned char* pixels;
+    int width, height;
+    io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+
+    _editor = ax::NodeEditor::CreateEditor(&config_);
+  }
+
+  HeadlessEditor::~HeadlessEditor() {
+    ax::NodeEditor::DestroyEditor(_editor);
+    ImGui::DestroyContext();
+  }
+
+  void HeadlessEditor::_beginFrame() {
+    ImGui::NewFrame();
+    ImGui::SetNextWindowPos(ImVec2(0, 0));
+    ImGui::SetNextWindowSize(ImGui::GetIO().DisplaySize);
+    ImGui::Begin("Content",
+                 nullptr,
+                 ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize |
+                   ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoSavedSettings);
+    ax::NodeEditor::SetCurrentEditor(_editor);
+    ax::NodeEditor::Begin("benchmark", ImVec2(0.0f, 0.0f));
+  }
+
+  void HeadlessEditor::_endFrame() {
+    ax::NodeEditor::End();
+    ax::NodeEditor::SetCurrentEditor(nullptr);
+    ImGui::End();
+    ImGui::Render();
+  }
+
+  BenchmarkGraph::~BenchmarkGraph() {
+    editor.frame([&]() { manager.clear(); });
+  }
+
+  std::vector<BenchmarkModulePtr>& BenchmarkGraph::build(const std::string& shape_,
+                                                         const size_t& num_nodes_,
+                                                         const bool& layout_) {
+    modules = manager.synthesize(shape_, num_nodes_);
+    editor.frame([&]() { manager._buildConfigNodes(); });
+    if (layout_) {
+      editor.frame([&]() { manager.refreshView(ImVec2(100, 100)); });
+    }
+    return modules;
+  }
+
+  void BenchmarkGraph::show(const bool& links_) {
+    editor.frame([&]() {
+      manager.showNodes();
+      if (links_) {
+        manager.showLinks();
+      }
+    });
+  }
+
+  size_t readProcessMemoryKb(const std::string& field_) {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+      if (line.compare(0, field_.size(), field_) == 0 && line[field_.size()] == ':') {
+        return std::stoul(line.substr(field_.size() + 1));
+      }
+    }
+    return 0;
+  }
+
+  BOSS_REGISTER_CLASS(BenchmarkModule)
+
+} // namespace srrg2_core
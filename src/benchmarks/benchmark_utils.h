@@ -0,0 +1,88 @@
+#pragma once
+#include "srrg_config_visualizer/configurable_node_manager.h"
+#include <chrono>
+#include <srrg_config/configurable.h>
+#include <srrg_config/property_configurable.h>
+
+namespace srrg2_core {
+
+  // srrg configurable used to synthesize graphs, with a single and a vector connection
+  class BenchmarkModule : public Configurable {
+  public:
+    PARAM(PropertyConfigurable_<BenchmarkModule>, child, "single connection", nullptr, nullptr);
+    PARAM_VECTOR(PropertyConfigurableVector_<BenchmarkModule>,
+                 children,
+                 "vector connection",
+                 nullptr);
+    PARAM(PropertyDouble, gain, "a double parameter", 0.5, nullptr);
+    PARAM(PropertyBool, enabled, "a bool parameter", true, nullptr);
+    PARAM(PropertyInt, max_iterations, "an int parameter", 10, nullptr);
+    PARAM(PropertyString, topic, "a string parameter", "/benchmark", nullptr);
+  };
+
+  using BenchmarkModulePtr = std::shared_ptr<BenchmarkModule>;
+
+  // srrg exposes the manager internals driven by the benchmarks
+  class BenchmarkNodeManager : public ConfigurableNodeManager {
+  public:
+    using ConfigurableNodeManager::_buildConfigNodes;
+
+    // srrg creates num_nodes_ modules connected as a chain, fanout, shared, diamond or random
+    // graph
+    std::vector<BenchmarkModulePtr> synthesize(const std::string& shape_,
+                                               const size_t& num_nodes_);
+  };
+
+  // srrg imgui and node editor contexts without a window, frames are built and never drawn
+  class HeadlessEditor {
+  public:
+    HeadlessEditor(const ImVec2& display_size_       = ImVec2(1920, 1080),
+                   const bool& shared_node_channels_ = false);
+    // srrg with a caller provided editor config, e.g. to persist settings
+    HeadlessEditor(const ImVec2& display_size_, const ax::NodeEditor::Config& config_);
+    ~HeadlessEditor();
+
+    template <typename CallbackType_>
+    void frame(CallbackType_ callback_) {
+      _beginFrame();
+      callback_();
+      _endFrame();
+    }
+
+  protected:
+    void _beginFrame();
+    void _endFrame();
+    ax::NodeEditor::EditorContext* _editor = nullptr;
+  };
+
+  // srrg a synthesized graph in a fresh headless editor, the setup shared by the benchmarks of the
+  // manager. The manager is configured before build(), the graph is cleared within a frame when
+  // destroyed
+  class BenchmarkGraph {
+  public:
+    ~BenchmarkGraph();
+
+    // srrg synthesizes the graph and builds its nodes, with layout_ also places them from
+    // (100, 100) as the application does
+    std::vector<BenchmarkModulePtr>& build(const std::string& shape_,
+                                           const size_t& num_nodes_,
+                                           const bool& layout_ = true);
+
+    // srrg a frame submitting the nodes and, with links_, the links
+    void show(const bool& links_ = true);
+
+    HeadlessEditor editor;
+    BenchmarkNodeManager manager;
+    std::vector<BenchmarkModulePtr> modules;
+  };
+
+  using BenchmarkClock = std::chrono::steady_clock;
+
+  inline double elapsedMs(const BenchmarkClock::time_point& since_) {
+    return std::chrono::duration<double, std::milli>(BenchmarkClock::now() - since_).count();
+  }
+
+  // srrg reads a field of /proc/self/status such as VmRSS or VmHWM, 0 if not available
+  size_t readProcessMemoryKb(const std::string& field_);
+
+} // namespace srrg2_core
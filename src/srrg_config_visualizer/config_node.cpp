@@ -1,20 +1,24 @@
 #include "config_node.h"
 #include "configurable_node_manager.h"
+#include "frame_profiler.h"
 #include <srrg_property/property_eigen.h>
 #include <srrg_property/property_identifiable.h>
+#include <sstream>
 
 #define VERTICAL_SPACING 8.0f
 #define HALF_VERTICAL_SPACING 4.0f
 #define PADDING 14.0f
 #define HALF_PADDING 7.0f
 #define ITEM_WIDTH 180.0f
+#define ICON_SIZE 20.0f
 
 namespace ed = ax::NodeEditor;
 
 namespace srrg2_core {
-  int ConfigNode::ed_counter = 1;
+  std::atomic<int> ConfigNode::ed_counter(1);
 
   ConfigNode::ConfigNode(PropertyContainerIdentifiablePtr configurable_) :
+    _title(configurable_->className()),
     _configurable(configurable_),
     _id(ed_counter++) {
     _pins.push_back(PinPtr(new Pin(ed_counter++, ed::PinKind::Input)));
@@ -30,260 +34,393 @@ namespace srrg2_core {
         _pins.push_back(PinPtr(new Pin(ed_counter++, ed::PinKind::Output, pc->name())));
       }
     }
+    compileWidgets();
+  }
+
+  void ConfigNode::releaseConnections() {
+    // srrg output iterators die with the container, a later release() must not touch them
+    for (auto& o : _output_links) {
+      o.second->_has_output = false;
+    }
+    _input_links.clear();
+    _output_links.clear();
+  }
+
+  void ConfigNode::compileWidgets() {
+    _widgets     = _makeWidgets(_configurable, true);
+    _name_buffer = _configurable->name();
+  }
+
+  std::vector<PropertyWidget>
+  ConfigNode::_makeWidgets(const PropertyContainerIdentifiablePtr& configurable_,
+                           const bool& report_) {
+    using WidgetType = PropertyWidget::WidgetType;
+    std::vector<PropertyWidget> widgets;
+    for (auto& field : configurable_->properties()) {
+      PropertyBase* prop = field.second;
+      if (dynamic_cast<PropertyIdentifiablePtrInterfaceBase*>(prop)) {
+        continue;
+      }
+
+      PropertyWidget widget;
+      widget.label.setText(field.first);
+      widget.popup = prop->name().c_str();
+      if (auto p = dynamic_cast<PropertyBool*>(prop)) {
+        widget.type     = WidgetType::Bool;
+        widget.property = p;
+      } else if (auto p = dynamic_cast<PropertyDouble*>(prop)) {
+        widget.type     = WidgetType::Double;
+        widget.property = p;
+      } else if (auto p = dynamic_cast<PropertyString*>(prop)) {
+        widget.type     = WidgetType::String;
+        widget.property = p;
+      } else if (auto p = dynamic_cast<PropertyFloat*>(prop)) {
+        widget.type     = WidgetType::Float;
+        widget.property = p;
+      } else if (auto p = dynamic_cast<PropertyUInt8*>(prop)) {
+        widget.type     = WidgetType::UInt8;
+        widget.property = p;
+      } else if (auto p = dynamic_cast<PropertyUnsignedInt*>(prop)) {
+        widget.type     = WidgetType::UnsignedInt;
+        widget.property = p;
+      } else if (auto p = dynamic_cast<PropertyInt*>(prop)) {
+        widget.type     = WidgetType::Int;
+        widget.property = p;
+      } else if (auto p = dynamic_cast<PropertyVector_<int>*>(prop)) {
+        widget.type     = WidgetType::VectorInt;
+        widget.property = p;
+      } else if (auto p = dynamic_cast<PropertyVector_<std::string>*>(prop)) {
+        widget.type     = WidgetType::VectorString;
+        widget.property = p;
+      } else if (auto p = dynamic_cast<PropertyEigenBase*>(prop)) {
+        if (!p->rows() || !p->cols()) {
+          if (!report_) {
+            continue;
+          }
+          throw std::runtime_error("Eigen property has no rows or cols");
+        }
+        widget.type     = WidgetType::Eigen;
+        widget.property = p;
+      } else {
+        if (report_) {
+          std::cerr << "type of property " << field.first << " is not handled" << std::endl;
+          std::cerr << "please contact the maintainers" << std::endl;
+        }
+        continue;
+      }
+      widgets.push_back(widget);
+    }
+    return widgets;
+  }
+
+  LayoutNodeDescription ConfigNode::describe() const {
+    using WidgetType = PropertyWidget::WidgetType;
+    using WidgetKind = LayoutNodeDescription::WidgetKind;
+
+    LayoutNodeDescription description;
+    description.title_length = _configurable->className().length();
+    description.widgets.reserve(_widgets.size());
+    for (const PropertyWidget& widget : _widgets) {
+      LayoutNodeDescription::Widget w;
+      w.label_length = widget.label.text().length();
+      switch (widget.type) {
+        case WidgetType::Bool:
+          w.kind = WidgetKind::Checkbox;
+          break;
+        case WidgetType::VectorInt:
+        case WidgetType::VectorString:
+          w.kind = WidgetKind::Button;
+          break;
+        case WidgetType::Eigen:
+          w.kind = WidgetKind::WideButton;
+          break;
+        default:
+          w.kind = WidgetKind::Field;
+          break;
+      }
+      description.widgets.push_back(w);
+    }
+    for (size_t i = 1; i < _pins.size(); ++i) {
+      description.output_label_lengths.push_back(_pins[i]->paramName().length());
+      if (_pins[i]->hiddenDescendants()) {
+        description.collapsed_label_lengths.push_back(
+          collapsedLabel(_pins[i]->hiddenDescendants()).length());
+      }
+    }
+    return description;
+  }
+
+  std::vector<SearchField> ConfigNode::searchFields() const {
+    return _searchFields(_configurable, _widgets);
+  }
+
+  std::vector<SearchField>
+  ConfigNode::searchFields(const PropertyContainerIdentifiablePtr& configurable_) {
+    return _searchFields(configurable_, _makeWidgets(configurable_, false));
+  }
+
+  std::vector<SearchField>
+  ConfigNode::_searchFields(const PropertyContainerIdentifiablePtr& configurable_,
+                            const std::vector<PropertyWidget>& widgets_) {
+    using WidgetType = PropertyWidget::WidgetType;
+
+    std::vector<SearchField> fields;
+    fields.reserve(widgets_.size() + 2);
+    fields.push_back(SearchField(SearchField::Kind::Name, configurable_->name()));
+    fields.push_back(SearchField(SearchField::Kind::Class, configurable_->className()));
+    for (const PropertyWidget& widget : widgets_) {
+      std::ostringstream stream;
+      stream << widget.label.text() << "=";
+      switch (widget.type) {
+        case WidgetType::Bool:
+          stream << (static_cast<PropertyBool*>(widget.property)->value() ? "true" : "false");
+          break;
+        case WidgetType::Double:
+          stream << static_cast<PropertyDouble*>(widget.property)->value();
+          break;
+        case WidgetType::String:
+          stream << static_cast<PropertyString*>(widget.property)->value();
+          break;
+        case WidgetType::Float:
+          stream << static_cast<PropertyFloat*>(widget.property)->value();
+          break;
+        case WidgetType::UInt8:
+          stream << static_cast<unsigned>(static_cast<PropertyUInt8*>(widget.property)->value());
+          break;
+        case WidgetType::UnsignedInt:
+          stream << static_cast<PropertyUnsignedInt*>(widget.property)->value();
+          break;
+        case WidgetType::Int:
+          stream << static_cast<PropertyInt*>(widget.property)->value();
+          break;
+        case WidgetType::VectorInt:
+          for (const int& v : static_cast<PropertyVector_<int>*>(widget.property)->value()) {
+            stream << v << " ";
+          }
+          break;
+        case WidgetType::VectorString:
+          for (const std::string& v :
+               static_cast<PropertyVector_<std::string>*>(widget.property)->value()) {
+            stream << v << " ";
+          }
+          break;
+        case WidgetType::Eigen: {
+          PropertyEigenBase* p = static_cast<PropertyEigenBase*>(widget.property);
+          for (int r = 0; r < p->rows(); ++r) {
+            for (int c = 0; c < p->cols(); ++c) {
+              stream << p->valueAt(r, c) << " ";
+            }
+          }
+          break;
+        }
+      }
+      std::string text = stream.str();
+      if (text.back() == ' ') {
+        text.pop_back();
+      }
+      fields.push_back(SearchField(SearchField::Kind::Property, text));
+    }
+    return fields;
+  }
+
+  std::string ConfigNode::collapsedLabel(const size_t& hidden_descendants_) {
+    return "+" + std::to_string(hidden_descendants_) + " hidden";
+  }
+
+  // srrg lets InputText grow the edited std::string in place
+  static int resizeStringCallback(ImGuiInputTextCallbackData* data_) {
+    if (data_->EventFlag == ImGuiInputTextFlags_CallbackResize) {
+      std::string* str = static_cast<std::string*>(data_->UserData);
+      str->resize(data_->BufTextLen);
+      data_->Buf = &(*str)[0];
+    }
+    return 0;
+  }
+
+  static bool inputString(const char* label_, std::string& str_) {
+    return ImGui::InputText(label_,
+                            &str_[0],
+                            str_.capacity() + 1,
+                            ImGuiInputTextFlags_CallbackResize,
+                            resizeStringCallback,
+                            &str_);
+  }
+
+  static const ImColor header_color(100, 50, 55);
+
+  // srrg icon next to a pin, shared by the full and the simplified nodes
+  static void pinIcon(const Pin& pin_, ax::Drawing::IconType& type_, ImColor& color_) {
+    if (pin_.type() == Pin::PinType::ConfigVector) {
+      type_  = ax::Drawing::IconType::Square;
+      color_ = ImColor(255, 30, 30);
+    } else {
+      type_  = ax::Drawing::IconType::Circle;
+      color_ = ImColor(30, 127, 255);
+    }
   }
 
   ed::Utilities::BlueprintNodeBuilder ConfigNode::builder = ed::Utilities::BlueprintNodeBuilder();
   void ConfigNode::internals() {
-    auto* window = ImGui::GetCurrentWindow();
+    SRRG_PROFILE_SCOPE(NodeInternals);
+    using WidgetType = PropertyWidget::WidgetType;
 
     builder.Begin(_id);
-    builder.Header(ImColor(100, 50, 55));
+    builder.Header(header_color);
     ImGui::Spring(1);
-    ImGui::TextUnformatted(name());
+    _title.draw();
     ImGui::Spring(1);
     ImGui::Dummy(ImVec2(0, 30));
     ImGui::Spring(0);
     builder.EndHeader();
 
     builder.Input(inputPin()->ID());
-    ax::Widgets::Icon(ImVec2(20, 20),
-                      ax::Drawing::IconType::Circle,
-                      false,
-                      ImColor(30, 127, 255),
-                      ImColor(32, 32, 32));
+    ax::Widgets::IconType input_icon;
+    ImColor input_color;
+    pinIcon(*inputPin(), input_icon, input_color);
+    ax::Widgets::Icon(
+      ImVec2(ICON_SIZE, ICON_SIZE), input_icon, false, input_color, ImColor(32, 32, 32));
     ImGui::Spring(0);
     builder.EndInput();
 
     builder.Middle();
     ImGui::Spring(-1);
 
-    std::map<PropertyBase*, ImVector<ImGuiID>> prop_id_map;
+    ImGui::PushItemWidth(ITEM_WIDTH);
+    for (PropertyWidget& widget : _widgets) {
+      const char* name = widget.label.c_str();
 
-    for (auto field : _configurable->properties()) {
-      if (dynamic_cast<PropertyIdentifiablePtrInterfaceBase*>(field.second)) {
-        continue;
-      }
-      const char* name       = field.first.c_str();
-      const char* popup_name = field.second->name().c_str();
-      ImVec2 text_size       = ImGui::CalcTextSize(name);
-      ImVec2 text_padding(15, HALF_VERTICAL_SPACING);
-      ImGui::PushItemWidth(ITEM_WIDTH);
-
-      char buff[512];
-
-      if (auto p = dynamic_cast<PropertyBool*>(field.second)) {
-        bool& b = p->value();
-        ImGui::Checkbox(name, &b);
-        ImGui::SameLine();
-        if (b) {
-          ImGui::TextColored(ImVec4(0.0f, 1.0f, 0.0f, 1.0f), "True");
-        } else {
-          ImGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "False");
+      switch (widget.type) {
+        case WidgetType::Bool: {
+          bool& b = static_cast<PropertyBool*>(widget.property)->value();
+          _edited |= ImGui::Checkbox(name, &b);
+          ImGui::SameLine();
+          if (b) {
+            ImGui::TextColored(ImVec4(0.0f, 1.0f, 0.0f, 1.0f), "True");
+          } else {
+            ImGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "False");
+          }
+          break;
         }
-      } else if (auto p = dynamic_cast<PropertyDouble*>(field.second)) {
-        double& d = p->value();
-        ImGui::DragScalar(name, ImGuiDataType_Double, &d, 0.05);
-      } else if (auto p = dynamic_cast<PropertyString*>(field.second)) {
-        // if (dynamic_cast<srrg2_proslam::FeatureExtractor*>(_configurable.get())) {
-        //   if (field.first == "descriptor_type") {
-        //     static std::vector<std::string> descriptor_types =
-        //       srrg2_proslam::FeatureExtractor::available_descriptors;
-        //     std::sort(descriptor_types.begin(), descriptor_types.end());
-        //     const size_t factor_classes_size = descriptor_types.size();
-        //     const char* items[factor_classes_size];
-        //     for (size_t i = 0; i < factor_classes_size; ++i) {
-        //       items[i] = descriptor_types[i].c_str();
-        //     }
-        //     size_t index = std::distance(
-        //       descriptor_types.begin(),
-        //       std::find(descriptor_types.begin(), descriptor_types.end(), p->value()));
-        //     const char* item_current = items[index == factor_classes_size ? 0 : index];
-
-        //     if (ImGui::BeginCombo(name, item_current, 0)) {
-        //       for (size_t n = 0; n < factor_classes_size; n++) {
-        //         bool is_selected = (item_current == items[n]);
-        //         if (ImGui::Selectable(items[n], is_selected)) {
-        //           item_current = items[n];
-        //           p->setValue(std::string(item_current));
-        //         }
-        //         if (is_selected) {
-        //           ImGui::SetItemDefaultFocus();
-        //         }
-        //       }
-        //       ImGui::EndCombo();
-        //     }
-
-        //   } else if (field.first == "detector_type") {
-        //     static std::vector<std::string> detector_type =
-        //       srrg2_proslam::FeatureExtractor::available_detectors;
-        //     std::sort(detector_type.begin(), detector_type.end());
-        //     const size_t factor_classes_size = detector_type.size();
-        //     const char* items[factor_classes_size];
-        //     for (size_t i = 0; i < factor_classes_size; ++i) {
-        //       items[i] = detector_type[i].c_str();
-        //     }
-        //     size_t index =
-        //       std::distance(detector_type.begin(),
-        //                     std::find(detector_type.begin(), detector_type.end(), p->value()));
-        //     const char* item_current = items[index == factor_classes_size ? 0 : index];
-
-        //     if (ImGui::BeginCombo(name, item_current, 0)) {
-        //       for (size_t n = 0; n < factor_classes_size; n++) {
-        //         bool is_selected = (item_current == items[n]);
-        //         if (ImGui::Selectable(items[n], is_selected)) {
-        //           item_current = items[n];
-        //           p->setValue(std::string(item_current));
-        //         }
-        //         if (is_selected) {
-        //           ImGui::SetItemDefaultFocus();
-        //         }
-        //       }
-        //       ImGui::EndCombo();
-        //     }
-        //   }
-
-        // } else if (field.first == "factor_classname" || field.first == "factor_class_name") {
-        //   const char* label      = "Select the type of factor";
-        //   float types_max_size_x = 100.0;
-        //   static std::vector<std::string> factor_classes =
-        //     ConfigurableNodeManager::listFactorTypes();
-        //   const size_t factor_classes_size = factor_classes.size();
-        //   const char* items[factor_classes_size];
-        //   for (size_t i = 0; i < factor_classes_size; ++i) {
-        //     items[i]         = factor_classes[i].c_str();
-        //     types_max_size_x = ImGui::CalcTextSize(items[i]).x;
-        //   }
-        //   types_max_size_x = std::max<float>(
-        //     ImGui::CalcTextSize(label).x + 100 + ImGui::CalcTextSize("search").x, types_max_size_x);
-
-        //   size_t index =
-        //     std::distance(factor_classes.begin(),
-        //                   std::find(factor_classes.begin(), factor_classes.end(), p->value()));
-        //   const char* item_current = items[index == factor_classes_size ? 0 : index];
-
-        //   if (ImGui::BeginCombo(name, item_current, 0)) {
-        //     for (size_t n = 0; n < factor_classes_size; n++) {
-        //       bool is_selected = (item_current == items[n]);
-        //       if (ImGui::Selectable(items[n], is_selected)) {
-        //         item_current = items[n];
-        //         p->setValue(std::string(item_current));
-        //       }
-        //       if (is_selected) {
-        //         ImGui::SetItemDefaultFocus();
-        //       }
-        //     }
-        //     ImGui::EndCombo();
-        //   }
-        // } else 
-          {
-          std::strcpy(buff, p->value().c_str());
-          if (ImGui::InputText(name, buff, 512)) {
-            p->setValue(std::string(buff));
+        case WidgetType::Double: {
+          double& d = static_cast<PropertyDouble*>(widget.property)->value();
+          _edited |= ImGui::DragScalar(name, ImGuiDataType_Double, &d, 0.05);
+          break;
+        }
+        case WidgetType::String: {
+          PropertyString* p = static_cast<PropertyString*>(widget.property);
+          if (inputString(name, p->value())) {
+            p->setValue(p->value());
+            _edited = true;
           }
+          break;
         }
-      } else if (auto p = dynamic_cast<PropertyFloat*>(field.second)) {
-        float& f = p->value();
-        ImGui::DragScalar(name, ImGuiDataType_Float, &f, 0.05);
-      } else if (auto p = dynamic_cast<PropertyUInt8*>(field.second)) {
-        uint8_t& u8       = p->value();
-        const uint8_t min = 0, max = 255;
-        ImGui::SliderScalar(name, ImGuiDataType_U8, &u8, &min, &max, "%u");
-      } else if (auto p = dynamic_cast<PropertyUnsignedInt*>(field.second)) {
-        uint64_t& i = p->value();
-        ImGui::DragScalar(name, ImGuiDataType_U64, &i, 1);
-      } else if (auto p = dynamic_cast<PropertyInt*>(field.second)) {
-        int& i = p->value();
-        ImGui::DragScalar(name, ImGuiDataType_S32, &i, 1);
-      } else if (dynamic_cast<PropertyVector_<int>*>(field.second)) {
-        prop_id_map.insert(std::make_pair(field.second, window->IDStack));
-        if (ImGui::Button(name)) {
-          ed::Suspend();
-          ImGui::OpenPopup(popup_name);
-          ed::Resume();
+        case WidgetType::Float: {
+          float& f = static_cast<PropertyFloat*>(widget.property)->value();
+          _edited |= ImGui::DragScalar(name, ImGuiDataType_Float, &f, 0.05);
+          break;
         }
-      } else if (dynamic_cast<PropertyVector_<std::string>*>(field.second)) {
-        prop_id_map.insert(std::make_pair(field.second, window->IDStack));
-        if (ImGui::Button(name)) {
-          ed::Suspend();
-          ImGui::OpenPopup(popup_name);
-          ed::Resume();
+        case WidgetType::UInt8: {
+          uint8_t& u8       = static_cast<PropertyUInt8*>(widget.property)->value();
+          const uint8_t min = 0, max = 255;
+          _edited |= ImGui::SliderScalar(name, ImGuiDataType_U8, &u8, &min, &max, "%u");
+          break;
         }
-      } else if (auto p = dynamic_cast<PropertyEigenBase*>(field.second)) {
-        const int rows = p->rows();
-        const int cols = p->cols();
-        const int size = rows * cols;
-        if (!size) {
-          throw std::runtime_error("Eigen property has no rows or cols");
+        case WidgetType::UnsignedInt: {
+          uint64_t& i = static_cast<PropertyUnsignedInt*>(widget.property)->value();
+          _edited |= ImGui::DragScalar(name, ImGuiDataType_U64, &i, 1);
+          break;
         }
-
-        prop_id_map.insert(std::make_pair(field.second, window->IDStack));
-        if (ImGui::Button(name, text_size + text_padding)) {
-          ed::Suspend();
-          ImGui::OpenPopup(popup_name);
-          ed::Resume();
+        case WidgetType::Int: {
+          int& i = static_cast<PropertyInt*>(widget.property)->value();
+          _edited |= ImGui::DragScalar(name, ImGuiDataType_S32, &i, 1);
+          break;
+        }
+        case WidgetType::VectorInt:
+        case WidgetType::VectorString:
+        case WidgetType::Eigen: {
+          widget.popup_id = ImGui::GetID(widget.popup);
+          ImVec2 button_size(0, 0);
+          if (widget.type == WidgetType::Eigen) {
+            button_size = widget.label.size() + ImVec2(15, HALF_VERTICAL_SPACING);
+          }
+          if (ImGui::Button(name, button_size)) {
+            ed::Suspend();
+            ImGui::OpenPopupEx(widget.popup_id);
+            ed::Resume();
+          }
+          break;
         }
-      } else {
-        std::cerr << "type of property " << field.first << " is not handled" << std::endl;
-        std::cerr << "please contact the maintainers" << std::endl;
       }
     }
 
     ImGui::Spring(1);
 
-    for (auto& output : outputPins()) {
+    for (size_t i = 1; i < _pins.size(); ++i) {
+      const PinPtr& output = _pins[i];
       builder.Output(output->ID());
       ImGui::Spring(0);
-      ImGui::TextUnformatted(output->paramName().c_str());
+      output->label().draw();
       ImGui::Spring(0);
       ax::Widgets::IconType iconType;
       ImColor color;
-      switch (output->type()) {
-        case Pin::PinType::Config:
-          iconType = ax::Widgets::IconType::Circle;
-          color    = ImColor(30, 127, 255);
-          break;
-        case Pin::PinType::ConfigVector:
-          iconType = ax::Widgets::IconType::Square;
-          color    = ImColor(255, 30, 30);
-          break;
-        default:
-          return;
-      }
+      pinIcon(*output, iconType, color);
 
-      ax::Widgets::Icon(ImVec2(20, 20), iconType, false, color, ImColor(32, 32, 32));
+      ax::Widgets::Icon(ImVec2(ICON_SIZE, ICON_SIZE), iconType, false, color, ImColor(32, 32, 32));
       builder.EndOutput();
+
+      // srrg collapsed stub below the pin, outside of it so the click does not start a link
+      if (output->hiddenDescendants()) {
+        ImGui::PushID(output->ID().AsPointer());
+        if (ImGui::SmallButton(collapsedLabel(output->hiddenDescendants()).c_str())) {
+          _expand_request = output;
+        }
+        ImGui::PopID();
+      }
     }
 
     builder.Footer();
     ImGui::Spring(1);
 
-    const char* buff_name = _configurable->name().c_str();
-    if (ImGui::InputText("name", (char*) buff_name, 256)) {
-      _configurable->setName(std::string(buff_name));
+    if (_name_buffer != _configurable->name()) {
+      _name_buffer = _configurable->name();
+      _edited      = true;
+    }
+    if (inputString("name", _name_buffer)) {
+      _configurable->setName(_name_buffer);
+      _edited = true;
     }
     ImGui::Spring(1);
 
     builder.EndFooter();
     builder.End();
+    ImGui::PopItemWidth();
+    _measure();
 
-    for (auto elem : prop_id_map) {
-      const char* popup_name = elem.first->name().c_str();
-      std::swap(window->IDStack, elem.second);
+    for (PropertyWidget& widget : _widgets) {
+      if (!widget.popup_id || !ImGui::IsPopupOpen(widget.popup_id)) {
+        continue;
+      }
+      const char* popup_name = widget.popup;
+      static const ImGuiWindowFlags popup_flags = ImGuiWindowFlags_AlwaysAutoResize |
+                                                  ImGuiWindowFlags_NoTitleBar |
+                                                  ImGuiWindowFlags_NoSavedSettings;
 
-      if (auto p = dynamic_cast<PropertyVector_<int>*>(elem.first)) {
-        std::vector<int> values_int = p->value();
-        uint64_t size               = values_int.size();
+      if (widget.type == WidgetType::VectorInt) {
+        PropertyVector_<int>* p = static_cast<PropertyVector_<int>*>(widget.property);
 
         ed::Suspend();
-        if (ImGui::BeginPopup(popup_name)) {
+        if (ImGui::BeginPopupEx(widget.popup_id, popup_flags)) {
+          std::vector<int> values_int = p->value();
+          uint64_t size               = values_int.size();
           ImGui::PushItemWidth(70);
-          ImGui::InputScalar("vector size", ImGuiDataType_U64, &size, NULL, NULL, "%u");
+          // srrg the search index is refreshed only on frames that change a value
+          _edited |= ImGui::InputScalar("vector size", ImGuiDataType_U64, &size, NULL, NULL, "%u");
           if (values_int.size() != size) {
             values_int.resize(size);
           }
           for (uint64_t i = 0; i < size; ++i) {
             std::string s = "val " + std::to_string(i);
-            ImGui::DragScalar(s.c_str(), ImGuiDataType_S32, &values_int[i], 1);
+            _edited |= ImGui::DragScalar(s.c_str(), ImGuiDataType_S32, &values_int[i], 1);
           }
           if (!ImGui::IsPopupOpen(popup_name)) {
             p->setValue(values_int);
@@ -292,26 +429,25 @@ namespace srrg2_core {
           ImGui::EndPopup();
         }
         ed::Resume();
-      } else if (auto p = dynamic_cast<PropertyVector_<std::string>*>(elem.first)) {
-        std::vector<std::string> values_string = p->value();
-        values_string.reserve(100);
-        uint64_t size = values_string.size();
+      } else if (widget.type == WidgetType::VectorString) {
+        PropertyVector_<std::string>* p =
+          static_cast<PropertyVector_<std::string>*>(widget.property);
         ed::Suspend();
-        if (ImGui::BeginPopup(popup_name)) {
+        if (ImGui::BeginPopupEx(widget.popup_id, popup_flags)) {
+          std::vector<std::string> values_string = p->value();
+          values_string.reserve(100);
+          uint64_t size = values_string.size();
           ImGui::PushItemWidth(70);
-          ImGui::InputScalar("vector size", ImGuiDataType_U64, &size, NULL, NULL, "%u");
+          _edited |= ImGui::InputScalar("vector size", ImGuiDataType_U64, &size, NULL, NULL, "%u");
           ImGui::PopItemWidth();
           if (values_string.size() != size) {
             values_string.resize(size);
           }
           for (uint64_t i = 0; i < size; ++i) {
             std::string s = "val " + std::to_string(i);
-            char buff_internal[256];
-            std::strcpy(buff_internal, values_string[i].c_str());
-            //            const char* buff_internal = values_string[i].c_str();
-            if (ImGui::InputText(s.c_str(), buff_internal, 256)) {
-              values_string[i] = buff_internal;
+            if (inputString(s.c_str(), values_string[i])) {
               p->setValue(i, values_string[i]);
+              _edited = true;
             }
           }
           if (!ImGui::IsPopupOpen(popup_name)) {
@@ -320,25 +456,26 @@ namespace srrg2_core {
           ImGui::EndPopup();
         }
         ed::Resume();
-      } else if (auto p = dynamic_cast<PropertyEigenBase*>(elem.first)) {
-        const int rows = p->rows();
-        const int cols = p->cols();
-        const int size = rows * cols;
-        std::vector<float> values_float(size);
-        for (int r = 0; r < rows; ++r) {
-          for (int c = 0; c < cols; ++c) {
-            values_float[r * cols + c] = p->valueAt(r, c);
-          }
-        }
+      } else if (widget.type == WidgetType::Eigen) {
+        PropertyEigenBase* p = static_cast<PropertyEigenBase*>(widget.property);
         ed::Suspend();
-        if (ImGui::BeginPopup(popup_name)) {
+        if (ImGui::BeginPopupEx(widget.popup_id, popup_flags)) {
+          const int rows = p->rows();
+          const int cols = p->cols();
+          std::vector<float> values_float(rows * cols);
+          for (int r = 0; r < rows; ++r) {
+            for (int c = 0; c < cols; ++c) {
+              values_float[r * cols + c] = p->valueAt(r, c);
+            }
+          }
           ImGui::PushItemWidth(70);
           for (int r = 0; r < rows; ++r) {
             for (int c = 0; c < cols; ++c) {
-              char s[16];
-              sprintf(s, "##%u,%u", r, c);
+              char s[32];
+              sprintf(s, "##%d,%d", r, c);
               if (ImGui::DragScalar(s, ImGuiDataType_Float, &values_float[r * cols + c], 0.05)) {
                 p->setValueAt(r, c, values_float[r * cols + c]);
+                _edited = true;
               }
               ImGui::SameLine();
             }
@@ -357,9 +494,141 @@ namespace srrg2_core {
         }
         ed::Resume();
       }
+    }
+  }
+
+  void ConfigNode::_measure() {
+    // srrg the last item is the node group closed by builder.End(), sized as the editor does
+    ImRect rect(ImGui::GetItemRectMin(), ImGui::GetItemRectMax());
+    rect.Floor();
+    const ImVec2 origin = ImGui::GetItemRectMin();
+    _bounds             = ImRect(origin, origin + rect.GetSize());
+
+    _has_header = builder.GetHeaderBand(_header);
+    if (_has_header) {
+      _header.Translate(-origin);
+    }
+
+    auto editor = reinterpret_cast<ed::Detail::EditorContext*>(ed::GetCurrentEditor());
+    _pin_anchors.resize(_pins.size());
+    for (size_t i = 0; i < _pins.size(); ++i) {
+      const ed::Detail::Pin* pin = editor->FindPin(_pins[i]->ID());
+      if (!pin) {
+        return;
+      }
+      PinAnchor& anchor = _pin_anchors[i];
+      anchor.bounds     = ImRect(pin->m_Bounds.Min - origin, pin->m_Bounds.Max - origin);
+      anchor.pivot      = ImRect(pin->m_Pivot.Min - origin, pin->m_Pivot.Max - origin);
+    }
+    _is_measured = true;
+  }
+
+  void ConfigNode::placeholder() {
+    SRRG_PROFILE_SCOPE(NodePlaceholder);
+    _submitAnchors();
+  }
+
+  void ConfigNode::simplified(const LevelOfDetail& level_) {
+    SRRG_PROFILE_SCOPE(NodeSimplified);
+    _submitAnchors();
+    if (!ImGui::IsItemVisible()) {
+      return;
+    }
+
+    // srrg drawn under the node like the builder header, _bounds is already in canvas space
+    ImDrawList* draw_list  = ed::GetNodeBackgroundDrawList(_id);
+    const ImVec2& origin   = _bounds.Min;
+    const ImU32 text_color = ImGui::GetColorU32(ImGuiCol_Text);
+
+    if (level_ == LevelOfDetail::Box) {
+      const float rounding = ed::GetStyle().NodeRounding;
+      draw_list->AddRectFilled(_bounds.Min, _bounds.Max, header_color, rounding);
+
+      // srrg the canvas scales the vertices by the zoom, a font grown by its inverse keeps the
+      // title readable as long as it fits in the box
+      const float inv_scale     = ed::GetCurrentZoom();
+      const ImVec2& title_size  = _title.size();
+      const float max_width     = std::max(_bounds.GetWidth() - 2 * PADDING, 1.f);
+      const float title_scale   = std::min(inv_scale, max_width / std::max(title_size.x, 1.f));
+      const ImVec2 scaled_size  = title_size * title_scale;
+      const ImVec2 title_origin = _bounds.GetCenter() - scaled_size * 0.5f;
+      draw_list->AddText(ImGui::GetFont(),
+                         ImGui::GetFontSize() * title_scale,
+                         title_origin,
+                         text_color,
+                         _title.c_str());
+      return;
+    }
+
+    if (_has_header) {
+      ed::Utilities::BlueprintNodeBuilder::HeaderBand header = _header;
+      header.Translate(origin);
+      ed::Utilities::BlueprintNodeBuilder::DrawHeader(_id, header, header_color);
+      const ImVec2 header_center = (header.Min + header.Max) * 0.5f;
+      draw_list->AddText(header_center - _title.size() * 0.5f, text_color, _title.c_str());
+    }
+
+    // srrg icons at the ends of the pin rects, outputs keep their name on the left
+    const float spacing = ImGui::GetStyle().ItemSpacing.x;
+    for (size_t i = 0; i < _pins.size(); ++i) {
+      const Pin& pin = *_pins[i];
+      const PinAnchor& anchor = _pin_anchors[i];
+      const ImRect pin_rect(origin + anchor.bounds.Min, origin + anchor.bounds.Max);
+      const bool is_input = pin.direction() == ed::PinKind::Input;
+      const ImVec2 icon_min(is_input ? pin_rect.Min.x : pin_rect.Max.x - ICON_SIZE,
+                            pin_rect.GetCenter().y - ICON_SIZE * 0.5f);
+      ax::Drawing::IconType icon_type;
+      ImColor icon_color;
+      pinIcon(pin, icon_type, icon_color);
+      ax::Drawing::DrawIcon(draw_list,
+                            icon_min,
+                            icon_min + ImVec2(ICON_SIZE, ICON_SIZE),
+                            icon_type,
+                            false,
+                            icon_color,
+                            ImColor(32, 32, 32));
+      if (!is_input) {
+        const ImVec2& label_size = pin.label().size();
+        draw_list->AddText(
+          ImVec2(icon_min.x - spacing - label_size.x, pin_rect.GetCenter().y - label_size.y * 0.5f),
+          text_color,
+          pin.label().c_str());
+      }
+    }
+  }
+
+  void ConfigNode::_submitAnchors() {
+    ed::PushStyleVar(ed::StyleVar_NodePadding, ImVec4(0, 0, 0, 0));
+    ed::BeginNode(_id);
+    const ImVec2 origin = ImGui::GetCursorScreenPos();
+
+    // srrg empty pins placed at the origin do not grow the node, their rects are set explicitly
+    for (size_t i = 0; i < _pins.size(); ++i) {
+      const PinAnchor& anchor = _pin_anchors[i];
+      ImGui::SetCursorScreenPos(origin);
+      ed::BeginPin(_pins[i]->ID(), _pins[i]->direction());
+      ed::PinRect(origin + anchor.bounds.Min, origin + anchor.bounds.Max);
+      ed::PinPivotRect(origin + anchor.pivot.Min, origin + anchor.pivot.Max);
+      ed::EndPin();
+    }
+    ImGui::SetCursorScreenPos(origin);
+    ImGui::Dummy(_bounds.GetSize());
 
-      std::swap(window->IDStack, elem.second);
+    ed::EndNode();
+    ed::PopStyleVar();
+    _bounds.Translate(origin - _bounds.Min);
+  }
+
+  bool ConfigNode::hasOpenPopup() const {
+    if (ImGui::GetCurrentContext()->OpenPopupStack.empty()) {
+      return false;
+    }
+    for (const PropertyWidget& widget : _widgets) {
+      if (widget.popup_id && ImGui::IsPopupOpen(widget.popup_id)) {
+        return true;
+      }
     }
+    return false;
   }
 
 } // namespace srrg2_core
@@ -1,11 +1,15 @@
 #pragma once
+#include "layout_engine.h"
+#include "search_index.h"
 #include "srrg_config/property_configurable_vector.h"
+#include "text_metrics.h"
 
 #include <imgui_node_editor_internal.h>
 
 #include <ax/Builders.h>
 #include <ax/Drawing.h>
 #include <ax/Widgets.h>
+#include <atomic>
 
 namespace srrg2_core {
 
@@ -29,6 +33,7 @@ namespace srrg2_core {
         PinType type_                  = PinType::Config) :
       _id(id_),
       _param_name(param_name_),
+      _label(param_name_),
       _type(type_),
       _direction(kind_) {
     }
@@ -41,6 +46,11 @@ namespace srrg2_core {
       return _param_name;
     }
 
+    // srrg parameter name as drawn next to the pin
+    inline const CachedText& label() const {
+      return _label;
+    }
+
     const PinType& type() const {
       return _type;
     }
@@ -49,11 +59,21 @@ namespace srrg2_core {
       return _direction;
     }
 
+    // srrg instances reached through this output that have no node yet (lazy mode)
+    inline const size_t& hiddenDescendants() const {
+      return _hidden_descendants;
+    }
+    inline void setHiddenDescendants(const size_t& count_) {
+      _hidden_descendants = count_;
+    }
+
   protected:
     ax::NodeEditor::PinId _id;
     std::string _param_name            = "";
+    CachedText _label;
     PinType _type                      = PinType::Config;
     ax::NodeEditor::PinKind _direction = ax::NodeEditor::PinKind::Input;
+    size_t _hidden_descendants         = 0;
   };
 
   using PinPtr = std::shared_ptr<Pin>;
@@ -66,6 +86,40 @@ namespace srrg2_core {
     ImVec2 size = ImVec2(0, 0);
   };
 
+  // srrg widget editing a property, the property type is resolved once when the node is built
+  struct PropertyWidget {
+    enum class WidgetType {
+      Bool,
+      Double,
+      String,
+      Float,
+      UInt8,
+      UnsignedInt,
+      Int,
+      VectorInt,
+      VectorString,
+      Eigen
+    };
+
+    WidgetType type;
+    // srrg property already casted to the type matching the widget
+    void* property = nullptr;
+    CachedText label;
+    const char* popup = nullptr;
+    // srrg popup opened by vector and matrix widgets, computed from the node id stack
+    ImGuiID popup_id = 0;
+  };
+
+  // srrg how much of a node is drawn: every widget, the header and the pins, or a box with the
+  // title. The simplified levels keep the size and the pins of the last full draw
+  enum class LevelOfDetail { Full, Pins, Box };
+
+  // srrg pin rectangles relative to the node origin, as measured on the last full draw
+  struct PinAnchor {
+    ImRect bounds;
+    ImRect pivot;
+  };
+
   class ConfigNode {
   public:
     ConfigNode(PropertyContainerIdentifiablePtr configurable_);
@@ -90,13 +144,53 @@ namespace srrg2_core {
       node_bb.size = ax::NodeEditor::GetNodeSize(_id);
     }
 
-    void releaseConnections() {
-      _input_links.clear();
-      _output_links.clear();
-    }
+    void releaseConnections();
 
     void internals();
 
+    // srrg stand-in for internals() when the node is off-screen: submits the same bounds and pins
+    // from the last full draw, without building any widget
+    void placeholder();
+
+    // srrg stand-in for internals() when zoomed out: the placeholder plus the header and pins
+    // (Pins) or a box with the title (Box), drawn without widgets
+    void simplified(const LevelOfDetail& level_);
+
+    // srrg true once internals() ran and the node bounds and pin anchors are known
+    inline bool isMeasured() const {
+      return _is_measured;
+    }
+
+    // srrg canvas rectangle covered by the node on the last submission
+    inline const ImRect& bounds() const {
+      return _bounds;
+    }
+
+    bool hasOpenPopup() const;
+
+    // srrg classifies the properties into widgets, call it if the property set changes
+    void compileWidgets();
+
+    // srrg what internals() draws, for the size estimation of the layout
+    LayoutNodeDescription describe() const;
+
+    // srrg name, class and "name=value" of every property with a widget, for the search index
+    std::vector<SearchField> searchFields() const;
+    // srrg the same fields for an instance without a node, e.g. hidden by the lazy mode. The
+    // properties a node would complain about are skipped silently
+    static std::vector<SearchField>
+    searchFields(const PropertyContainerIdentifiablePtr& configurable_);
+
+    // srrg true if a widget changed the configurable since the last call
+    inline bool consumeEdit() {
+      const bool edited = _edited;
+      _edited           = false;
+      return edited;
+    }
+
+    // srrg text of the stub shown under an output with hidden descendants
+    static std::string collapsedLabel(const size_t& hidden_descendants_);
+
     const PinPtr inputPin() const {
       return _pins[0];
     }
@@ -104,6 +198,15 @@ namespace srrg2_core {
       return std::vector<PinPtr>(_pins.begin() + 1, _pins.end());
     }
 
+    PinPtr outputPin(const std::string& param_name_) const {
+      for (size_t i = 1; i < _pins.size(); ++i) {
+        if (_pins[i]->paramName() == param_name_) {
+          return _pins[i];
+        }
+      }
+      return nullptr;
+    }
+
     BoundingBox node_bb;
 
     const std::multimap<std::string, NodeLinkPtr>& outputLinks() const {
@@ -114,20 +217,49 @@ namespace srrg2_core {
       return _input_links;
     }
 
+    // srrg graph path, class and name of the configurable, stable across runs
+    inline const std::string& layoutKey() const {
+      return _layout_key;
+    }
+
     friend class ConfigurableNodeManager;
     friend class NodeLink;
 
   protected:
     static ax::NodeEditor::Utilities::BlueprintNodeBuilder builder;
     std::vector<PinPtr> _pins;
+    std::vector<PropertyWidget> _widgets;
+    // srrg class name drawn in the header
+    CachedText _title;
+    std::string _name_buffer;
+    std::vector<PinAnchor> _pin_anchors;
+    // srrg header band relative to the node origin, as measured on the last full draw
+    ax::NodeEditor::Utilities::BlueprintNodeBuilder::HeaderBand _header;
+    bool _has_header = false;
+    ImRect _bounds;
+    bool _is_measured = false;
+    bool _edited      = false;
     std::vector<NodeLinkPtr> _input_links;
     std::multimap<std::string, NodeLinkPtr> _output_links;
+    // srrg output whose collapsed stub was clicked, the manager expands it after the frame
+    PinPtr _expand_request = nullptr;
+    std::string _layout_key;
 
     PropertyContainerIdentifiablePtr _configurable = nullptr;
     //    const int _id;
     ax::NodeEditor::NodeId _id;
 
-    static int ed_counter;
+    void _measure();
+    void _submitAnchors();
+
+    // srrg report_ logs unhandled properties and throws on empty Eigen ones, else they are skipped
+    static std::vector<PropertyWidget>
+    _makeWidgets(const PropertyContainerIdentifiablePtr& configurable_, const bool& report_);
+    static std::vector<SearchField>
+    _searchFields(const PropertyContainerIdentifiablePtr& configurable_,
+                  const std::vector<PropertyWidget>& widgets_);
+
+    static std::atomic<int> ed_counter;
     static void _resetCouter() {
       ed_counter = 1;
     }
@@ -1,10 +1,32 @@
 #include "configurable_node_manager.h"
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+#include <deque>
 #include <srrg_system_utils/system_utils.h>
 
 namespace srrg2_core {
-  int ConfigurableNodeManager::ed_counter_links = 1e5;
+  std::atomic<int> ConfigurableNodeManager::ed_counter_links(1e5);
+
+  // srrg metrics of the current imgui font and style, the defaults when there is no font yet
+  static FontMetrics currentFontMetrics() {
+    FontMetrics metrics;
+    if (!ImGui::GetCurrentContext() || !ImGui::GetFont()) {
+      return metrics;
+    }
+    const ImGuiStyle& style      = ImGui::GetStyle();
+    metrics.glyph_width          = ImGui::CalcTextSize("x").x;
+    metrics.font_size            = ImGui::GetFontSize();
+    metrics.frame_padding_x      = style.FramePadding.x;
+    metrics.frame_padding_y      = style.FramePadding.y;
+    metrics.item_spacing_x       = style.ItemSpacing.x;
+    metrics.item_spacing_y       = style.ItemSpacing.y;
+    metrics.item_inner_spacing_x = style.ItemInnerSpacing.x;
+    return metrics;
+  }
 
   void ConfigurableNodeManager::createLink() {
+    SRRG_PROFILE_SCOPE(CreateLink);
     namespace ed = ax::NodeEditor;
 
     if (ed::BeginCreate(ImColor(255, 255, 255), 2.0f)) {
@@ -19,12 +41,12 @@ namespace srrg2_core {
         ConfigNodePtr child_node = child_pair.first;
         PinPtr child_pin         = child_pair.second;
 
-        if (parent_pin->direction() == ed::PinKind::Input) {
-          std::swap(parent_pin, child_pin);
-          std::swap(parent_node, child_node);
-        }
-
         if (parent_pin && child_pin) {
+          if (parent_pin->direction() == ed::PinKind::Input) {
+            std::swap(parent_pin, child_pin);
+            std::swap(parent_node, child_node);
+          }
+
           if (parent_node == child_node) {
             ed::RejectNewItem(ImColor(255, 0, 0), 2.0f);
           } else if (parent_pin->direction() == child_pin->direction()) {
@@ -33,10 +55,12 @@ namespace srrg2_core {
             if (ed::AcceptNewItem(ImColor(255, 255, 255), 2.0f)) {
               NodeLinkPtr l(new NodeLink(ed_counter_links++, parent_node, parent_pin->paramName()));
               if (!ImGui::IsMouseDown(0) && updateConnection(l, child_node)) {
-                if (std::find_if(_links.begin(), _links.end(), [l](NodeLinkPtr other_l) {
-                      return l->parent() == other_l->parent() && l->child == other_l->child;
-                    }) == _links.end()) {
-                  _links.emplace_back(l);
+                // srrg an existing link between the same nodes is one of the child inputs
+                const auto& c_links = child_node->inputLinks();
+                if (std::find_if(c_links.begin(), c_links.end(), [this, l](NodeLinkPtr other_l) {
+                      return l->parent() == other_l->parent() && _hasLink(other_l);
+                    }) == c_links.end()) {
+                  _addLink(l);
                 }
               }
             }
@@ -47,10 +71,118 @@ namespace srrg2_core {
     ed::EndCreate();
   }
 
+  void ConfigurableNodeManager::showNodes() {
+    SRRG_PROFILE_SCOPE(ShowNodes);
+    ImRect view;
+    if (_culling) {
+      auto editor =
+        reinterpret_cast<ax::NodeEditor::Detail::EditorContext*>(ax::NodeEditor::GetCurrentEditor());
+      view = editor->GetViewRect();
+      view.Expand(_culling_margin);
+    }
+
+    _updateLevelOfDetail();
+
+    // srrg a hidden instance gets its node before the drawing, it is focused once measured
+    if (_focus_hidden) {
+      const PropertyContainerIdentifiablePtr hidden = _focus_hidden;
+      _focus_hidden                                 = nullptr;
+      _focus_request                                = _expandTo(hidden);
+    }
+
+    if (_frames_to_settle > 0) {
+      --_frames_to_settle;
+    }
+    if (!_dirty_nodes.empty()) {
+      relayoutDirty();
+    }
+
+    std::vector<ConfigNodePtr> expanding;
+    for (const auto& node : _nodes) {
+      const ConfigNodePtr& n = node.second;
+      if (!n) {
+        continue;
+      }
+      const bool highlighted = !_highlighted.empty() && _highlighted.count(n->ID().Get());
+      if (highlighted) {
+        ax::NodeEditor::PushStyleColor(ax::NodeEditor::StyleColor_NodeBorder,
+                                       ImColor(255, 200, 0));
+        ax::NodeEditor::PushStyleVar(ax::NodeEditor::StyleVar_NodeBorderWidth, 3.f);
+      }
+      // srrg placeholders keep the node and its pins live, links and selection are unaffected
+      // srrg nodes never drawn in full have no size to keep yet, they get one full draw
+      if (!n->isMeasured() || n->hasOpenPopup()) {
+        n->internals();
+      } else if (_culling && !view.Overlaps(n->bounds())) {
+        n->placeholder();
+      } else if (_level_of_detail != LevelOfDetail::Full) {
+        n->simplified(_level_of_detail);
+      } else {
+        n->internals();
+      }
+      if (highlighted) {
+        ax::NodeEditor::PopStyleVar();
+        ax::NodeEditor::PopStyleColor();
+      }
+      if (n->consumeEdit()) {
+        _search_index.set(n->ID().Get(), n->searchFields());
+      }
+      if (n->_expand_request) {
+        expanding.push_back(n);
+      }
+    }
+
+    // srrg the editor knows the bounds of a node only after its first draw
+    if (_focus_request && _focus_request->isMeasured()) {
+      ax::NodeEditor::ClearSelection();
+      ax::NodeEditor::SelectNode(_focus_request->ID());
+      ax::NodeEditor::NavigateToSelection();
+      _focus_request = nullptr;
+    }
+
+    // srrg expanding inserts nodes, not while iterating over them
+    for (const ConfigNodePtr& n : expanding) {
+      const PinPtr pin   = n->_expand_request;
+      n->_expand_request = nullptr;
+      expand(n, pin->paramName());
+    }
+  }
+
+  void ConfigurableNodeManager::_updateLevelOfDetail() {
+    if (!_level_of_detail_enabled) {
+      _level_of_detail = LevelOfDetail::Full;
+      return;
+    }
+    // srrg the editor reports the inverse of the canvas scale
+    const float zoom = 1.f / ax::NodeEditor::GetCurrentZoom();
+
+    // srrg thresholds are lowered while zooming out and raised by the margin while zooming in
+    const float margin = 1.1f;
+    const float pins_zoom =
+      _level_of_detail == LevelOfDetail::Full ? _pins_zoom : _pins_zoom * margin;
+    const float box_zoom = _level_of_detail == LevelOfDetail::Box ? _box_zoom * margin : _box_zoom;
+    const bool below_pins = zoom < pins_zoom;
+    const bool below_box  = zoom < box_zoom;
+    if (below_box) {
+      _level_of_detail = LevelOfDetail::Box;
+    } else if (below_pins) {
+      _level_of_detail = LevelOfDetail::Pins;
+    } else {
+      _level_of_detail = LevelOfDetail::Full;
+    }
+  }
+
   void ConfigurableNodeManager::deleteLinksByPin(ax::NodeEditor::PinId pin_) {
     auto node_pin_pair        = _findPin(pin_);
     ConfigNodePtr parent_node = node_pin_pair.first;
     PinPtr pin                = node_pin_pair.second;
+    if (!pin) {
+      return;
+    }
+    // srrg detached children must stay reachable, give them a node first
+    if (pin->hiddenDescendants()) {
+      expand(parent_node, pin->paramName());
+    }
     const auto& param_name    = pin->paramName();
     auto prop_it              = parent_node->configurable()->properties().find(param_name);
     if (prop_it == parent_node->configurable()->properties().end()) {
@@ -76,11 +208,13 @@ namespace srrg2_core {
     // srrg remove link from the childs
     for (auto l : tmp_vec) {
       l->release();
-      auto l_it = std::find(_links.begin(), _links.end(), l);
-      if (l_it != _links.end()) {
-        _links.erase(l_it);
+      if (_removeLink(l) && !_is_staging) {
         ax::NodeEditor::DeleteLink(l->ID());
       }
+      // srrg a child left without parents stays where it is
+      if (l->child && !l->child->inputLinks().empty()) {
+        _markDirty(l->child, true);
+      }
     }
   }
 
@@ -99,6 +233,11 @@ namespace srrg2_core {
       return false;
     }
 
+    PinPtr source_pin = parent_node->outputPin(param_name);
+    if (!source_pin) {
+      return false;
+    }
+
     if (auto pcv = dynamic_cast<PropertyConfigurableVector*>(prop_it->second)) {
       PropertyContainerIdentifiablePtr val = new_child_->configurable();
 
@@ -117,20 +256,24 @@ namespace srrg2_core {
         pcv->pushBack(val);
       }
 
+      // srrg the outputs of the parent already reach the child if one of its inputs does
       is_present = false;
-      auto lu_it = parent_node->outputLinks().equal_range(param_name);
-      for (auto it = lu_it.first; it != lu_it.second; ++it) {
-        if (it->second->child->configurable() == new_child_->configurable()) {
+      for (const NodeLinkPtr& l : new_child_->inputLinks()) {
+        if (l->_has_output && l->parent() == parent_node && l->paramName() == param_name) {
           is_present = true;
+          break;
         }
       }
 
       if (!is_present) {
-        parent_node->_output_links.insert(std::make_pair(param_name, link_));
+        link_->attachOutput();
       }
 
-      new_child_->_input_links.push_back(link_);
-      link_->child = new_child_;
+      link_->bind(new_child_, source_pin->ID());
+      // srrg a child of a node already on the canvas follows its new parent
+      if (parent_node->isMeasured()) {
+        _markDirty(new_child_, true);
+      }
       return true;
     }
 
@@ -142,18 +285,15 @@ namespace srrg2_core {
       }
 
       // srrg release the connection to the old child
-      for (const auto& pin : parent_node->outputPins()) {
-        if (pin->paramName() == param_name) {
-          deleteLinksByPin(pin->ID());
-          break;
-        }
-      }
+      deleteLinksByPin(source_pin->ID());
 
       // srrg set the connection to the actual one
       pc->assign(val);
-      new_child_->_input_links.push_back(link_);
-      link_->child = new_child_;
-      parent_node->_output_links.insert(std::make_pair(pc->name(), link_));
+      link_->bind(new_child_, source_pin->ID());
+      link_->attachOutput();
+      if (parent_node->isMeasured()) {
+        _markDirty(new_child_, true);
+      }
       return true;
     }
     return false;
@@ -161,65 +301,55 @@ namespace srrg2_core {
 
   void ConfigurableNodeManager::addConfig(const PropertyContainerIdentifiablePtr instance_,
                                           ImVec2 pos_) {
-    NodeMap created_nodes;
-    if (_nodes.find(instance_) == _nodes.end()) {
-      ConfigNodePtr node(new ConfigNode(instance_));
-      node->node_bb.pos = pos_;
-      created_nodes.insert(std::make_pair(instance_, node));
-      _nodes.insert(std::make_pair(instance_, node));
+    std::vector<PropertyContainerIdentifiablePtr> configs;
+    if (_lazy_depth < 0) {
+      std::set<PropertyContainerIdentifiablePtr> connected_configs;
+      instance_->getReacheableContainers(connected_configs);
+      configs.push_back(instance_);
+      configs.insert(configs.end(), connected_configs.begin(), connected_configs.end());
+    } else {
+      configs = _lazyInstances({instance_});
     }
 
-    std::set<PropertyContainerIdentifiablePtr> connected_configs;
-    instance_->getReacheableContainers(connected_configs);
-
-    for (const auto& config : connected_configs) {
-      if (_nodes.find(config) != _nodes.end()) {
-        continue;
+    NodeMap created_nodes = _materialize(configs);
+    auto n_it             = created_nodes.find(instance_);
+    if (n_it != created_nodes.end()) {
+      n_it->second->node_bb.pos = pos_;
+    }
+    if (_incremental_layout) {
+      // srrg placed on the next frame, next to what they link to
+      for (const auto& n : created_nodes) {
+        _markDirty(n.second, false);
       }
-      ConfigNodePtr node(new ConfigNode(config));
-      created_nodes.insert(std::make_pair(config, node));
-      _nodes.insert(std::make_pair(config, node));
+      return;
     }
-    int adjac_matrix_size = created_nodes.size();
-    std::map<PropertyContainerIdentifiablePtr, size_t> bookkeeping;
-    size_t i = 0;
+    _computeLayout(created_nodes, pos_);
+  }
 
-    for (auto n : created_nodes) {
-      n.second->internals();
-      n.second->computeSize();
-      bookkeeping.insert(std::make_pair(n.first, i));
-      ++i;
+  void ConfigurableNodeManager::expand(ConfigNodePtr node_, const std::string& param_name_) {
+    std::multimap<std::string, PropertyContainerIdentifiablePtr> connected_configs;
+    node_->configurable()->getConnectedContainers(connected_configs);
+    std::vector<PropertyContainerIdentifiablePtr> children;
+    auto range = connected_configs.equal_range(param_name_);
+    for (auto c_it = range.first; c_it != range.second; ++c_it) {
+      if (c_it->second && _instances.count(c_it->second)) {
+        children.push_back(c_it->second);
+      }
     }
 
-    srrg2_core::Matrix_<int> config_adjacency_matrix;
-    config_adjacency_matrix.resize(adjac_matrix_size, adjac_matrix_size);
-
-    // mc create connections
-    for (const auto& node_pair : created_nodes) {
-      ConfigNodePtr parent = node_pair.second;
-      std::multimap<std::string, PropertyContainerIdentifiablePtr> connected_configs;
-      parent->configurable()->getConnectedContainers(connected_configs);
-      for (const auto& elem : connected_configs) {
-        PropertyContainerIdentifiablePtr c = elem.second;
-        if (!c) {
-          continue;
-        }
-        if (_nodes.find(c) == _nodes.end()) {
-          std::cerr << "Please add this module manually to the config: " << std::endl;
-          std::cerr << "  " << node_pair.first->className() << "->" << c->className() << std::endl;
-          continue;
-        }
-        auto child = _nodes.at(c);
-        NodeLinkPtr link(new NodeLink(ed_counter_links++, parent, elem.first));
-        updateConnection(link, child);
-        _links.emplace_back(link);
-        config_adjacency_matrix(bookkeeping[parent->configurable()],
-                                bookkeeping[child->configurable()]) = 1;
-      }
+    NodeMap created_nodes = _materialize(children);
+    if (created_nodes.empty()) {
+      return;
+    }
+    // srrg only the new nodes are placed, right of the expanded one
+    ImVec2 origin = node_->node_bb.pos + ImVec2(node_->node_bb.size.x, 0);
+    if (node_->isMeasured()) {
+      origin = ImVec2(node_->bounds().Max.x, node_->bounds().Min.y);
+    }
+    _computeLayout(created_nodes, origin + ImVec2(_layout_engine.padding.x, 0));
+    for (const auto& n : created_nodes) {
+      _dirty_nodes.erase(n.second);
     }
-    std::multimap<int, ConfigNodePtr> sources;
-    _computeSources(config_adjacency_matrix, bookkeeping, 0, sources);
-    _computeNodesPose(pos_, sources);
   }
 
   void ConfigurableNodeManager::createConfig(const std::string& type_, ImVec2 pos_) {
@@ -249,40 +379,188 @@ namespace srrg2_core {
   // }
 
   void ConfigurableNodeManager::refreshView(ImVec2 pos_) {
-    _computeHierarchy(pos_);
+    _computeHierarchy(pos_, false);
   }
 
   void ConfigurableNodeManager::clear() {
+    // srrg ids may be reused only when no staged workspace is holding some of them
+    const bool reset_ids = !_is_staging && !isLoading();
+
     std::cerr << "ConfigurableNodeManager::clear|destroying links ... ";
-    _clearLinks();
+    _clearLinks(reset_ids);
     std::cerr << "[ " << FG_GREEN("SUCCESS") << " ]\n";
 
     std::cerr << "ConfigurableNodeManager::clear|destroying nodes ... ";
-    _clearNodes();
+    _clearNodes(reset_ids);
     std::cerr << "[ " << FG_GREEN("SUCCESS") << " ]\n";
   }
 
+  bool ConfigurableNodeManager::loadAsync(const std::string& file_, ImVec2 pos_) {
+    std::cerr << "loading file in background: " << file_ << std::endl;
+    if (!file_.length() || !srrg2_core::isAccessible(file_)) {
+      std::cerr << "file not present" << std::endl;
+      return false;
+    }
+    _discardLoad();
+
+    // srrg the worker must not touch imgui, it gets the font metrics from here
+    _size_model.setMetrics(currentFontMetrics());
+    _staging.reset(new ConfigurableNodeManager);
+    _staging->_is_staging     = true;
+    _staging->_size_model     = _size_model;
+    _staging->_layout_engine  = _layout_engine;
+    _staging->_lazy_depth     = _lazy_depth;
+    _staging->_layout_caching = _layout_caching;
+
+    _load_state.phase    = LoadPhase::Parsing;
+    _load_state.progress = 0.f;
+    _load_state.cancel   = false;
+    _load_thread         = std::thread(
+      &ConfigurableNodeManager::_stageConfig, _staging.get(), file_, pos_, &_load_state);
+    return true;
+  }
+
+  bool ConfigurableNodeManager::updateLoad() {
+    if (!_load_thread.joinable() || !_load_state.isDone()) {
+      return false;
+    }
+    SRRG_PROFILE_SCOPE(LoadSwap);
+    _load_thread.join();
+
+    bool swapped = false;
+    if (_load_state.phase == LoadPhase::Ready && !_load_state.cancel) {
+      _swapWorkspace(*_staging);
+      swapped = true;
+    }
+    // srrg the staging manager is left with either the discarded graph or an empty workspace
+    _staging.reset();
+    _load_state.phase = LoadPhase::Idle;
+    return swapped;
+  }
+
+  void ConfigurableNodeManager::_discardLoad() {
+    if (!_load_thread.joinable()) {
+      return;
+    }
+    _load_state.cancel = true;
+    _load_thread.join();
+    _staging.reset();
+    _load_state.phase = LoadPhase::Idle;
+  }
+
+  void ConfigurableNodeManager::_stageConfig(const std::string file_,
+                                             ImVec2 pos_,
+                                             LoadState* state_) {
+    try {
+      state_->phase = LoadPhase::Parsing;
+      _openLayoutCache(file_);
+      read(file_);
+
+      if (!state_->cancel) {
+        state_->phase = LoadPhase::Building;
+        const std::vector<PropertyContainerIdentifiablePtr> configs = _visibleInstances();
+        const float total = std::max<size_t>(configs.size(), 1);
+        size_t built      = 0;
+        for (PropertyContainerIdentifiablePtr config : configs) {
+          if (state_->cancel) {
+            break;
+          }
+          if (_nodes.find(config) == _nodes.end()) {
+            _insertNode(config);
+          }
+          state_->progress = ++built / total;
+        }
+      }
+
+      if (!state_->cancel) {
+        state_->phase = LoadPhase::Connecting;
+        _connectNodes(_nodes);
+        _updateHiddenCounts(_nodes);
+        _indexHiddenInstances();
+      }
+
+      if (!state_->cancel) {
+        state_->phase = LoadPhase::Layout;
+        _placeNodes(_nodes, pos_);
+      }
+      state_->phase = state_->cancel ? LoadPhase::Cancelled : LoadPhase::Ready;
+    } catch (const std::exception& e) {
+      std::cerr << "ConfigurableNodeManager::_stageConfig|unable to load [ " << file_
+                << " ]: " << e.what() << std::endl;
+      state_->phase = LoadPhase::Failed;
+    }
+  }
+
+  void ConfigurableNodeManager::_swapWorkspace(ConfigurableNodeManager& staged_) {
+    // srrg the staged nodes took the ids after the current ones, do not hand them out again
+    _clearLinks(false);
+    _clearNodes(false);
+
+    // srrg the whole base goes along, its bookkeeping (names, ids, hidden lazy instances) must
+    // describe the swapped instances and nothing of the previous config
+    std::swap(static_cast<ConfigurableManager&>(*this), static_cast<ConfigurableManager&>(staged_));
+    std::swap(_nodes, staged_._nodes);
+    std::swap(_node_index, staged_._node_index);
+    std::swap(_pin_index, staged_._pin_index);
+    std::swap(_links, staged_._links);
+    std::swap(_search_index, staged_._search_index);
+    std::swap(_hidden_documents, staged_._hidden_documents);
+
+    // srrg the cache of the previous config is written before it goes away
+    saveLayoutCache();
+    std::swap(_layout_cache, staged_._layout_cache);
+    std::swap(_layout_cache_file, staged_._layout_cache_file);
+
+    // srrg pending relayouts refer to the previous graph, the staged one is placed already
+    _dirty_nodes.clear();
+    staged_._dirty_nodes.clear();
+    _moved_nodes = 0;
+    _applyPositions(_nodes);
+  }
+
   void ConfigurableNodeManager::deleteConfigurable(PropertyContainerIdentifiablePtr configurable_) {
-    _releaseLinks(_nodes[configurable_]);
-    _nodes.erase(configurable_);
+    auto n_it = _nodes.find(configurable_);
+    if (n_it != _nodes.end()) {
+      // srrg the hidden children would be lost with their only visible parent
+      for (const PinPtr& pin : n_it->second->outputPins()) {
+        if (pin->hiddenDescendants()) {
+          expand(n_it->second, pin->paramName());
+        }
+      }
+      std::vector<ConfigNodePtr> children;
+      if (_incremental_layout) {
+        for (const auto& l : n_it->second->outputLinks()) {
+          children.push_back(l.second->child);
+        }
+      }
+      _releaseLinks(n_it->second);
+      _eraseNode(configurable_);
+      for (const ConfigNodePtr& child : children) {
+        if (!child->inputLinks().empty()) {
+          _markDirty(child, true);
+        }
+      }
+    }
     erase(configurable_);
+    _indexHiddenInstances();
   }
 
-  void ConfigurableNodeManager::_computeHierarchy(ImVec2 pos_) {
+  void ConfigurableNodeManager::_computeHierarchy(ImVec2 pos_, const bool& use_cache_) {
     _clearLinks();
-    int adjac_matrix_size = _nodes.size();
-    std::map<PropertyContainerIdentifiablePtr, size_t> bookkeeping;
-    size_t i = 0;
-    for (auto n : _nodes) {
-      n.second->internals();
-      n.second->computeSize();
-      bookkeeping.insert(std::make_pair(n.first, i));
-      ++i;
+    _connectNodes(_nodes);
+    _updateHiddenCounts(_nodes);
+    if (_layout_caching && !use_cache_) {
+      _computeLayoutKeys();
     }
-    srrg2_core::Matrix_<int> config_adjacency_matrix;
-    config_adjacency_matrix.resize(adjac_matrix_size, adjac_matrix_size);
+    _computeLayout(_nodes, pos_, use_cache_);
+    // srrg every node was just placed
+    _dirty_nodes.clear();
+    _indexHiddenInstances();
+  }
+
+  void ConfigurableNodeManager::_connectNodes(const NodeMap& parents_, const NodeMap* children_) {
     // mc create connections
-    for (const auto& node_pair : _nodes) {
+    for (const auto& node_pair : parents_) {
       ConfigNodePtr parent = node_pair.second;
       std::multimap<std::string, PropertyContainerIdentifiablePtr> connected_configs;
       parent->configurable()->getConnectedContainers(connected_configs);
@@ -291,227 +569,778 @@ namespace srrg2_core {
         if (!c) {
           continue;
         }
+        if (children_ && children_->find(c) == children_->end()) {
+          continue;
+        }
         if (_nodes.find(c) == _nodes.end()) {
+          // srrg collapsed by the lazy mode, counted in the stub of the parent output
+          if (_instances.count(c)) {
+            continue;
+          }
           std::cerr << "Please add this module manually to the config: " << std::endl;
           std::cerr << "  " << node_pair.first->className() << "->" << c->className() << std::endl;
           continue;
         }
         auto child = _nodes.at(c);
         NodeLinkPtr link(new NodeLink(ed_counter_links++, parent, elem.first));
-        updateConnection(link, child);
-        _links.emplace_back(link);
-        config_adjacency_matrix(bookkeeping[parent->configurable()],
-                                bookkeeping[child->configurable()]) = 1;
+        if (updateConnection(link, child)) {
+          _addLink(link);
+        }
       }
     }
+  }
 
-    std::multimap<int, ConfigNodePtr> sources;
-    _computeSources(config_adjacency_matrix, bookkeeping, 0, sources);
-    _computeNodesPose(pos_, sources);
+  void ConfigurableNodeManager::_buildConfigNodes() {
+    for (PropertyContainerIdentifiablePtr config : _visibleInstances()) {
+      if (_nodes.find(config) != _nodes.end()) {
+        continue;
+      }
+      _insertNode(config);
+    }
+    _computeHierarchy(ImVec2(100, 100));
   }
 
-  void ConfigurableNodeManager::_computeSources(
-    const Matrix_<int>& matrix_,
-    const std::map<PropertyContainerIdentifiablePtr, size_t>& bookkeeping_,
-    int level_,
-    std::multimap<int, ConfigNodePtr>& sources_) {
-    std::vector<PropertyContainerIdentifiablePtr> sources_to_delete;
-    //    for (size_t r = 0; r < matrix_.rows(); ++r) {
-    //      for (size_t c = 0; c < matrix_.cols(); ++c) {
-    //        std::cerr << matrix_(r, c) << " ";
-    //      }
-    //      std::cerr << std::endl;
-    //    }
-    //    std::cerr << "level " << level_ << " sources:\n";
-    for (size_t c = 0; c < matrix_.cols(); ++c) {
-      int c_sum = 0;
-      for (size_t r = 0; r < matrix_.rows(); ++r) {
-        c_sum += matrix_(r, c);
-      }
-      if (c_sum == 0) {
-        PropertyContainerIdentifiablePtr to_delete;
-        for (auto b : bookkeeping_) {
-          if (b.second == c) {
-            to_delete = b.first;
-            break;
-          }
+  std::vector<PropertyContainerIdentifiablePtr> ConfigurableNodeManager::_rootInstances() const {
+    std::set<PropertyContainerIdentifiable*> children;
+    for (const PropertyContainerIdentifiablePtr& config : _instances) {
+      std::multimap<std::string, PropertyContainerIdentifiablePtr> connected_configs;
+      config->getConnectedContainers(connected_configs);
+      for (const auto& elem : connected_configs) {
+        children.insert(elem.second.get());
+      }
+    }
+    std::vector<PropertyContainerIdentifiablePtr> roots;
+    for (const PropertyContainerIdentifiablePtr& config : _instances) {
+      if (!children.count(config.get())) {
+        roots.push_back(config);
+      }
+    }
+    return roots;
+  }
+
+  std::vector<PropertyContainerIdentifiablePtr> ConfigurableNodeManager::_visibleInstances() const {
+    if (_lazy_depth < 0) {
+      return std::vector<PropertyContainerIdentifiablePtr>(_instances.begin(), _instances.end());
+    }
+
+    return _lazyInstances(_rootInstances());
+  }
+
+  std::vector<PropertyContainerIdentifiablePtr> ConfigurableNodeManager::_lazyInstances(
+    const std::vector<PropertyContainerIdentifiablePtr>& roots_) const {
+    // srrg breadth first, a shared instance takes the depth of its closest root
+    std::vector<PropertyContainerIdentifiablePtr> configs;
+    std::set<PropertyContainerIdentifiable*> visited;
+    std::deque<std::pair<PropertyContainerIdentifiablePtr, int>> queue;
+    for (const PropertyContainerIdentifiablePtr& root : roots_) {
+      if (root && visited.insert(root.get()).second) {
+        queue.push_back(std::make_pair(root, 0));
+      }
+    }
+
+    while (!queue.empty()) {
+      const PropertyContainerIdentifiablePtr config = queue.front().first;
+      const int depth                               = queue.front().second;
+      queue.pop_front();
+      if (_nodes.find(config) == _nodes.end()) {
+        configs.push_back(config);
+      }
+      if (depth >= _lazy_depth) {
+        continue;
+      }
+
+      std::multimap<std::string, PropertyContainerIdentifiablePtr> connected_configs;
+      config->getConnectedContainers(connected_configs);
+      for (const auto& elem : connected_configs) {
+        const PropertyContainerIdentifiablePtr& c = elem.second;
+        if (!c || _nodes.find(c) != _nodes.end() || !visited.insert(c.get()).second) {
+          continue;
         }
-        //        std::cerr << "\t" << _nodes[to_delete]->name() << " " <<
-        //        _nodes[to_delete]->id()
-        //        << " col: " << c << " conf: " << to_delete << std::endl;
-        sources_.insert(std::make_pair(level_, _nodes[to_delete]));
-        sources_to_delete.push_back(to_delete);
+        queue.push_back(std::make_pair(c, depth + 1));
       }
     }
-    //    std::cerr << std::endl;
-    size_t submatrix_size = matrix_.rows() - sources_to_delete.size();
-    if (!submatrix_size) {
-      return;
+    return configs;
+  }
+
+  NodeMap
+  ConfigurableNodeManager::_materialize(const std::vector<PropertyContainerIdentifiablePtr>& configs_) {
+    // srrg collapsed outputs may point to the new nodes, their counts are rebuilt below. Zeroing
+    // them first keeps updateConnection from expanding what is being connected
+    NodeMap frontier;
+    if (_nodes.size() < _instances.size()) {
+      for (const auto& n : _nodes) {
+        for (const PinPtr& pin : n.second->_pins) {
+          if (pin->hiddenDescendants()) {
+            frontier.insert(n);
+            pin->setHiddenDescendants(0);
+          }
+        }
+      }
     }
-    std::map<PropertyContainerIdentifiablePtr, size_t> bookkeeping;
-    std::vector<size_t> sources_idx;
-    int i = 0;
-    for (auto b : bookkeeping_) {
-      if (std::find(sources_to_delete.begin(), sources_to_delete.end(), b.first) ==
-          sources_to_delete.end()) {
-        bookkeeping.insert(std::make_pair(b.first, i++));
-      } else {
-        //        std::cerr << b.first->className() << " " << b.first << " c: "
-        //        << b.second << std::endl;
-        sources_idx.push_back(b.second);
+
+    NodeMap created_nodes;
+    for (const PropertyContainerIdentifiablePtr& config : configs_) {
+      if (_nodes.find(config) != _nodes.end()) {
+        continue;
       }
+      created_nodes.insert(std::make_pair(config, _insertNode(config)));
     }
-    if (submatrix_size < 2) {
-      ConfigNodePtr n = _nodes[bookkeeping.begin()->first];
-      sources_.insert(std::make_pair(++level_, n));
-      //      std::cerr << "level " << level_ << " sources:\n";
-      //      std::cerr << "\t" << n->name() << " " << n->id() << " col: " << 0
-      //      << std::endl;
+    _connectNodes(created_nodes);
+    _connectNodes(frontier, &created_nodes);
+
+    frontier.insert(created_nodes.begin(), created_nodes.end());
+    _updateHiddenCounts(frontier);
+    _indexHiddenInstances();
+    return created_nodes;
+  }
+
+  void ConfigurableNodeManager::_updateHiddenCounts(const NodeMap& nodes_) {
+    // srrg nothing can be hidden when every instance has a node
+    if (_nodes.size() >= _instances.size()) {
+      for (const auto& n : nodes_) {
+        for (const PinPtr& pin : n.second->_pins) {
+          pin->setHiddenDescendants(0);
+        }
+      }
       return;
     }
-    Matrix_<int> other_matrix(submatrix_size, submatrix_size);
-    int k = 0;
-    for (size_t r = 0; r < matrix_.rows(); ++r) {
-      for (size_t c = 0; c < matrix_.cols(); ++c) {
-        bool add_to_new_matrix = false;
-        for (size_t i = 0; i < sources_idx.size(); ++i) {
-          const size_t& idx_to_delete = sources_idx[i];
-          if (r == idx_to_delete || c == idx_to_delete) {
-            add_to_new_matrix = false;
-            break;
-          } else {
-            add_to_new_matrix = true;
+
+    // srrg the children of a hidden instance are fetched once for the whole batch, shared
+    // subtrees are walked again for each output but only over indices
+    struct HiddenInstance {
+      PropertyContainerIdentifiablePtr config;
+      std::vector<size_t> children;
+      bool has_children = false;
+      size_t stamp      = 0;
+    };
+    std::vector<HiddenInstance> hidden;
+    std::unordered_map<PropertyContainerIdentifiable*, size_t> hidden_index;
+    auto hiddenIndex = [&](const PropertyContainerIdentifiablePtr& config_) -> int {
+      if (!config_ || _nodes.find(config_) != _nodes.end() || !_instances.count(config_)) {
+        return -1;
+      }
+      auto h_it = hidden_index.find(config_.get());
+      if (h_it != hidden_index.end()) {
+        return h_it->second;
+      }
+      hidden_index.insert(std::make_pair(config_.get(), hidden.size()));
+      hidden.emplace_back();
+      hidden.back().config = config_;
+      return hidden.size() - 1;
+    };
+
+    size_t stamp = 0;
+    std::vector<size_t> stack;
+    for (const auto& n : nodes_) {
+      std::multimap<std::string, PropertyContainerIdentifiablePtr> connected_configs;
+      n.second->configurable()->getConnectedContainers(connected_configs);
+
+      for (size_t p = 1; p < n.second->_pins.size(); ++p) {
+        const PinPtr& pin = n.second->_pins[p];
+        auto range        = connected_configs.equal_range(pin->paramName());
+        for (auto c_it = range.first; c_it != range.second; ++c_it) {
+          const int index = hiddenIndex(c_it->second);
+          if (index >= 0) {
+            stack.push_back(index);
           }
         }
-        if (add_to_new_matrix) {
-          other_matrix.data()[k++] = matrix_(r, c);
+
+        ++stamp;
+        size_t count = 0;
+        while (!stack.empty()) {
+          const size_t index = stack.back();
+          stack.pop_back();
+          if (hidden[index].stamp == stamp) {
+            continue;
+          }
+          hidden[index].stamp = stamp;
+          ++count;
+
+          if (!hidden[index].has_children) {
+            std::multimap<std::string, PropertyContainerIdentifiablePtr> children;
+            hidden[index].config->getConnectedContainers(children);
+            std::vector<size_t> child_indices;
+            for (const auto& elem : children) {
+              const int child = hiddenIndex(elem.second);
+              if (child >= 0) {
+                child_indices.push_back(child);
+              }
+            }
+            hidden[index].children     = std::move(child_indices);
+            hidden[index].has_children = true;
+          }
+          for (const size_t& child : hidden[index].children) {
+            if (hidden[child].stamp != stamp) {
+              stack.push_back(child);
+            }
+          }
         }
+        pin->setHiddenDescendants(count);
       }
     }
-    _computeSources(other_matrix, bookkeeping, ++level_, sources_);
   }
 
-  void ConfigurableNodeManager::_buildConfigNodes() {
-    for (PropertyContainerIdentifiablePtr config : _instances) {
+  void ConfigurableNodeManager::_indexHiddenInstances() {
+    for (auto d_it = _hidden_documents.begin(); d_it != _hidden_documents.end();) {
+      if (_nodes.find(d_it->second) != _nodes.end() || !_instances.count(d_it->second)) {
+        _search_index.erase(d_it->first);
+        d_it = _hidden_documents.erase(d_it);
+      } else {
+        ++d_it;
+      }
+    }
+    if (_nodes.size() >= _instances.size()) {
+      return;
+    }
+
+    for (const PropertyContainerIdentifiablePtr& config : _instances) {
       if (_nodes.find(config) != _nodes.end()) {
         continue;
       }
-      ConfigNodePtr node(new ConfigNode(config));
-      _nodes.insert(std::make_pair(config, node));
+      const uint64_t document = hiddenDocument(config.get());
+      if (_hidden_documents.insert(std::make_pair(document, config)).second) {
+        _search_index.set(document, ConfigNode::searchFields(config));
+      }
     }
-    refreshView(ImVec2(100, 100));
   }
 
-  void
-  ConfigurableNodeManager::_computeNodesPose(ImVec2 init_pose_,
-                                             const std::multimap<int, ConfigNodePtr>& sources_) {
-    static const ImVec2 padding = ImVec2(20, 20);
-    int levels                  = 0;
-    for (auto it = sources_.begin(); it != sources_.end(); ++it) {
-      levels = std::max<int>(levels, it->first);
+  void ConfigurableNodeManager::focusDocument(const uint64_t& document_) {
+    if (!isHiddenDocument(document_)) {
+      focusNode(findNode(ax::NodeEditor::NodeId(document_)));
+      return;
     }
+    auto d_it = _hidden_documents.find(document_);
+    if (d_it != _hidden_documents.end()) {
+      _focus_hidden = d_it->second;
+    }
+  }
 
-    std::vector<BoundingBox> bb_per_level;
-    bb_per_level.resize(levels + 1);
-    int prev_level = 0;
-    for (auto it = sources_.begin(); it != sources_.end(); ++it) {
-      const int& level   = it->first;
-      ConfigNodePtr node = it->second;
+  ConfigNodePtr ConfigurableNodeManager::_expandTo(const PropertyContainerIdentifiablePtr& hidden_) {
+    auto n_it = _nodes.find(hidden_);
+    if (n_it != _nodes.end()) {
+      return n_it->second;
+    }
 
-      // srrg compute level bounding boxes
-      if (it == sources_.begin()) {
-        bb_per_level[level].pos  = init_pose_;
-        _curr_y_bb               = init_pose_.y;
-        bb_per_level[level].size = node->node_bb.size + padding;
-        continue;
+    // srrg breadth first from the nodes over the hidden instances, each one keeps the output it
+    // was first reached from
+    struct Step {
+      PropertyContainerIdentifiablePtr parent;
+      std::string param_name;
+    };
+    std::unordered_map<PropertyContainerIdentifiable*, Step> steps;
+    std::deque<PropertyContainerIdentifiablePtr> queue;
+    for (const auto& n : _nodes) {
+      queue.push_back(n.first);
+    }
+    while (!queue.empty() && !steps.count(hidden_.get())) {
+      const PropertyContainerIdentifiablePtr config = queue.front();
+      queue.pop_front();
+      std::multimap<std::string, PropertyContainerIdentifiablePtr> connected_configs;
+      config->getConnectedContainers(connected_configs);
+      for (const auto& elem : connected_configs) {
+        const PropertyContainerIdentifiablePtr& c = elem.second;
+        if (!c || _nodes.find(c) != _nodes.end() || !_instances.count(c) || steps.count(c.get())) {
+          continue;
+        }
+        steps.insert(std::make_pair(c.get(), Step{config, elem.first}));
+        queue.push_back(c);
       }
+    }
+
+    std::vector<const Step*> path;
+    auto s_it = steps.find(hidden_.get());
+    while (s_it != steps.end()) {
+      path.push_back(&s_it->second);
+      s_it = steps.find(s_it->second.parent.get());
+    }
+    if (path.empty()) {
+      std::cerr << "ConfigurableNodeManager::_expandTo|no node leads to [ " << hidden_->className()
+                << " ]" << std::endl;
+      return nullptr;
+    }
+    // srrg from the node down, each expansion gives a node to the parent of the next step
+    for (auto p_it = path.rbegin(); p_it != path.rend(); ++p_it) {
+      expand(_nodes.at((*p_it)->parent), (*p_it)->param_name);
+    }
+    n_it = _nodes.find(hidden_);
+    return n_it == _nodes.end() ? nullptr : n_it->second;
+  }
+
+  ConfigNodePtr
+  ConfigurableNodeManager::_insertNode(const PropertyContainerIdentifiablePtr& configurable_) {
+    ConfigNodePtr node(new ConfigNode(configurable_));
+    _frames_to_settle = 2;
+    _nodes.insert(std::make_pair(configurable_, node));
+    _node_index.insert(std::make_pair(node->ID().Get(), node));
+    for (const PinPtr& pin : node->_pins) {
+      _pin_index.insert(std::make_pair(pin->ID().Get(), std::make_pair(node, pin)));
+    }
+    _search_index.set(node->ID().Get(), node->searchFields());
+    return node;
+  }
+
+  void ConfigurableNodeManager::_eraseNode(const PropertyContainerIdentifiablePtr& configurable_) {
+    auto n_it = _nodes.find(configurable_);
+    if (n_it == _nodes.end()) {
+      return;
+    }
+    ConfigNodePtr node = n_it->second;
+    for (const PinPtr& pin : node->_pins) {
+      _pin_index.erase(pin->ID().Get());
+    }
+    _node_index.erase(node->ID().Get());
+    _dirty_nodes.erase(node);
+    _search_index.erase(node->ID().Get());
+    _highlighted.erase(node->ID().Get());
+    if (_focus_request == node) {
+      _focus_request = nullptr;
+    }
+    _nodes.erase(n_it);
+  }
+
+  void ConfigurableNodeManager::_computeLayout(const NodeMap& nodes_,
+                                               ImVec2 origin_,
+                                               const bool& use_cache_) {
+    _size_model.setMetrics(currentFontMetrics());
+    _placeNodes(nodes_, origin_, use_cache_);
+    _applyPositions(nodes_);
+  }
+
+  void ConfigurableNodeManager::_placeNodes(const NodeMap& nodes_,
+                                            ImVec2 origin_,
+                                            const bool& use_cache_) {
+    if (_layout_caching && use_cache_) {
+      _computeLayoutKeys();
+    }
 
-      if (prev_level != level) {
-        bb_per_level[level].pos = bb_per_level[prev_level].pos;
-        bb_per_level[level].pos.x += bb_per_level[prev_level].size.x;
-        bb_per_level[level].size = node->node_bb.size + padding;
+    // srrg index the nodes in map order, only links among them constrain the layout
+    std::unordered_map<const ConfigNode*, size_t> bookkeeping;
+    std::vector<ConfigNodePtr> indexed_nodes;
+    std::vector<LayoutVec2> sizes, positions;
+    std::vector<std::string> keys;
+    bookkeeping.reserve(nodes_.size());
+    indexed_nodes.reserve(nodes_.size());
+    sizes.reserve(nodes_.size());
+    positions.reserve(nodes_.size());
+    keys.reserve(nodes_.size());
+    bool has_cached    = false;
+    float cached_right = origin_.x;
+    for (const auto& n : nodes_) {
+      const ConfigNodePtr& node = n.second;
+
+      // srrg nodes drawn at least once know their size, the others are estimated
+      LayoutVec2 size;
+      if (node->isMeasured()) {
+        size = LayoutVec2(node->bounds().GetWidth(), node->bounds().GetHeight());
       } else {
-        bb_per_level[level].size.x =
-          std::max<float>(bb_per_level[level].size.x, node->node_bb.size.x + padding.x);
+        size = _size_model.estimate(node->describe());
+      }
+
+      const LayoutVec2* cached = nullptr;
+      if (use_cache_ && _layout_caching) {
+        cached = _layout_cache.find(node->_layout_key);
+      }
+      if (cached) {
+        node->node_bb.pos  = ImVec2(cached->x, cached->y);
+        node->node_bb.size = ImVec2(size.x, size.y);
+        cached_right       = std::max(cached_right, cached->x + size.x);
+        has_cached         = true;
+        continue;
       }
-      prev_level = level;
+
+      bookkeeping.insert(std::make_pair(node.get(), indexed_nodes.size()));
+      indexed_nodes.emplace_back(node);
+      sizes.emplace_back(size);
+      positions.emplace_back(node->node_bb.pos.x, node->node_bb.pos.y);
+      keys.emplace_back(node->name());
+    }
+
+    // srrg new and moved nodes go right of the cached ones
+    if (has_cached) {
+      origin_.x = cached_right + _layout_engine.padding.x;
     }
 
-    float max_bb_y = 0;
-    for (int i = 0; i < levels + 1; ++i) {
-      //      std::cerr << "level[" << i << "]: " << bb_per_level[i].pos.x << " " <<
-      //      bb_per_level[i].pos.y
-      //                << " s: " << bb_per_level[i].size.x << "x" << bb_per_level[i].size.y << " "
-      //                << std::endl;
-      max_bb_y = std::max(max_bb_y, bb_per_level[i].size.y);
-      ImRect rect;
+    LayoutGraph graph(indexed_nodes.size());
+    for (size_t p = 0; p < indexed_nodes.size(); ++p) {
+      for (const auto& link : indexed_nodes[p]->outputLinks()) {
+        auto c_it = bookkeeping.find(link.second->child.get());
+        if (c_it != bookkeeping.end()) {
+          graph.addEdge(p, c_it->second);
+        }
+      }
     }
-    // srrg set node poses
-    _computeSortedNodePoses(bb_per_level, sources_);
 
-    for (auto node : sources_) {
-      //      ImVec2 fixed_pos = node.second->node_bb.pos;
-      //      node.second->node_bb.pos.y -= bb_per_level[0].pos.y * .5;
-      //      node.second->node_bb.pos.y += node.second->node_bb.size.y * .5;
-      ax::NodeEditor::SetNodePosition(node.second->ID(), node.second->node_bb.pos);
+    _layout_engine.compute(graph, sizes, keys, LayoutVec2(origin_.x, origin_.y), positions);
+
+    for (size_t i = 0; i < indexed_nodes.size(); ++i) {
+      ConfigNodePtr& node = indexed_nodes[i];
+      node->node_bb.size  = ImVec2(sizes[i].x, sizes[i].y);
+      node->node_bb.pos   = ImVec2(positions[i].x, positions[i].y);
+      if (_layout_caching && !node->_layout_key.empty()) {
+        _layout_cache.set(node->_layout_key, positions[i]);
+      }
     }
   }
 
-  void ConfigurableNodeManager::_computeSortedNodePoses(
-    ConfigNodePtr parent_node_,
-    const size_t& lvl_,
-    const std::vector<BoundingBox>& bb_,
-    const std::multimap<int, ConfigNodePtr>& sources_) {
-    static const ImVec2 padding      = ImVec2(20, 20);
-    static const ImVec2 half_padding = ImVec2(8, 8);
+  void ConfigurableNodeManager::_computeLayoutKeys() {
+    // srrg roots in class and name order, so that a shared instance is reached through the same
+    // path on every run whatever the order of the instances in memory
+    std::vector<PropertyContainerIdentifiablePtr> roots = _rootInstances();
+    auto byIdentity = [](const PropertyContainerIdentifiablePtr& a_,
+                         const PropertyContainerIdentifiablePtr& b_) {
+      if (a_->className() != b_->className()) {
+        return a_->className() < b_->className();
+      }
+      return a_->name() < b_->name();
+    };
+    std::stable_sort(roots.begin(), roots.end(), byIdentity);
+
+    // srrg instances only reachable through a cycle start a path of their own
+    std::vector<PropertyContainerIdentifiablePtr> others(_instances.begin(), _instances.end());
+    std::stable_sort(others.begin(), others.end(), byIdentity);
+    roots.insert(roots.end(), others.begin(), others.end());
+
+    std::unordered_map<PropertyContainerIdentifiable*, std::string> keys;
+    std::unordered_map<std::string, size_t> root_counts;
+    std::deque<PropertyContainerIdentifiablePtr> queue;
+    keys.reserve(_instances.size());
+    for (const PropertyContainerIdentifiablePtr& root : roots) {
+      if (keys.count(root.get())) {
+        continue;
+      }
+      std::string key = root->className() + ":" + root->name();
+      const size_t count = root_counts[key]++;
+      if (count) {
+        key += "#" + std::to_string(count);
+      }
+      keys.insert(std::make_pair(root.get(), key));
+      queue.push_back(root);
 
-    const float prev_y_bb = _curr_y_bb;
+      while (!queue.empty()) {
+        const PropertyContainerIdentifiablePtr config = queue.front();
+        queue.pop_front();
+        const std::string& parent_key = keys.at(config.get());
 
-    for (auto con : parent_node_->outputLinks()) {
-      auto cn = con.second->child;
-      _computeSortedNodePoses(cn, lvl_ + 1, bb_, sources_);
+        std::multimap<std::string, PropertyContainerIdentifiablePtr> connected_configs;
+        config->getConnectedContainers(connected_configs);
+        std::string param_name;
+        size_t index = 0;
+        for (const auto& elem : connected_configs) {
+          index      = elem.first == param_name ? index + 1 : 0;
+          param_name = elem.first;
+          const PropertyContainerIdentifiablePtr& c = elem.second;
+          if (!c || !_instances.count(c) || keys.count(c.get())) {
+            continue;
+          }
+          keys.insert(std::make_pair(c.get(),
+                                     parent_key + "/" + param_name + "[" + std::to_string(index) +
+                                       "]=" + c->className() + ":" + c->name()));
+          queue.push_back(c);
+        }
+      }
     }
 
-    parent_node_->node_bb.pos.x = bb_[lvl_].pos.x + half_padding.x;
-    if (parent_node_->outputLinks().size()) {
-      parent_node_->node_bb.pos.y =
-        prev_y_bb + (_curr_y_bb - prev_y_bb) * .5f - parent_node_->node_bb.size.y * .5f;
-      float tmp = prev_y_bb + parent_node_->node_bb.size.y + padding.y;
-      if (tmp > _curr_y_bb) {
-        parent_node_->node_bb.pos.y = prev_y_bb + half_padding.y;
-        _curr_y_bb                  = tmp;
+    for (const auto& n : _nodes) {
+      auto k_it = keys.find(n.first.get());
+      if (k_it != keys.end()) {
+        n.second->_layout_key = k_it->second;
       }
-    } else {
-      parent_node_->node_bb.pos.y = prev_y_bb + half_padding.y;
-      _curr_y_bb                  = prev_y_bb + parent_node_->node_bb.size.y + padding.y;
     }
   }
 
-  void ConfigurableNodeManager::_computeSortedNodePoses(
-    const std::vector<BoundingBox>& bb_,
-    const std::multimap<int, ConfigNodePtr>& sources_) {
-    std::vector<ConfigNodePtr> sorted_sources(sources_.count(0));
-    for (size_t i = 0; i < sorted_sources.size(); ++i) {
-      sorted_sources[i] = (std::next(sources_.begin(), i))->second;
+  void ConfigurableNodeManager::_openLayoutCache(const std::string& config_file_) {
+    if (!_layout_caching) {
+      return;
+    }
+    saveLayoutCache();
+    _layout_cache_file = layoutCacheFile(config_file_);
+    if (_layout_cache.load(_layout_cache_file)) {
+      std::cerr << "ConfigurableNodeManager::_openLayoutCache|restoring [ " << _layout_cache.size()
+                << " ] positions from [ " << _layout_cache_file << " ]" << std::endl;
+    }
+  }
+
+  bool ConfigurableNodeManager::saveLayoutCache(const std::string& file_) {
+    if (!_layout_caching) {
+      return false;
+    }
+    if (file_.length()) {
+      _layout_cache_file = file_;
+    } else if (!_layout_cache.isDirty()) {
+      return true;
+    }
+    if (!_layout_cache_file.length()) {
+      return false;
+    }
+    return _layout_cache.save(_layout_cache_file);
+  }
+
+  void ConfigurableNodeManager::configureEditor(ax::NodeEditor::Config& config_) {
+    config_.SaveNodeSettings = &ConfigurableNodeManager::_saveNodeSettings;
+    config_.LoadNodeSettings = &ConfigurableNodeManager::_loadNodeSettings;
+    config_.UserPointer      = this;
+    // srrg the layout never overlaps nodes, they can share the draw layers instead of taking
+    // five channels each
+    config_.SharedNodeChannels = true;
+  }
+
+  bool ConfigurableNodeManager::_saveNodeSettings(ax::NodeEditor::NodeId id_,
+                                                  const char* data_,
+                                                  size_t size_,
+                                                  ax::NodeEditor::SaveReasonFlags reason_,
+                                                  void* manager_) {
+    ConfigurableNodeManager* manager = static_cast<ConfigurableNodeManager*>(manager_);
+    const ConfigNodePtr node         = manager->findNode(id_);
+    // srrg nothing to keep for nodes that are gone, the editor may stop asking
+    if (!manager->_layout_caching || !node || node->_layout_key.empty()) {
+      return true;
+    }
+    ax::NodeEditor::Detail::NodeSettings settings(id_);
+    if (!ax::NodeEditor::Detail::NodeSettings::Parse(std::string(data_, size_), settings)) {
+      return false;
+    }
+    manager->_layout_cache.set(node->_layout_key,
+                               LayoutVec2(settings.m_Location.x, settings.m_Location.y));
+    return true;
+  }
+
+  size_t ConfigurableNodeManager::_loadNodeSettings(ax::NodeEditor::NodeId id_,
+                                                    char* data_,
+                                                    void* manager_) {
+    ConfigurableNodeManager* manager = static_cast<ConfigurableNodeManager*>(manager_);
+    const ConfigNodePtr node         = manager->findNode(id_);
+    if (!manager->_layout_caching || !node) {
+      return 0;
+    }
+    const LayoutVec2* cached = manager->_layout_cache.find(node->_layout_key);
+    if (!cached) {
+      return 0;
+    }
+    // srrg the editor asks for the size first, then for the data
+    ax::NodeEditor::Detail::NodeSettings settings(id_);
+    settings.m_Location     = ImVec2(cached->x, cached->y);
+    const std::string state = settings.Serialize().dump();
+    if (data_) {
+      std::memcpy(data_, state.data(), state.size());
+    }
+    return state.size();
+  }
+
+  void ConfigurableNodeManager::_applyPositions(const NodeMap& nodes_) {
+    _frames_to_settle = 2;
+    for (const auto& n : nodes_) {
+      const ConfigNodePtr& node = n.second;
+      ax::NodeEditor::SetNodePosition(node->ID(), node->node_bb.pos);
+      // srrg keep the culling rect in sync with the new position
+      node->_bounds.Translate(node->node_bb.pos - node->_bounds.Min);
+    }
+  }
+
+  size_t ConfigurableNodeManager::relayoutDirty() {
+    _moved_nodes = 0;
+    if (_dirty_nodes.empty()) {
+      return 0;
+    }
+    _size_model.setMetrics(currentFontMetrics());
+    if (_layout_caching) {
+      _computeLayoutKeys();
     }
 
-    std::sort(sorted_sources.begin(), sorted_sources.end(), [](ConfigNodePtr a_, ConfigNodePtr b_) {
-      return std::string(a_->name()) < std::string(b_->name());
+    // srrg the marked nodes still on the canvas, plus the descendants of the re-parented ones
+    // that are not reached from anywhere else
+    std::unordered_set<const ConfigNode*> region;
+    std::vector<ConfigNodePtr> region_nodes;
+    std::deque<ConfigNodePtr> queue;
+    for (const auto& d : _dirty_nodes) {
+      const ConfigNodePtr& node = d.first;
+      if (!_node_index.count(node->ID().Get()) || !region.insert(node.get()).second) {
+        continue;
+      }
+      region_nodes.push_back(node);
+      if (d.second) {
+        queue.push_back(node);
+      }
+    }
+    _dirty_nodes.clear();
+
+    while (!queue.empty()) {
+      const ConfigNodePtr node = queue.front();
+      queue.pop_front();
+      for (const auto& l : node->outputLinks()) {
+        const ConfigNodePtr& child = l.second->child;
+        if (!child || region.count(child.get())) {
+          continue;
+        }
+        bool is_exclusive = true;
+        for (const NodeLinkPtr& i : child->inputLinks()) {
+          if (!region.count(i->parent().get())) {
+            is_exclusive = false;
+            break;
+          }
+        }
+        if (is_exclusive) {
+          region.insert(child.get());
+          region_nodes.push_back(child);
+          queue.push_back(child);
+        }
+      }
+    }
+
+    // srrg each root of the region is placed with the region nodes below it
+    std::vector<ConfigNodePtr> roots;
+    for (const ConfigNodePtr& node : region_nodes) {
+      const auto& i_links = node->inputLinks();
+      if (std::none_of(i_links.begin(), i_links.end(), [&region](const NodeLinkPtr& l_) {
+            return region.count(l_->parent().get());
+          })) {
+        roots.push_back(node);
+      }
+    }
+    std::sort(roots.begin(), roots.end(), [](const ConfigNodePtr& a_, const ConfigNodePtr& b_) {
+      return a_->ID().Get() < b_->ID().Get();
     });
-    for (auto s_s : sorted_sources) {
-      _computeSortedNodePoses(s_s, 0, bb_, sources_);
+
+    auto nodeRect = [](const ConfigNodePtr& node_) {
+      if (node_->isMeasured()) {
+        return node_->bounds();
+      }
+      return ImRect(node_->node_bb.pos, node_->node_bb.pos + node_->node_bb.size);
+    };
+
+    // srrg region nodes not placed yet are not obstacles
+    std::unordered_set<const ConfigNode*> skip = region;
+    std::unordered_set<const ConfigNode*> assigned;
+    // srrg new nodes reach the editor even if they stay where they were created
+    NodeMap placed;
+    size_t num_moved = 0;
+    for (const ConfigNodePtr& root : roots) {
+      NodeMap group;
+      std::unordered_map<const ConfigNode*, ImVec2> previous;
+      std::vector<ConfigNodePtr> stack(1, root);
+      assigned.insert(root.get());
+      while (!stack.empty()) {
+        const ConfigNodePtr node = stack.back();
+        stack.pop_back();
+        group.insert(std::make_pair(node->configurable(), node));
+        previous.insert(std::make_pair(node.get(), node->node_bb.pos));
+        for (const auto& l : node->outputLinks()) {
+          const ConfigNodePtr& child = l.second->child;
+          if (child && region.count(child.get()) && assigned.insert(child.get()).second) {
+            stack.push_back(child);
+          }
+        }
+      }
+
+      // srrg right of the rightmost parent outside the region
+      bool is_anchored   = false;
+      float parent_right = -FLT_MAX;
+      ImVec2 origin      = root->node_bb.pos;
+      for (const NodeLinkPtr& l : root->inputLinks()) {
+        const ConfigNodePtr parent = l->parent();
+        if (!parent || region.count(parent.get()) || !_node_index.count(parent->ID().Get())) {
+          continue;
+        }
+        const ImRect rect = nodeRect(parent);
+        if (rect.Max.x > parent_right) {
+          parent_right = rect.Max.x;
+          origin       = ImVec2(rect.Max.x + _layout_engine.padding.x, rect.Min.y);
+        }
+        is_anchored = true;
+      }
+      _placeNodes(group, origin, false);
+
+      if (!is_anchored) {
+        // srrg a root stays where it is, or goes left of its children already on the canvas
+        ImVec2 target       = previous.at(root.get());
+        float children_left = FLT_MAX;
+        for (const auto& l : root->outputLinks()) {
+          const ConfigNodePtr& child = l.second->child;
+          if (!child || region.count(child.get())) {
+            continue;
+          }
+          const ImRect rect = nodeRect(child);
+          if (rect.Min.x < children_left) {
+            children_left = rect.Min.x;
+            target        = ImVec2(
+              rect.Min.x - _layout_engine.padding.x - root->node_bb.size.x, rect.Min.y);
+          }
+        }
+        const ImVec2 shift = target - root->node_bb.pos;
+        for (const auto& n : group) {
+          n.second->node_bb.pos += shift;
+        }
+      }
+
+      // srrg slide the group down until it does not cover the nodes around it
+      ImRect group_rect(ImVec2(FLT_MAX, FLT_MAX), ImVec2(-FLT_MAX, -FLT_MAX));
+      for (const auto& n : group) {
+        const BoundingBox& box = n.second->node_bb;
+        group_rect.Add(ImRect(box.pos, box.pos + box.size));
+      }
+      float bottom = 0;
+      for (size_t i = 0; i < _nodes.size() && _findOverlap(group_rect, skip, bottom); ++i) {
+        const ImVec2 shift(0, bottom + _layout_engine.padding.y - group_rect.Min.y);
+        group_rect.Translate(shift);
+        for (const auto& n : group) {
+          n.second->node_bb.pos += shift;
+        }
+      }
+
+      for (const auto& n : group) {
+        const ConfigNodePtr& node = n.second;
+        skip.erase(node.get());
+        const ImVec2 delta = node->node_bb.pos - previous.at(node.get());
+        const bool has_moved = delta.x * delta.x + delta.y * delta.y > .25f;
+        if (has_moved || !node->isMeasured()) {
+          placed.insert(n);
+        }
+        num_moved += has_moved;
+        if (_layout_caching && !node->_layout_key.empty()) {
+          const ImVec2& pos = node->node_bb.pos;
+          _layout_cache.set(node->_layout_key, LayoutVec2(pos.x, pos.y));
+        }
+      }
     }
+
+    _applyPositions(placed);
+    _moved_nodes = num_moved;
+    return _moved_nodes;
+  }
+
+  bool ConfigurableNodeManager::_findOverlap(const ImRect& bounds_,
+                                             const std::unordered_set<const ConfigNode*>& skip_,
+                                             float& bottom_) const {
+    bool found = false;
+    for (const auto& n : _nodes) {
+      const ConfigNodePtr& node = n.second;
+      if (skip_.count(node.get())) {
+        continue;
+      }
+      const ImRect rect = node->isMeasured()
+                            ? node->bounds()
+                            : ImRect(node->node_bb.pos, node->node_bb.pos + node->node_bb.size);
+      if (rect.Overlaps(bounds_)) {
+        bottom_ = found ? std::max(bottom_, rect.Max.y) : rect.Max.y;
+        found   = true;
+      }
+    }
+    return found;
   }
 
-  void ConfigurableNodeManager::_clearLinks() {
-    for (auto l : _links) {
-      ax::NodeEditor::DeleteLink(l->ID());
+  void ConfigurableNodeManager::_clearLinks(const bool& reset_ids_) {
+    // srrg staged links never reached the editor
+    if (!_is_staging) {
+      for (auto l : _links) {
+        ax::NodeEditor::DeleteLink(l->ID());
+      }
     }
     for (auto n : _nodes) {
       n.second->releaseConnections();
     }
     _links.clear();
-    ed_counter_links = 1e5;
+    if (reset_ids_) {
+      ed_counter_links = 1e5;
+    }
   }
 
 } // namespace srrg2_core
@@ -1,14 +1,25 @@
 #pragma once
 #include "config_node.h"
+#include "frame_profiler.h"
+#include "layout_cache.h"
+#include "layout_engine.h"
+#include "search_index.h"
 #include <srrg_config/configurable_manager.h>
-#include <srrg_data_structures/matrix.h>
 #include <srrg_system_utils/shell_colors.h>
 #include <srrg_system_utils/system_utils.h>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace srrg2_core {
   using NodeMap = std::map<PropertyContainerIdentifiablePtr, ConfigNodePtr>;
+  using PinLookup = std::pair<ConfigNodePtr, PinPtr>;
 
-  class NodeLink {
+  // srrg a link knows where it is stored in the manager and in the adjacency of its two nodes,
+  // so that removing it never scans a container
+  class NodeLink : public std::enable_shared_from_this<NodeLink> {
   public:
     NodeLink() = delete;
     NodeLink(ax::NodeEditor::LinkId id_,
@@ -26,27 +37,45 @@ namespace srrg2_core {
     }
 
     void reset() {
-      child   = nullptr;
-      _parent = nullptr;
+      child       = nullptr;
+      _parent     = nullptr;
+      _source_pin = 0;
+      _target_pin = 0;
     }
 
-    void release() {
-      auto& child_links  = child->_input_links;
-      auto& parent_links = _parent->_output_links;
+    // srrg attach the child and cache the pins to connect, so rendering does not look them up
+    void bind(std::shared_ptr<ConfigNode> child_, const ax::NodeEditor::PinId& source_pin_) {
+      child       = child_;
+      _source_pin = source_pin_;
+      _target_pin = child_->inputPin()->ID();
+      _input_slot = child_->_input_links.size();
+      child_->_input_links.push_back(shared_from_this());
+    }
 
-      for (size_t i = 0; i < child_links.size(); ++i) {
-        if (child_links[i].get() == this) {
-          child_links.erase(child_links.begin() + i);
-          break;
-        }
+    // srrg register the link among the outputs of the parent, under its parameter
+    void attachOutput() {
+      if (_has_output) {
+        return;
       }
+      _output_it  = _parent->_output_links.insert(std::make_pair(_param_name, shared_from_this()));
+      _has_output = true;
+    }
 
-      for (auto o_it = parent_links.begin(); o_it != parent_links.end(); ++o_it) {
-        if (o_it->second.get() == this) {
-          parent_links.erase(o_it);
-          break;
+    void release() {
+      if (child) {
+        // srrg swap with the last input of the child, the moved link takes over our slot
+        auto& child_links = child->_input_links;
+        if (_input_slot < child_links.size() && child_links[_input_slot].get() == this) {
+          child_links[_input_slot]              = child_links.back();
+          child_links[_input_slot]->_input_slot = _input_slot;
+          child_links.pop_back();
         }
       }
+
+      if (_has_output) {
+        _parent->_output_links.erase(_output_it);
+        _has_output = false;
+      }
     }
 
     bool isPresent() {
@@ -61,19 +90,40 @@ namespace srrg2_core {
     const std::string& paramName() const {
       return _param_name;
     }
+    const ax::NodeEditor::PinId& sourcePin() const {
+      return _source_pin;
+    }
+    const ax::NodeEditor::PinId& targetPin() const {
+      return _target_pin;
+    }
     std::shared_ptr<ConfigNode> child = nullptr;
 
+    friend class ConfigNode;
+    friend class ConfigurableNodeManager;
+
   protected:
     ax::NodeEditor::LinkId _id;
+    ax::NodeEditor::PinId _source_pin;
+    ax::NodeEditor::PinId _target_pin;
     std::shared_ptr<ConfigNode> _parent = nullptr;
     const std::string _param_name;
+
+    // srrg position in the manager links, in the child inputs and in the parent outputs
+    size_t _slot       = 0;
+    size_t _input_slot = 0;
+    std::multimap<std::string, std::shared_ptr<NodeLink>>::iterator _output_it;
+    bool _has_output = false;
   };
 
   using NodeLinkPtr = std::shared_ptr<NodeLink>;
 
   class ConfigurableNodeManager : public ConfigurableManager {
   public:
+    // srrg stages of a background load, the last three mean the worker is done
+    enum class LoadPhase { Idle, Parsing, Building, Connecting, Layout, Ready, Failed, Cancelled };
+
     ~ConfigurableNodeManager() {
+      _discardLoad();
       clear();
     }
 
@@ -82,7 +132,9 @@ namespace srrg2_core {
     bool load(const std::string& file_) {
       std::cerr << "loading file: " << file_ << std::endl;
       if (file_.length() && srrg2_core::isAccessible(file_)) {
+        _discardLoad();
         clear();
+        _openLayoutCache(file_);
         this->read(file_);
         _buildConfigNodes();
         return true;
@@ -91,35 +143,138 @@ namespace srrg2_core {
       return false;
     }
 
+    // srrg parses the file and builds nodes, links and layout on a worker thread into a staging
+    // manager. The current workspace stays usable until updateLoad() swaps the new one in.
+    bool loadAsync(const std::string& file_, ImVec2 pos_ = ImVec2(100, 100));
+
+    // srrg to be called once per frame inside the editor, returns true when a staged workspace
+    // replaced the current one
+    bool updateLoad();
+
+    inline bool isLoading() const {
+      return _load_thread.joinable();
+    }
+    inline LoadPhase loadPhase() const {
+      return _load_state.phase;
+    }
+    // srrg fraction of the nodes built so far, parsing the file reports no progress
+    inline float loadProgress() const {
+      return _load_state.progress;
+    }
+    inline void cancelLoad() {
+      _load_state.cancel = true;
+    }
+
+    // srrg true while the canvas changes without user input: a load is running or some nodes
+    // were created or moved and still have to be drawn and measured
+    inline bool needsRedraw() const {
+      return isLoading() || _frames_to_settle > 0;
+    }
+
+    // srrg sidecar of a config file holding the positions of its nodes
+    static inline std::string layoutCacheFile(const std::string& config_file_) {
+      return config_file_ + ".layout";
+    }
+
+    // srrg with the cache on, loading places only the nodes without a cached position
+    inline void setLayoutCaching(const bool& enabled_) {
+      _layout_caching = enabled_;
+    }
+    inline const bool& layoutCaching() const {
+      return _layout_caching;
+    }
+    inline const LayoutCache& layoutCache() const {
+      return _layout_cache;
+    }
+
+    // srrg writes the cache to file_, or to the one of the loaded config if it changed
+    bool saveLayoutCache(const std::string& file_ = "");
+
+    // srrg routes the node settings of the editor to the cache and lets the nodes share the draw
+    // layers, call before creating the editor
+    void configureEditor(ax::NodeEditor::Config& config_);
+
     bool updateConnection(const NodeLinkPtr link_, std::shared_ptr<ConfigNode> new_child_);
 
     void createConfig(const std::string& type_, ImVec2 pos_);
     void addConfig(const PropertyContainerIdentifiablePtr instance_, ImVec2 pos_);
 
+    // srrg lays out every node again from pos_, ignoring the cached positions
     void refreshView(ImVec2 pos_);
 
+    // srrg incremental mode: edits mark the nodes they touch and the next frame places only
+    // those, with the subtrees that hang from them alone. The other nodes never move
+    inline void setIncrementalLayout(const bool& enabled_) {
+      _incremental_layout = enabled_;
+      if (!enabled_) {
+        _dirty_nodes.clear();
+      }
+    }
+    inline const bool& incrementalLayout() const {
+      return _incremental_layout;
+    }
+
+    // srrg layout method and parameters, stats() describes the last layout
+    inline LayoutEngine& layoutEngine() {
+      return _layout_engine;
+    }
+
+    // srrg places the marked nodes, returns how many of them moved
+    size_t relayoutDirty();
+    inline const size_t& movedNodes() const {
+      return _moved_nodes;
+    }
+
     void clear();
 
     void deleteConfigurable(PropertyContainerIdentifiablePtr configurable_);
 
-    inline void showNodes() {
-      for (const auto& node : _nodes) {
-        if (!node.second) {
-          continue;
-        }
-        node.second->internals();
-      }
+    // srrg nodes outside the visible canvas (plus a margin) are submitted as placeholders when
+    // culling is enabled, so the frame cost follows the visible nodes
+    void showNodes();
+
+    inline void setCulling(const bool& enabled_) {
+      _culling = enabled_;
+    }
+    inline const bool& culling() const {
+      return _culling;
+    }
+
+    // srrg level of detail: zoomed out, the visible nodes are drawn without their widgets
+    inline void setLevelOfDetail(const bool& enabled_) {
+      _level_of_detail_enabled = enabled_;
+    }
+    inline const bool& levelOfDetailEnabled() const {
+      return _level_of_detail_enabled;
+    }
+    // srrg below zoom pins_zoom_ the nodes show the header and the pins only, below box_zoom_ a
+    // box with the title. Zooming back in needs a few percent more than the threshold, so a zoom
+    // resting on it does not switch every frame
+    inline void setLevelOfDetailZooms(const float& pins_zoom_, const float& box_zoom_) {
+      _pins_zoom = pins_zoom_;
+      _box_zoom  = box_zoom_;
+    }
+    // srrg level used for the visible nodes on the last frame
+    inline const LevelOfDetail& levelOfDetail() const {
+      return _level_of_detail;
+    }
+
+    // srrg lazy mode: only the roots and the instances up to depth_ levels below them get a node,
+    // the others are counted in a collapsed stub under their parent output. -1 builds them all
+    inline void setLazyDepth(const int& depth_) {
+      _lazy_depth = depth_;
+    }
+    inline const int& lazyDepth() const {
+      return _lazy_depth;
     }
 
+    // srrg creates the nodes hidden under the output param_name_ of node_, one level deep
+    void expand(ConfigNodePtr node_, const std::string& param_name_);
+
     inline void showLinks() {
-      // srrg questo e' na mmerda
-      for (auto l : _links) {
-        for (auto op : l->parent()->outputPins()) {
-          if (op->paramName() == l->paramName()) {
-            ax::NodeEditor::Link(l->ID(), op->ID(), l->child->inputPin()->ID());
-            break;
-          }
-        }
+      SRRG_PROFILE_SCOPE(ShowLinks);
+      for (const NodeLinkPtr& l : _links) {
+        ax::NodeEditor::Link(l->ID(), l->sourcePin(), l->targetPin());
       }
     }
 
@@ -129,31 +284,168 @@ namespace srrg2_core {
       return _nodes;
     }
 
+    inline const std::vector<NodeLinkPtr>& links() const {
+      return _links;
+    }
+
+    inline ConfigNodePtr findNode(ax::NodeEditor::NodeId id_) const {
+      auto n_it = _node_index.find(id_.Get());
+      if (n_it == _node_index.end()) {
+        return nullptr;
+      }
+      return n_it->second;
+    }
+
     void deleteLinksByPin(ax::NodeEditor::PinId pin_);
 
+    // srrg names, classes and property values of every instance, documents are the node ids and
+    // hiddenDocument() for the instances hidden by the lazy mode. Kept up to date as nodes come
+    // and go and as their widgets edit them
+    inline const SearchIndex& searchIndex() const {
+      return _search_index;
+    }
+
+    // srrg search document of an instance without a node, node ids never reach the tag bit
+    static inline uint64_t hiddenDocument(const PropertyContainerIdentifiable* configurable_) {
+      return (uint64_t(1) << 63) | reinterpret_cast<uintptr_t>(configurable_);
+    }
+    static inline bool isHiddenDocument(const uint64_t& document_) {
+      return document_ >> 63;
+    }
+
+    // srrg nodes drawn with a highlighted border, e.g. the search hits
+    inline void setHighlighted(const std::vector<ax::NodeEditor::NodeId>& nodes_) {
+      _highlighted.clear();
+      for (const ax::NodeEditor::NodeId& id : nodes_) {
+        _highlighted.insert(id.Get());
+      }
+    }
+
+    // srrg selects node_ and scrolls the view to it on the next showNodes()
+    inline void focusNode(const ConfigNodePtr& node_) {
+      _focus_request = node_;
+    }
+    // srrg focusNode() on the node of a search document. A hidden instance is given a node first,
+    // expanding the outputs from the closest node down to it
+    void focusDocument(const uint64_t& document_);
+
   protected:
     NodeMap _nodes;
-    float _curr_y_bb;
+    NodeSizeModel _size_model;
+    LayoutEngine _layout_engine;
+    bool _culling         = true;
+    float _culling_margin = 100.f;
+    int _lazy_depth       = -1;
+    bool _level_of_detail_enabled  = true;
+    float _pins_zoom               = 0.6f;
+    float _box_zoom                = 0.3f;
+    LevelOfDetail _level_of_detail = LevelOfDetail::Full;
+    SearchIndex _search_index;
+    // srrg instances indexed without a node, by search document
+    std::unordered_map<uint64_t, PropertyContainerIdentifiablePtr> _hidden_documents;
+    std::unordered_set<uint64_t> _highlighted;
+    ConfigNodePtr _focus_request = nullptr;
+    // srrg hidden instance to expand and focus on the next showNodes()
+    PropertyContainerIdentifiablePtr _focus_hidden = nullptr;
+    // srrg frames left before new or moved nodes have their editor size
+    int _frames_to_settle = 0;
+    bool _incremental_layout = false;
+    // srrg nodes to place on the next relayout, true if their subtree follows them
+    std::unordered_map<ConfigNodePtr, bool> _dirty_nodes;
+    size_t _moved_nodes = 0;
     std::vector<NodeLinkPtr> _links;
 
-    static int ed_counter_links;
+    LayoutCache _layout_cache;
+    std::string _layout_cache_file;
+    bool _layout_caching = true;
+
+    // srrg editor ids to nodes and pins, kept in sync with _nodes
+    std::unordered_map<uintptr_t, ConfigNodePtr> _node_index;
+    std::unordered_map<uintptr_t, PinLookup> _pin_index;
 
-    void _computeHierarchy(ImVec2 pos);
-    void _computeSources(const Matrix_<int>& matrix_,
-                         const std::map<PropertyContainerIdentifiablePtr, size_t>& bookkeeping_,
-                         int level_,
-                         std::multimap<int, ConfigNodePtr>& sources_);
+    // srrg shared between the render thread and the loading worker
+    struct LoadState {
+      std::atomic<LoadPhase> phase{LoadPhase::Idle};
+      std::atomic<float> progress{0.f};
+      std::atomic<bool> cancel{false};
 
+      inline bool isDone() const {
+        const LoadPhase p = phase;
+        return p == LoadPhase::Ready || p == LoadPhase::Failed || p == LoadPhase::Cancelled;
+      }
+    };
+
+    LoadState _load_state;
+    std::thread _load_thread;
+    std::unique_ptr<ConfigurableNodeManager> _staging;
+    // srrg a staging manager never talks to the editor and never resets the ids
+    bool _is_staging = false;
+
+    static std::atomic<int> ed_counter_links;
+
+    void _computeHierarchy(ImVec2 pos, const bool& use_cache_ = true);
+    // srrg links parents_ to their children with a node, only to the ones in children_ if given
+    void _connectNodes(const NodeMap& parents_, const NodeMap* children_ = nullptr);
+
+    // srrg picks the level of detail of this frame from the editor zoom
+    void _updateLevelOfDetail();
+
+    // srrg instances no other instance points to
+    std::vector<PropertyContainerIdentifiablePtr> _rootInstances() const;
+    // srrg instances that get a node when building, every instance unless in lazy mode
+    std::vector<PropertyContainerIdentifiablePtr> _visibleInstances() const;
+    // srrg instances without a node up to _lazy_depth levels below roots_
+    std::vector<PropertyContainerIdentifiablePtr>
+    _lazyInstances(const std::vector<PropertyContainerIdentifiablePtr>& roots_) const;
+    // srrg creates the nodes of configs_ and links them to the existing ones, returns the new ones
+    NodeMap _materialize(const std::vector<PropertyContainerIdentifiablePtr>& configs_);
+    // srrg counts, for each output of nodes_, the distinct instances without a node below it
+    void _updateHiddenCounts(const NodeMap& nodes_);
+    // srrg indexes the instances without a node, drops the ones that got a node or went away
+    void _indexHiddenInstances();
+    // srrg expands the outputs leading from the closest node to hidden_, returns its node
+    ConfigNodePtr _expandTo(const PropertyContainerIdentifiablePtr& hidden_);
+
+    // srrg places the nodes with the layout engine, starting from origin_
+    void _computeLayout(const NodeMap& nodes_, ImVec2 origin_, const bool& use_cache_ = true);
+    // srrg computes node_bb without touching imgui, safe on the loading worker. Nodes with a
+    // cached position keep it, the others are placed right of them
+    void _placeNodes(const NodeMap& nodes_, ImVec2 origin_, const bool& use_cache_ = true);
+    void _applyPositions(const NodeMap& nodes_);
+
+    inline void _markDirty(const ConfigNodePtr& node_, const bool& with_subtree_) {
+      if (!_incremental_layout || !node_) {
+        return;
+      }
+      bool& subtree = _dirty_nodes[node_];
+      subtree       = subtree || with_subtree_;
+    }
+    // srrg true if bounds_ overlaps a node not in skip_, bottom_ is the lowest edge among them
+    bool _findOverlap(const ImRect& bounds_,
+                      const std::unordered_set<const ConfigNode*>& skip_,
+                      float& bottom_) const;
+
+    // srrg layout keys of all the nodes, paths are taken breadth first from the roots
+    void _computeLayoutKeys();
+    // srrg flushes the current cache and reads the one of config_file_
+    void _openLayoutCache(const std::string& config_file_);
+
+    static bool _saveNodeSettings(ax::NodeEditor::NodeId id_,
+                                  const char* data_,
+                                  size_t size_,
+                                  ax::NodeEditor::SaveReasonFlags reason_,
+                                  void* manager_);
+    static size_t _loadNodeSettings(ax::NodeEditor::NodeId id_, char* data_, void* manager_);
+
+    // srrg body of the loading worker, runs on the staging manager
+    void _stageConfig(const std::string file_, ImVec2 pos_, LoadState* state_);
+    void _swapWorkspace(ConfigurableNodeManager& staged_);
+    void _discardLoad();
     void _buildConfigNodes();
-    void _computeNodesPose(ImVec2 init_pose_, const std::multimap<int, ConfigNodePtr>& sources_);
-    void _computeSortedNodePoses(const std::vector<BoundingBox>& bb_,
-                                 const std::multimap<int, ConfigNodePtr>& sources_);
-    void _computeSortedNodePoses(ConfigNodePtr parent_node_,
-                                 const size_t& lvl_,
-                                 const std::vector<BoundingBox>& bb_,
-                                 const std::multimap<int, ConfigNodePtr>& sources_);
-
-    void _clearNodes() {
+    ConfigNodePtr _insertNode(const PropertyContainerIdentifiablePtr& configurable_);
+    void _eraseNode(const PropertyContainerIdentifiablePtr& configurable_);
+
+    void _clearNodes(const bool& reset_ids_ = true) {
       std::cerr << "\n";
       for (auto c_pair : _nodes) {
         PropertyContainerIdentifiablePtr c = c_pair.first;
@@ -167,55 +459,75 @@ namespace srrg2_core {
       }
 
       _nodes.clear();
+      _dirty_nodes.clear();
+      _node_index.clear();
+      _pin_index.clear();
+      _search_index.clear();
+      _hidden_documents.clear();
+      _highlighted.clear();
+      _focus_request = nullptr;
+      _focus_hidden  = nullptr;
       std::cerr << "ConfigurableNodeManager::_clearNodes|container cleaned\n";
-      ConfigNode::_resetCouter();
-      std::cerr << "ConfigurableNodeManager::_clearNodes|counter reset\n";
+      if (reset_ids_) {
+        ConfigNode::_resetCouter();
+        std::cerr << "ConfigurableNodeManager::_clearNodes|counter reset\n";
+      }
     }
 
-    void _clearLinks();
+    void _clearLinks(const bool& reset_ids_ = true);
 
     inline void _releaseLinks(ConfigNodePtr node_) {
-      const auto& i_links = node_->inputLinks();
-
-      for (auto it : i_links) {
-        it->release();
-
-        ax::NodeEditor::DeleteLink(it->ID());
-        auto l_to_del = std::find(_links.begin(), _links.end(), it);
-        if (l_to_del != _links.end()) {
-          _links.erase(l_to_del);
+      // srrg release() erases from the node containers, iterate over copies
+      const std::vector<NodeLinkPtr> i_links = node_->inputLinks();
+      for (const NodeLinkPtr& l : i_links) {
+        l->release();
+        if (!_is_staging) {
+          ax::NodeEditor::DeleteLink(l->ID());
         }
+        _removeLink(l);
       }
 
-      const auto& o_links = node_->outputLinks();
+      const std::multimap<std::string, NodeLinkPtr> o_links = node_->outputLinks();
       for (auto it = o_links.begin(); it != o_links.end(); ++it) {
         it->second->release();
-
-        ax::NodeEditor::DeleteLink(it->second->ID());
-        auto l_to_del = std::find(_links.begin(), _links.end(), it->second);
-        if (l_to_del != _links.end()) {
-          _links.erase(l_to_del);
+        if (!_is_staging) {
+          ax::NodeEditor::DeleteLink(it->second->ID());
         }
+        _removeLink(it->second);
       }
       node_->releaseConnections();
     }
 
-    inline std::pair<ConfigNodePtr, PinPtr> _findPin(ax::NodeEditor::PinId id) {
+    inline void _addLink(const NodeLinkPtr& link_) {
+      link_->_slot = _links.size();
+      _links.emplace_back(link_);
+    }
+
+    inline bool _hasLink(const NodeLinkPtr& link_) const {
+      return link_->_slot < _links.size() && _links[link_->_slot] == link_;
+    }
+
+    // srrg swap with the last link, drawing order is not meaningful
+    inline bool _removeLink(const NodeLinkPtr& link_) {
+      if (!_hasLink(link_)) {
+        return false;
+      }
+      const size_t slot = link_->_slot;
+      _links[slot]        = _links.back();
+      _links[slot]->_slot = slot;
+      _links.pop_back();
+      return true;
+    }
+
+    inline PinLookup _findPin(ax::NodeEditor::PinId id) const {
       if (!id) {
         return std::make_pair(nullptr, nullptr);
       }
-
-      for (auto node : _nodes) {
-        if (node.second->inputPin()->ID() == id) {
-          return std::make_pair(node.second, node.second->inputPin());
-        }
-        for (auto& pin : node.second->outputPins()) {
-          if (pin->ID() == id) {
-            return std::make_pair(node.second, pin);
-          }
-        }
+      auto p_it = _pin_index.find(id.Get());
+      if (p_it == _pin_index.end()) {
+        return std::make_pair(nullptr, nullptr);
       }
-      return std::make_pair(nullptr, nullptr);
+      return p_it->second;
     }
   };
 
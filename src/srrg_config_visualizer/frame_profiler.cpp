@@ -0,0 +1,241 @@
+#include "frame_profiler.h"
+
+#ifdef SRRG_CONFIG_VISUALIZER_PROFILE
+
+#include <algorithm>
+#include <fstream>
+#include <imgui.h>
+#include <iostream>
+
+namespace srrg2_core {
+
+  std::atomic<size_t> FrameProfiler::allocations(0);
+
+  // srrg in the order of FramePhase, the overlay and the trace export walk both up to Count
+  static const char* phase_names[] = {"frame",
+                                      "menu_bar",
+                                      "editor_begin",
+                                      "load_swap",
+                                      "context_menu",
+                                      "show_nodes",
+                                      "node_internals",
+                                      "node_placeholder",
+                                      "create_link",
+                                      "show_links",
+                                      "editor_end",
+                                      "render",
+                                      "node_simplified",
+                                      "search"};
+  static_assert(sizeof(phase_names) / sizeof(phase_names[0]) == FrameProfiler::num_phases,
+                "a FramePhase has no name");
+
+  const char* framePhaseName(const FramePhase& phase_) {
+    return phase_names[static_cast<size_t>(phase_)];
+  }
+
+  static uint32_t threadIndex() {
+    static std::atomic<uint32_t> num_threads(0);
+    thread_local const uint32_t index = num_threads++;
+    return index;
+  }
+
+  FrameProfiler& FrameProfiler::instance() {
+    static FrameProfiler profiler;
+    return profiler;
+  }
+
+  uint64_t FrameProfiler::now() {
+    static const auto t_start = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() -
+                                                                t_start)
+      .count();
+  }
+
+  FrameProfiler::FrameProfiler() : _events(event_capacity), _frames(frame_capacity) {
+    now();
+  }
+
+  void FrameProfiler::record(const FramePhase& phase_,
+                             const uint64_t& start_ns_,
+                             const uint64_t& duration_ns_) {
+    const uint64_t index = _head.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot           = _events[index & (event_capacity - 1)];
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.start_ns.store(start_ns_, std::memory_order_relaxed);
+    slot.duration_ns.store(duration_ns_, std::memory_order_relaxed);
+    slot.frame.store(_frame.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    slot.thread.store(threadIndex(), std::memory_order_relaxed);
+    slot.phase.store(phase_, std::memory_order_relaxed);
+    slot.sequence.store(index + 1, std::memory_order_release);
+  }
+
+  bool FrameProfiler::_readEvent(const uint64_t& index_, Event& event_) const {
+    const Slot& slot = _events[index_ & (event_capacity - 1)];
+    if (slot.sequence.load(std::memory_order_acquire) != index_ + 1) {
+      return false;
+    }
+    // srrg the fields are atomics, a slot rewritten meanwhile gives a torn copy, never a race
+    event_.start_ns    = slot.start_ns.load(std::memory_order_relaxed);
+    event_.duration_ns = slot.duration_ns.load(std::memory_order_relaxed);
+    event_.frame       = slot.frame.load(std::memory_order_relaxed);
+    event_.thread      = slot.thread.load(std::memory_order_relaxed);
+    event_.phase       = slot.phase.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot.sequence.load(std::memory_order_relaxed) == index_ + 1;
+  }
+
+  void FrameProfiler::beginFrame() {
+    _frame_begin       = _head.load(std::memory_order_acquire);
+    _frame_allocations = allocations.load(std::memory_order_relaxed);
+  }
+
+  void FrameProfiler::endFrame(const size_t& num_nodes_, const size_t& num_links_) {
+    const uint64_t head = _head.load(std::memory_order_acquire);
+    FrameRecord& record = _frames[_num_frames % frame_capacity];
+    record.frame        = _frame.load(std::memory_order_relaxed);
+    record.phase_ms.fill(0.f);
+    record.num_nodes       = num_nodes_;
+    record.num_links       = num_links_;
+    record.num_allocations = allocations.load(std::memory_order_relaxed) - _frame_allocations;
+
+    // srrg a frame with more events than the ring keeps only the most recent ones
+    const uint64_t begin = std::max(_frame_begin, head > event_capacity ? head - event_capacity : 0);
+    Event event;
+    for (uint64_t i = begin; i < head; ++i) {
+      if (_readEvent(i, event)) {
+        record.phase_ms[static_cast<size_t>(event.phase)] += event.duration_ns * 1e-6f;
+      }
+    }
+    ++_num_frames;
+    ++_frame;
+  }
+
+  const FrameProfiler::FrameRecord* FrameProfiler::lastFrame() const {
+    if (!_num_frames) {
+      return nullptr;
+    }
+    return &_frames[(_num_frames - 1) % frame_capacity];
+  }
+
+  float FrameProfiler::percentile(const FramePhase& phase_, const float& percentile_) const {
+    const size_t num_frames = std::min(_num_frames, frame_capacity);
+    if (!num_frames) {
+      return 0.f;
+    }
+    std::vector<float> values(num_frames);
+    for (size_t i = 0; i < num_frames; ++i) {
+      values[i] = _frames[i].phase_ms[static_cast<size_t>(phase_)];
+    }
+    const size_t rank = std::min<size_t>(percentile_ * num_frames, num_frames - 1);
+    std::nth_element(values.begin(), values.begin() + rank, values.end());
+    return values[rank];
+  }
+
+  bool FrameProfiler::exportChromeTrace(const std::string& filename_) const {
+    std::ofstream stream(filename_);
+    if (!stream.good()) {
+      std::cerr << "FrameProfiler::exportChromeTrace|unable to open [ " << filename_ << " ]"
+                << std::endl;
+      return false;
+    }
+
+    const uint64_t head  = _head.load(std::memory_order_acquire);
+    const uint64_t begin = head > event_capacity ? head - event_capacity : 0;
+    stream << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    bool first = true;
+    Event event;
+    for (uint64_t i = begin; i < head; ++i) {
+      if (!_readEvent(i, event)) {
+        continue;
+      }
+      // srrg complete events, times in microseconds
+      stream << (first ? "\n" : ",\n") << "{\"name\": \"" << framePhaseName(event.phase)
+             << "\", \"ph\": \"X\", \"pid\": 0, \"tid\": " << event.thread
+             << ", \"ts\": " << event.start_ns * 1e-3 << ", \"dur\": " << event.duration_ns * 1e-3
+             << ", \"args\": {\"frame\": " << event.frame << "}}";
+      first = false;
+    }
+    stream << "\n]}" << std::endl;
+    return true;
+  }
+
+  bool FrameProfiler::exportCsv(const std::string& filename_) const {
+    std::ofstream stream(filename_);
+    if (!stream.good()) {
+      std::cerr << "FrameProfiler::exportCsv|unable to open [ " << filename_ << " ]" << std::endl;
+      return false;
+    }
+
+    stream << "frame,nodes,links,allocations";
+    for (size_t p = 0; p < num_phases; ++p) {
+      stream << "," << phase_names[p] << "_ms";
+    }
+    stream << "\n";
+
+    const size_t num_frames = std::min(_num_frames, frame_capacity);
+    for (size_t i = _num_frames - num_frames; i < _num_frames; ++i) {
+      const FrameRecord& record = _frames[i % frame_capacity];
+      stream << record.frame << "," << record.num_nodes << "," << record.num_links << ","
+             << record.num_allocations;
+      for (const float& ms : record.phase_ms) {
+        stream << "," << ms;
+      }
+      stream << "\n";
+    }
+    return true;
+  }
+
+  void FrameProfiler::showOverlay(bool* open_) {
+    ImGui::SetNextWindowSize(ImVec2(420, 0), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Profiler", open_, ImGuiWindowFlags_NoSavedSettings)) {
+      ImGui::End();
+      return;
+    }
+
+    const FrameRecord* last = lastFrame();
+    if (last) {
+      ImGui::Text("nodes %zu  links %zu  allocations/frame %zu",
+                  last->num_nodes,
+                  last->num_links,
+                  last->num_allocations);
+    }
+    ImGui::Text("last %zu frames, ms", std::min(_num_frames, frame_capacity));
+    ImGui::Separator();
+
+    ImGui::Columns(4, "profiler_phases", false);
+    ImGui::TextUnformatted("phase");
+    ImGui::NextColumn();
+    ImGui::TextUnformatted("p50");
+    ImGui::NextColumn();
+    ImGui::TextUnformatted("p95");
+    ImGui::NextColumn();
+    ImGui::TextUnformatted("p99");
+    ImGui::NextColumn();
+    for (size_t p = 0; p < num_phases; ++p) {
+      const FramePhase phase = static_cast<FramePhase>(p);
+      ImGui::TextUnformatted(phase_names[p]);
+      ImGui::NextColumn();
+      ImGui::Text("%.3f", percentile(phase, 0.50f));
+      ImGui::NextColumn();
+      ImGui::Text("%.3f", percentile(phase, 0.95f));
+      ImGui::NextColumn();
+      ImGui::Text("%.3f", percentile(phase, 0.99f));
+      ImGui::NextColumn();
+    }
+    ImGui::Columns(1);
+    ImGui::Separator();
+
+    if (ImGui::Button("Export trace")) {
+      exportChromeTrace("config_visualizer_trace.json");
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Export csv")) {
+      exportCsv("config_visualizer_frames.csv");
+    }
+    ImGui::End();
+  }
+
+} // namespace srrg2_core
+
+#endif
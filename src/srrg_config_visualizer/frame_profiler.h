@@ -0,0 +1,148 @@
+#pragma once
+
+// srrg the profiler exists only when built with -DSRRG_CONFIG_VISUALIZER_PROFILE=ON, otherwise the
+// macros below expand to nothing and no code is generated
+#ifdef SRRG_CONFIG_VISUALIZER_PROFILE
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define SRRG_PROFILE_CONCAT_(a_, b_) a_##b_
+#define SRRG_PROFILE_CONCAT(a_, b_) SRRG_PROFILE_CONCAT_(a_, b_)
+#define SRRG_PROFILE_SCOPE(phase_)                                                       \
+  srrg2_core::FrameProfiler::Scope SRRG_PROFILE_CONCAT(srrg_profile_scope_, __LINE__)( \
+    srrg2_core::FramePhase::phase_)
+#define SRRG_PROFILE_BEGIN_FRAME() srrg2_core::FrameProfiler::instance().beginFrame()
+#define SRRG_PROFILE_END_FRAME(num_nodes_, num_links_) \
+  srrg2_core::FrameProfiler::instance().endFrame(num_nodes_, num_links_)
+
+namespace srrg2_core {
+
+  // srrg instrumented sections of a frame, scopes of the same phase are summed per frame
+  enum class FramePhase : uint8_t {
+    Frame,
+    MenuBar,
+    EditorBegin,
+    LoadSwap,
+    ContextMenu,
+    ShowNodes,
+    NodeInternals,
+    NodePlaceholder,
+    CreateLink,
+    ShowLinks,
+    EditorEnd,
+    Render,
+    NodeSimplified,
+    Search,
+    Count
+  };
+
+  const char* framePhaseName(const FramePhase& phase_);
+
+  // srrg scoped timers write into a fixed ring of events with a single atomic increment, so any
+  // thread can record without locking. endFrame() folds the events of the frame into per phase
+  // totals, the overlay shows their percentiles over the last frames.
+  class FrameProfiler {
+  public:
+    static constexpr size_t num_phases     = static_cast<size_t>(FramePhase::Count);
+    static constexpr size_t event_capacity = 1 << 16;
+    static constexpr size_t frame_capacity = 600;
+
+    struct Event {
+      uint64_t start_ns    = 0;
+      uint64_t duration_ns = 0;
+      uint32_t frame       = 0;
+      uint32_t thread      = 0;
+      FramePhase phase     = FramePhase::Frame;
+    };
+
+    struct FrameRecord {
+      uint32_t frame = 0;
+      std::array<float, num_phases> phase_ms;
+      size_t num_nodes       = 0;
+      size_t num_links       = 0;
+      size_t num_allocations = 0;
+    };
+
+    class Scope {
+    public:
+      Scope(const FramePhase& phase_) : _phase(phase_), _start(FrameProfiler::now()) {
+      }
+      ~Scope() {
+        FrameProfiler::instance().record(_phase, _start, FrameProfiler::now() - _start);
+      }
+
+    protected:
+      FramePhase _phase;
+      uint64_t _start;
+    };
+
+    static FrameProfiler& instance();
+
+    // srrg nanoseconds since the profiler was created
+    static uint64_t now();
+
+    void record(const FramePhase& phase_, const uint64_t& start_ns_, const uint64_t& duration_ns_);
+
+    void beginFrame();
+    void endFrame(const size_t& num_nodes_, const size_t& num_links_);
+
+    // srrg percentile_ in [0, 1] of the per frame time of phase_ over the stored frames, in ms
+    float percentile(const FramePhase& phase_, const float& percentile_) const;
+
+    inline size_t numFrames() const {
+      return _num_frames;
+    }
+    // srrg last completed frame, nullptr before the first one
+    const FrameRecord* lastFrame() const;
+
+    // srrg the events still in the ring, in the chrome://tracing (and perfetto) json format
+    bool exportChromeTrace(const std::string& filename_) const;
+    // srrg one row per stored frame, the phase columns are in ms
+    bool exportCsv(const std::string& filename_) const;
+
+    // srrg imgui window with the percentiles, counters and export buttons
+    void showOverlay(bool* open_);
+
+    // srrg operator new calls of the whole process since the start, incremented by the operator
+    // new of the executable. Stays 0 in programs that do not replace it
+    static std::atomic<size_t> allocations;
+
+  protected:
+    FrameProfiler();
+
+    struct Slot {
+      // srrg index + 1 of the event written in the slot, readers drop slots being rewritten
+      std::atomic<uint64_t> sequence{0};
+      std::atomic<uint64_t> start_ns{0};
+      std::atomic<uint64_t> duration_ns{0};
+      std::atomic<uint32_t> frame{0};
+      std::atomic<uint32_t> thread{0};
+      std::atomic<FramePhase> phase{FramePhase::Frame};
+    };
+
+    bool _readEvent(const uint64_t& index_, Event& event_) const;
+
+    std::vector<Slot> _events;
+    std::atomic<uint64_t> _head{0};
+    std::atomic<uint32_t> _frame{0};
+    uint64_t _frame_begin      = 0;
+    size_t _frame_allocations  = 0;
+
+    std::vector<FrameRecord> _frames;
+    size_t _num_frames = 0;
+  };
+
+} // namespace srrg2_core
+
+#else
+
+#define SRRG_PROFILE_SCOPE(phase_)
+#define SRRG_PROFILE_BEGIN_FRAME()
+#define SRRG_PROFILE_END_FRAME(num_nodes_, num_links_)
+
+#endif
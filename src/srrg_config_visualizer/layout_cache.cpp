@@ -0,0 +1,54 @@
+#include "layout_cache.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace srrg2_core {
+
+  static const char* layout_cache_header = "# srrg_config_visualizer layout";
+
+  bool LayoutCache::load(const std::string& file_) {
+    clear();
+    std::ifstream stream(file_);
+    if (!stream.good()) {
+      return false;
+    }
+
+    std::string line;
+    while (std::getline(stream, line)) {
+      if (line.empty() || line[0] == '#') {
+        continue;
+      }
+      // srrg the key is the rest of the line, it may contain spaces
+      std::istringstream line_stream(line);
+      LayoutVec2 position;
+      std::string key;
+      if (!(line_stream >> position.x >> position.y)) {
+        std::cerr << "LayoutCache::load|skipping malformed line [ " << line << " ]" << std::endl;
+        continue;
+      }
+      line_stream.get();
+      std::getline(line_stream, key);
+      if (!key.empty()) {
+        _positions[key] = position;
+      }
+    }
+    _is_dirty = false;
+    return true;
+  }
+
+  bool LayoutCache::save(const std::string& file_) {
+    std::ofstream stream(file_);
+    if (!stream.good()) {
+      std::cerr << "LayoutCache::save|unable to open [ " << file_ << " ]" << std::endl;
+      return false;
+    }
+    stream << layout_cache_header << "\n";
+    for (const auto& p : _positions) {
+      stream << p.second.x << " " << p.second.y << " " << p.first << "\n";
+    }
+    _is_dirty = false;
+    return stream.good();
+  }
+
+} // namespace srrg2_core
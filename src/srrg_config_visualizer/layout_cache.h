@@ -0,0 +1,52 @@
+#pragma once
+#include "layout_engine.h"
+#include <string>
+#include <unordered_map>
+
+namespace srrg2_core {
+
+  // srrg node positions by stable identity, so that an arrangement survives the editor ids
+  // changing from one run to the next. Stored as text, one "x y key" line per node.
+  class LayoutCache {
+  public:
+    // srrg replaces the content with the one of file_, a missing file gives an empty cache
+    bool load(const std::string& file_);
+    bool save(const std::string& file_);
+
+    // srrg nullptr if key_ was never placed
+    inline const LayoutVec2* find(const std::string& key_) const {
+      auto p_it = _positions.find(key_);
+      if (p_it == _positions.end()) {
+        return nullptr;
+      }
+      return &p_it->second;
+    }
+
+    inline void set(const std::string& key_, const LayoutVec2& position_) {
+      auto inserted = _positions.insert(std::make_pair(key_, position_));
+      LayoutVec2& position = inserted.first->second;
+      if (inserted.second || position.x != position_.x || position.y != position_.y) {
+        position  = position_;
+        _is_dirty = true;
+      }
+    }
+
+    inline void clear() {
+      _positions.clear();
+      _is_dirty = false;
+    }
+
+    inline size_t size() const {
+      return _positions.size();
+    }
+    // srrg changed since the last load or save
+    inline const bool& isDirty() const {
+      return _is_dirty;
+    }
+
+  protected:
+    std::unordered_map<std::string, LayoutVec2> _positions;
+    bool _is_dirty = false;
+  };
+
+} // namespace srrg2_core
@@ -0,0 +1,642 @@
+#include "layout_engine.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <thread>
+
+namespace srrg2_core {
+
+  // srrg below this many vertices times restarts handing out the restarts costs more than it saves
+  static constexpr size_t parallel_threshold = 4096;
+
+  // srrg helper threads started by the first parallel layout and kept for the next ones, so a
+  // relayout does not pay for starting threads. One layout at a time uses them, a concurrent one
+  // (e.g. the background load) runs on its own thread
+  class LayoutWorkers {
+  public:
+    static LayoutWorkers& instance() {
+      static LayoutWorkers workers;
+      return workers;
+    }
+
+    ~LayoutWorkers() {
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+      }
+      _wake.notify_all();
+      for (std::thread& thread : _threads) {
+        thread.join();
+      }
+    }
+
+    // srrg runs function_(i) for i in [0, count_) on up to num_threads_ threads, the calling one
+    // included, never more than the cores
+    template <typename FunctionType_>
+    void parallelFor(const size_t& count_, size_t num_threads_, FunctionType_ function_) {
+      const size_t num_cores = std::max(std::thread::hardware_concurrency(), 1u);
+      num_threads_           = std::min(std::min(num_threads_, count_), num_cores);
+      std::unique_lock<std::mutex> busy(_busy, std::try_to_lock);
+      if (num_threads_ < 2 || !busy.owns_lock()) {
+        for (size_t i = 0; i < count_; ++i) {
+          function_(i);
+        }
+        return;
+      }
+
+      std::atomic<size_t> next(0);
+      std::function<void()> work = [&]() {
+        for (size_t i = next++; i < count_; i = next++) {
+          function_(i);
+        }
+      };
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        while (_threads.size() < num_threads_ - 1) {
+          _threads.emplace_back(&LayoutWorkers::_loop, this, _threads.size(), _generation);
+        }
+        _work        = &work;
+        _num_helpers = num_threads_ - 1;
+        _pending     = _num_helpers;
+        ++_generation;
+      }
+      _wake.notify_all();
+      work();
+
+      std::unique_lock<std::mutex> lock(_mutex);
+      _done.wait(lock, [this]() { return !_pending; });
+      _work = nullptr;
+    }
+
+  protected:
+    LayoutWorkers() = default;
+
+    void _loop(const size_t index_, size_t generation_) {
+      std::unique_lock<std::mutex> lock(_mutex);
+      while (true) {
+        _wake.wait(lock, [&]() { return _stop || _generation != generation_; });
+        if (_stop) {
+          return;
+        }
+        generation_ = _generation;
+        if (index_ >= _num_helpers) {
+          continue;
+        }
+        std::function<void()>* work = _work;
+        lock.unlock();
+        (*work)();
+        lock.lock();
+        if (!--_pending) {
+          _done.notify_one();
+        }
+      }
+    }
+
+    std::mutex _busy;
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _done;
+    std::vector<std::thread> _threads;
+    std::function<void()>* _work = nullptr;
+    size_t _num_helpers          = 0;
+    size_t _pending              = 0;
+    size_t _generation           = 0;
+    bool _stop                   = false;
+  };
+
+  LayoutVec2 NodeSizeModel::estimate(const LayoutNodeDescription& node_) const {
+    using WidgetKind         = LayoutNodeDescription::WidgetKind;
+    const FontMetrics& m     = _metrics;
+    const float frame_height = m.frameHeight();
+
+    // srrg middle column, one widget per row
+    float middle_width = 0, middle_height = 0;
+    for (const LayoutNodeDescription::Widget& widget : node_.widgets) {
+      const float label_width = m.textWidth(widget.label_length);
+      float width = 0, height = frame_height;
+      switch (widget.kind) {
+        case WidgetKind::Checkbox:
+          // srrg box, label and the True/False text on the same line
+          width = frame_height + m.item_inner_spacing_x + label_width + m.item_spacing_x +
+                  m.textWidth(5);
+          break;
+        case WidgetKind::Field:
+          width = item_width + m.item_inner_spacing_x + label_width;
+          break;
+        case WidgetKind::Button:
+          width = label_width + 2 * m.frame_padding_x;
+          break;
+        case WidgetKind::WideButton:
+          width  = label_width + 15.f;
+          height = m.font_size + m.item_spacing_y;
+          break;
+      }
+      middle_width = std::max(middle_width, width);
+      middle_height += height + m.item_spacing_y;
+    }
+
+    // srrg output column, label and icon per row
+    float outputs_width = 0, outputs_height = 0;
+    for (const size_t& label_length : node_.output_label_lengths) {
+      outputs_width =
+        std::max(outputs_width, m.textWidth(label_length) + m.item_spacing_x + icon_size);
+      outputs_height += std::max(icon_size, m.font_size) + m.item_spacing_y;
+    }
+    for (const size_t& label_length : node_.collapsed_label_lengths) {
+      outputs_width = std::max(outputs_width, m.textWidth(label_length) + 2 * m.frame_padding_x);
+      outputs_height += m.font_size + m.item_spacing_y;
+    }
+
+    // srrg input, middle and output columns are separated and surrounded by springs
+    const float content_width = icon_size + middle_width + outputs_width + 4 * m.item_spacing_x;
+    const float content_height = std::max(icon_size, std::max(middle_height, outputs_height));
+    const float header_width   = m.textWidth(node_.title_length);
+    const float footer_width   = item_width + m.item_inner_spacing_x + m.textWidth(4);
+
+    LayoutVec2 size;
+    size.x = node_padding_left + std::max(content_width, std::max(header_width, footer_width)) +
+             node_padding_right;
+    size.y = node_padding_top + header_height + 2 * m.item_spacing_y + content_height +
+             3 * m.item_spacing_y + frame_height + node_padding_bottom;
+    return size;
+  }
+
+  void LayoutEngine::compute(const LayoutGraph& graph_,
+                             const std::vector<LayoutVec2>& sizes_,
+                             const std::vector<std::string>& keys_,
+                             const LayoutVec2& origin_,
+                             std::vector<LayoutVec2>& positions_) {
+    const size_t num_nodes = graph_.size();
+    positions_.resize(num_nodes);
+    _stats = LayoutStats();
+    if (!num_nodes) {
+      return;
+    }
+    const std::vector<int> levels = computeLevels(graph_);
+
+    _graph     = &graph_;
+    _sizes     = &sizes_;
+    _positions = &positions_;
+    _levels    = &levels;
+    _visited.assign(num_nodes, false);
+
+    std::vector<size_t> by_level(num_nodes);
+    std::iota(by_level.begin(), by_level.end(), 0);
+    std::stable_sort(by_level.begin(), by_level.end(), [&levels](size_t a_, size_t b_) {
+      return levels[a_] < levels[b_];
+    });
+
+    // srrg level boxes, each column starts where the previous one ends
+    const int num_levels = levels[by_level.back()] + 1;
+    _level_boxes.assign(num_levels, LevelBox());
+    int prev_level = 0;
+    for (size_t i = 0; i < num_nodes; ++i) {
+      const size_t& n        = by_level[i];
+      const int& level       = levels[n];
+      const LayoutVec2& size = sizes_[n];
+
+      if (!i) {
+        _level_boxes[level].pos  = origin_;
+        _curr_y                  = origin_.y;
+        _level_boxes[level].size = LayoutVec2(size.x + padding.x, size.y + padding.y);
+        continue;
+      }
+
+      if (prev_level != level) {
+        _level_boxes[level].pos = _level_boxes[prev_level].pos;
+        _level_boxes[level].pos.x += _level_boxes[prev_level].size.x;
+        _level_boxes[level].size = LayoutVec2(size.x + padding.x, size.y + padding.y);
+      } else {
+        _level_boxes[level].size.x = std::max(_level_boxes[level].size.x, size.x + padding.x);
+      }
+      prev_level = level;
+    }
+
+    // srrg sources in key order
+    std::vector<size_t> sources;
+    for (const size_t& n : by_level) {
+      if (levels[n]) {
+        break;
+      }
+      sources.push_back(n);
+    }
+    std::stable_sort(sources.begin(), sources.end(), [&keys_](size_t a_, size_t b_) {
+      return keys_[a_] < keys_[b_];
+    });
+
+    LayeredGraph layered;
+    _buildLayers(levels, num_levels, layered);
+
+    if (method == Method::Layered) {
+      _initialOrder(sources, layered);
+      _minimizeCrossings(layered);
+      _assignCoordinates(layered, origin_);
+    } else {
+      // srrg depth first along the children of each source
+      for (const size_t& s : sources) {
+        _placeSubtree(s);
+      }
+
+      // srrg only nodes of cycles without a parent in the previous column are left, they start a
+      // subtree of their own below the others
+      for (const size_t& n : by_level) {
+        if (!_visited[n]) {
+          _placeSubtree(n);
+        }
+      }
+      _orderFromPositions(layered);
+    }
+
+    std::vector<size_t> index;
+    _indexLayers(layered.layers, index);
+    _stats.crossings = _countCrossings(layered, layered.layers, index);
+    LayoutVec2 min(positions_[0]), max(positions_[0]);
+    for (size_t n = 0; n < num_nodes; ++n) {
+      min.x = std::min(min.x, positions_[n].x);
+      min.y = std::min(min.y, positions_[n].y);
+      max.x = std::max(max.x, positions_[n].x + sizes_[n].x);
+      max.y = std::max(max.y, positions_[n].y + sizes_[n].y);
+    }
+    _stats.area = (max.x - min.x) * (max.y - min.y);
+
+    _graph     = nullptr;
+    _sizes     = nullptr;
+    _positions = nullptr;
+    _levels    = nullptr;
+  }
+
+  void LayoutEngine::_placeSubtree(const size_t& node_) {
+    _visited[node_] = true;
+    const int& level = (*_levels)[node_];
+
+    // srrg each node is visited once: a shared child takes the vertical slot of the first parent
+    // that reaches it from the column right before its own
+    const float prev_y = _curr_y;
+    bool has_children  = false;
+    for (const size_t& c : _graph->children(node_)) {
+      if (_visited[c] || (*_levels)[c] != level + 1) {
+        continue;
+      }
+      _placeSubtree(c);
+      has_children = true;
+    }
+
+    const LayoutVec2& size = (*_sizes)[node_];
+    LayoutVec2& pos        = (*_positions)[node_];
+    pos.x                  = _level_boxes[level].pos.x + half_padding.x;
+    if (has_children) {
+      pos.y              = prev_y + (_curr_y - prev_y) * .5f - size.y * .5f;
+      const float bottom = prev_y + size.y + padding.y;
+      if (bottom > _curr_y) {
+        pos.y   = prev_y + half_padding.y;
+        _curr_y = bottom;
+      }
+    } else {
+      pos.y   = prev_y + half_padding.y;
+      _curr_y = prev_y + size.y + padding.y;
+    }
+  }
+
+  void LayoutEngine::_buildLayers(const std::vector<int>& levels_,
+                                  const int& num_levels_,
+                                  LayeredGraph& layered_) const {
+    const size_t num_nodes = levels_.size();
+    layered_.num_real      = num_nodes;
+    layered_.level         = levels_;
+    layered_.upper.assign(num_nodes, std::vector<size_t>());
+    layered_.lower.assign(num_nodes, std::vector<size_t>());
+    layered_.dummy_edges.clear();
+    layered_.layers.assign(num_levels_, std::vector<size_t>());
+
+    for (size_t p = 0; p < num_nodes; ++p) {
+      for (const size_t& c : _graph->children(p)) {
+        // srrg edges against the levels only exist in cycles, they do not constrain the order
+        if (levels_[c] <= levels_[p]) {
+          continue;
+        }
+        size_t prev = p;
+        for (int l = levels_[p] + 1; l < levels_[c]; ++l) {
+          const size_t dummy = layered_.level.size();
+          layered_.level.push_back(l);
+          layered_.upper.emplace_back(1, prev);
+          layered_.lower.emplace_back();
+          layered_.dummy_edges.emplace_back(p, c);
+          layered_.lower[prev].push_back(dummy);
+          prev = dummy;
+        }
+        layered_.lower[prev].push_back(c);
+        layered_.upper[c].push_back(prev);
+      }
+    }
+  }
+
+  void LayoutEngine::_initialOrder(const std::vector<size_t>& sources_,
+                                   LayeredGraph& layered_) const {
+    // srrg depth first from the sources in key order, as the subtree layout would stack them
+    const size_t num_vertices = layered_.level.size();
+    std::vector<bool> visited(num_vertices, false);
+    std::vector<size_t> stack;
+    auto visit = [&](const size_t& root_) {
+      if (visited[root_]) {
+        return;
+      }
+      visited[root_] = true;
+      stack.push_back(root_);
+      while (!stack.empty()) {
+        const size_t v = stack.back();
+        stack.pop_back();
+        layered_.layers[layered_.level[v]].push_back(v);
+        const std::vector<size_t>& lower = layered_.lower[v];
+        for (auto l_it = lower.rbegin(); l_it != lower.rend(); ++l_it) {
+          if (!visited[*l_it]) {
+            visited[*l_it] = true;
+            stack.push_back(*l_it);
+          }
+        }
+      }
+    };
+    for (const size_t& s : sources_) {
+      visit(s);
+    }
+    for (size_t v = 0; v < num_vertices; ++v) {
+      visit(v);
+    }
+  }
+
+  void LayoutEngine::_indexLayers(const Layers& layers_, std::vector<size_t>& index_) {
+    size_t num_vertices = 0;
+    for (const std::vector<size_t>& layer : layers_) {
+      num_vertices += layer.size();
+    }
+    index_.resize(num_vertices);
+    for (const std::vector<size_t>& layer : layers_) {
+      for (size_t i = 0; i < layer.size(); ++i) {
+        index_[layer[i]] = i;
+      }
+    }
+  }
+
+  size_t LayoutEngine::_countCrossings(const LayeredGraph& layered_,
+                                       const Layers& layers_,
+                                       const std::vector<size_t>& index_) {
+    // srrg edges sorted by their upper end, the crossings are the inversions of the lower ends,
+    // counted with a fenwick tree in O(edges log vertices) per pair of layers
+    size_t crossings = 0;
+    std::vector<size_t> targets, tree;
+    for (size_t l = 0; l + 1 < layers_.size(); ++l) {
+      targets.clear();
+      for (const size_t& v : layers_[l]) {
+        const size_t begin = targets.size();
+        for (const size_t& w : layered_.lower[v]) {
+          targets.push_back(index_[w]);
+        }
+        std::sort(targets.begin() + begin, targets.end());
+      }
+
+      const size_t width = layers_[l + 1].size();
+      tree.assign(width + 1, 0);
+      for (size_t e = 0; e < targets.size(); ++e) {
+        // srrg the previous edges ending strictly right of this one cross it
+        size_t not_greater = 0;
+        for (size_t i = targets[e] + 1; i > 0; i -= i & (~i + 1)) {
+          not_greater += tree[i];
+        }
+        crossings += e - not_greater;
+        for (size_t i = targets[e] + 1; i <= width; i += i & (~i + 1)) {
+          ++tree[i];
+        }
+      }
+    }
+    return crossings;
+  }
+
+  void LayoutEngine::_sortLayer(const LayeredGraph& layered_,
+                                const bool& downward_,
+                                const bool& use_median_,
+                                std::vector<size_t>& layer_,
+                                std::vector<size_t>& index_) {
+    std::vector<std::pair<double, size_t>> keyed;
+    std::vector<size_t> positions;
+    keyed.reserve(layer_.size());
+    for (size_t i = 0; i < layer_.size(); ++i) {
+      const size_t& v                      = layer_[i];
+      const std::vector<size_t>& neighbors = downward_ ? layered_.upper[v] : layered_.lower[v];
+      // srrg a vertex without neighbors on that side keeps its place
+      double key = i;
+      if (!neighbors.empty()) {
+        positions.clear();
+        for (const size_t& w : neighbors) {
+          positions.push_back(index_[w]);
+        }
+        if (use_median_) {
+          std::sort(positions.begin(), positions.end());
+          const size_t middle = positions.size() / 2;
+          key = positions.size() % 2 ? positions[middle]
+                                     : .5 * (positions[middle - 1] + positions[middle]);
+        } else {
+          key = std::accumulate(positions.begin(), positions.end(), 0.) / positions.size();
+        }
+      }
+      keyed.emplace_back(key, v);
+    }
+    std::stable_sort(keyed.begin(),
+                     keyed.end(),
+                     [](const std::pair<double, size_t>& a_, const std::pair<double, size_t>& b_) {
+                       return a_.first < b_.first;
+                     });
+    for (size_t i = 0; i < layer_.size(); ++i) {
+      layer_[i]               = keyed[i].second;
+      index_[keyed[i].second] = i;
+    }
+  }
+
+  size_t LayoutEngine::_reduceCrossings(const LayeredGraph& layered_,
+                                        const bool& use_median_,
+                                        Layers& layers_) const {
+    std::vector<size_t> index;
+    _indexLayers(layers_, index);
+    size_t best_crossings = _countCrossings(layered_, layers_, index);
+    Layers best_layers    = layers_;
+
+    // srrg alternate sweeps, each layer sorted on the one it was just compared to
+    for (int s = 0; s < num_sweeps && best_crossings; ++s) {
+      const bool downward = !(s % 2);
+      if (downward) {
+        for (size_t l = 1; l < layers_.size(); ++l) {
+          _sortLayer(layered_, true, use_median_, layers_[l], index);
+        }
+      } else {
+        for (size_t l = layers_.size() - 1; l-- > 0;) {
+          _sortLayer(layered_, false, use_median_, layers_[l], index);
+        }
+      }
+      const size_t crossings = _countCrossings(layered_, layers_, index);
+      if (crossings < best_crossings) {
+        best_crossings = crossings;
+        best_layers    = layers_;
+      }
+    }
+    layers_ = std::move(best_layers);
+    return best_crossings;
+  }
+
+  void LayoutEngine::_minimizeCrossings(LayeredGraph& layered_) const {
+    // srrg restart 0 starts from the depth first order, the others from shuffled layers;
+    // barycenter and median alternate. Restarts are independent and run in parallel
+    const size_t num_runs = std::max(num_restarts, 1);
+    std::vector<Layers> runs(num_runs, layered_.layers);
+    std::vector<size_t> crossings(num_runs, 0);
+    size_t num_workers = num_threads > 0 ? num_threads : std::thread::hardware_concurrency();
+    if (layered_.level.size() * num_runs < parallel_threshold) {
+      num_workers = 1;
+    }
+
+    LayoutWorkers::instance().parallelFor(num_runs, num_workers, [&](const size_t& r_) {
+      Layers& layers = runs[r_];
+      if (r_ >= 2) {
+        std::mt19937 rng(r_);
+        for (std::vector<size_t>& layer : layers) {
+          std::shuffle(layer.begin(), layer.end(), rng);
+        }
+      }
+      crossings[r_] = _reduceCrossings(layered_, r_ % 2, layers);
+    });
+
+    const size_t best = std::min_element(crossings.begin(), crossings.end()) - crossings.begin();
+    layered_.layers   = std::move(runs[best]);
+  }
+
+  void LayoutEngine::_packLayer(const std::vector<float>& desired_,
+                                const std::vector<float>& heights_,
+                                std::vector<float>& tops_) const {
+    // srrg the tops closest to desired_ that keep the order without overlaps. With prefix_i the
+    // space taken by the vertices before i, z_i = top_i - prefix_i must not decrease: isotonic
+    // regression of desired_i - prefix_i, pooling adjacent violators
+    const size_t size = desired_.size();
+    std::vector<float> prefix(size, 0.f);
+    for (size_t i = 1; i < size; ++i) {
+      prefix[i] = prefix[i - 1] + heights_[i - 1] + padding.y;
+    }
+
+    struct Block {
+      double sum;
+      size_t count;
+    };
+    std::vector<Block> blocks;
+    blocks.reserve(size);
+    for (size_t i = 0; i < size; ++i) {
+      blocks.push_back(Block{desired_[i] - prefix[i], 1});
+      while (blocks.size() > 1) {
+        const Block& last = blocks.back();
+        Block& prev       = blocks[blocks.size() - 2];
+        if (prev.sum / prev.count <= last.sum / last.count) {
+          break;
+        }
+        prev.sum += last.sum;
+        prev.count += last.count;
+        blocks.pop_back();
+      }
+    }
+
+    tops_.resize(size);
+    size_t i = 0;
+    for (const Block& block : blocks) {
+      const float z = block.sum / block.count;
+      for (size_t k = 0; k < block.count; ++k, ++i) {
+        tops_[i] = z + prefix[i];
+      }
+    }
+  }
+
+  void LayoutEngine::_assignCoordinates(const LayeredGraph& layered_, const LayoutVec2& origin_) {
+    // srrg dummies are lanes for the long links, as tall as the padding
+    const size_t num_vertices = layered_.level.size();
+    const std::vector<LayoutVec2>& sizes = *_sizes;
+    std::vector<float> heights(num_vertices, 0.f), tops(num_vertices, 0.f);
+    for (size_t v = 0; v < layered_.num_real; ++v) {
+      heights[v] = sizes[v].y;
+    }
+
+    // srrg start stacked, then each layer moves towards the centers of its neighbors, the
+    // previous layer going down and the next one going up
+    for (const std::vector<size_t>& layer : layered_.layers) {
+      float y = origin_.y;
+      for (const size_t& v : layer) {
+        tops[v] = y;
+        y += heights[v] + padding.y;
+      }
+    }
+
+    std::vector<float> desired, layer_heights, layer_tops;
+    const size_t num_layers = layered_.layers.size();
+    for (int pass = 0; pass < num_coordinate_passes; ++pass) {
+      const bool downward = !(pass % 2);
+      for (size_t k = 1; k < num_layers; ++k) {
+        const std::vector<size_t>& layer = layered_.layers[downward ? k : num_layers - 1 - k];
+        desired.clear();
+        layer_heights.clear();
+        for (const size_t& v : layer) {
+          const std::vector<size_t>& neighbors = downward ? layered_.upper[v] : layered_.lower[v];
+          float target = tops[v];
+          if (!neighbors.empty()) {
+            float center = 0;
+            for (const size_t& w : neighbors) {
+              center += tops[w] + heights[w] * .5f;
+            }
+            target = center / neighbors.size() - heights[v] * .5f;
+          }
+          desired.push_back(target);
+          layer_heights.push_back(heights[v]);
+        }
+        _packLayer(desired, layer_heights, layer_tops);
+        for (size_t i = 0; i < layer.size(); ++i) {
+          tops[layer[i]] = layer_tops[i];
+        }
+      }
+    }
+
+    // srrg the topmost node goes where the subtree layout would put the first one
+    float min_top = tops[0];
+    for (size_t v = 1; v < layered_.num_real; ++v) {
+      min_top = std::min(min_top, tops[v]);
+    }
+    const float shift = origin_.y + half_padding.y - min_top;
+    for (size_t v = 0; v < layered_.num_real; ++v) {
+      LayoutVec2& pos = (*_positions)[v];
+      pos.x           = _level_boxes[layered_.level[v]].pos.x + half_padding.x;
+      pos.y           = tops[v] + shift;
+    }
+  }
+
+  void LayoutEngine::_orderFromPositions(LayeredGraph& layered_) const {
+    // srrg dummies lie on the straight segment between the centers of the nodes they join
+    const std::vector<LayoutVec2>& sizes     = *_sizes;
+    const std::vector<LayoutVec2>& positions = *_positions;
+    auto center = [&](const size_t& n_) { return positions[n_].y + sizes[n_].y * .5f; };
+    std::vector<float> keys(layered_.level.size());
+    for (size_t v = 0; v < layered_.num_real; ++v) {
+      keys[v] = center(v);
+    }
+    for (size_t d = 0; d < layered_.dummy_edges.size(); ++d) {
+      const size_t v  = layered_.num_real + d;
+      const size_t& p = layered_.dummy_edges[d].first;
+      const size_t& c = layered_.dummy_edges[d].second;
+      const float t =
+        float(layered_.level[v] - layered_.level[p]) / (layered_.level[c] - layered_.level[p]);
+      keys[v] = center(p) + t * (center(c) - center(p));
+    }
+    for (size_t v = 0; v < keys.size(); ++v) {
+      layered_.layers[layered_.level[v]].push_back(v);
+    }
+    for (std::vector<size_t>& layer : layered_.layers) {
+      std::stable_sort(layer.begin(), layer.end(), [&keys](size_t a_, size_t b_) {
+        return keys[a_] < keys[b_];
+      });
+    }
+  }
+
+} // namespace srrg2_core
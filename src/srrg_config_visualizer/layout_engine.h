@@ -0,0 +1,179 @@
+#pragma once
+#include "layout_graph.h"
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace srrg2_core {
+
+  // srrg the layout does not depend on imgui, it works on its own 2d vectors
+  struct LayoutVec2 {
+    LayoutVec2(const float& x_ = 0, const float& y_ = 0) : x(x_), y(y_) {
+    }
+    float x;
+    float y;
+  };
+
+  // srrg font and style metrics used to estimate node sizes, defaults match the imgui default
+  // font (13px, monospace) and style
+  struct FontMetrics {
+    float glyph_width          = 7.f;
+    float font_size            = 13.f;
+    float frame_padding_x      = 4.f;
+    float frame_padding_y      = 3.f;
+    float item_spacing_x       = 8.f;
+    float item_spacing_y       = 4.f;
+    float item_inner_spacing_x = 4.f;
+
+    inline float textWidth(const size_t& num_chars_) const {
+      return glyph_width * num_chars_;
+    }
+    inline float frameHeight() const {
+      return font_size + 2 * frame_padding_y;
+    }
+  };
+
+  // srrg what a node shows, enough to estimate its size without drawing it
+  struct LayoutNodeDescription {
+    enum class WidgetKind { Checkbox, Field, Button, WideButton };
+    struct Widget {
+      WidgetKind kind;
+      size_t label_length;
+    };
+
+    size_t title_length = 0;
+    std::vector<Widget> widgets;
+    std::vector<size_t> output_label_lengths;
+    // srrg small buttons of the collapsed outputs, one row each under their pin
+    std::vector<size_t> collapsed_label_lengths;
+  };
+
+  // srrg estimates the size of a node from its description, mirroring ConfigNode::internals()
+  class NodeSizeModel {
+  public:
+    NodeSizeModel(const FontMetrics& metrics_ = FontMetrics()) : _metrics(metrics_) {
+    }
+
+    inline void setMetrics(const FontMetrics& metrics_) {
+      _metrics = metrics_;
+    }
+    inline const FontMetrics& metrics() const {
+      return _metrics;
+    }
+
+    LayoutVec2 estimate(const LayoutNodeDescription& node_) const;
+
+    // srrg drawing constants of ConfigNode
+    float item_width          = 180.f;
+    float icon_size           = 20.f;
+    float header_height       = 30.f;
+    float node_padding_left   = 8.f;
+    float node_padding_top    = 4.f;
+    float node_padding_right  = 8.f;
+    float node_padding_bottom = 8.f;
+
+  protected:
+    FontMetrics _metrics;
+  };
+
+  // srrg quality of the last layout: crossings between consecutive levels, links spanning more
+  // levels are split per level, and area of the bounding box of the nodes
+  struct LayoutStats {
+    size_t crossings = 0;
+    float area       = 0;
+  };
+
+  // srrg places the nodes column by column, one column per level of the graph.
+  // Subtree: sources are visited in order of their key and each subtree is centered on its
+  // children. Every node is visited once, shared children belong to a single parent.
+  // Layered: the order within each column minimizes the link crossings (barycenter and median
+  // sweeps from several starts, evaluated in parallel), then every node moves towards the
+  // centers of its neighbors without overlapping the others of its column.
+  class LayoutEngine {
+  public:
+    enum class Method { Subtree, Layered };
+
+    // srrg positions_ holds the top left corner of each node
+    void compute(const LayoutGraph& graph_,
+                 const std::vector<LayoutVec2>& sizes_,
+                 const std::vector<std::string>& keys_,
+                 const LayoutVec2& origin_,
+                 std::vector<LayoutVec2>& positions_);
+
+    inline const LayoutStats& stats() const {
+      return _stats;
+    }
+
+    LayoutVec2 padding      = LayoutVec2(20, 20);
+    LayoutVec2 half_padding = LayoutVec2(8, 8);
+
+    Method method = Method::Layered;
+    // srrg crossing reduction sweeps of each start, alternating down and up
+    int num_sweeps = 8;
+    // srrg starts of the crossing reduction, the first one is the subtree order
+    int num_restarts = 4;
+    // srrg 0 uses every core, more than the cores are not started
+    int num_threads = 0;
+    // srrg alignment passes of the node centers, alternating down and up
+    int num_coordinate_passes = 4;
+
+  protected:
+    using Layers = std::vector<std::vector<size_t>>;
+
+    // srrg graph where links span a single level, the longer ones go through dummy vertices.
+    // Real nodes keep their index, dummies follow
+    struct LayeredGraph {
+      size_t num_real = 0;
+      std::vector<int> level;
+      // srrg neighbors in the previous and in the next level
+      Layers upper;
+      Layers lower;
+      // srrg parent and child joined by each dummy
+      std::vector<std::pair<size_t, size_t>> dummy_edges;
+      Layers layers;
+    };
+
+    struct LevelBox {
+      LayoutVec2 pos;
+      LayoutVec2 size;
+    };
+
+    void _placeSubtree(const size_t& node_);
+
+    void _buildLayers(const std::vector<int>& levels_,
+                      const int& num_levels_,
+                      LayeredGraph& layered_) const;
+    void _initialOrder(const std::vector<size_t>& sources_, LayeredGraph& layered_) const;
+    void _minimizeCrossings(LayeredGraph& layered_) const;
+    // srrg sweeps from the order in layers_, leaves the best one found, returns its crossings
+    size_t _reduceCrossings(const LayeredGraph& layered_,
+                            const bool& use_median_,
+                            Layers& layers_) const;
+    void _assignCoordinates(const LayeredGraph& layered_, const LayoutVec2& origin_);
+    void _packLayer(const std::vector<float>& desired_,
+                    const std::vector<float>& heights_,
+                    std::vector<float>& tops_) const;
+    // srrg orders the layers by the vertical position of the placed nodes
+    void _orderFromPositions(LayeredGraph& layered_) const;
+
+    static void _indexLayers(const Layers& layers_, std::vector<size_t>& index_);
+    static size_t _countCrossings(const LayeredGraph& layered_,
+                                  const Layers& layers_,
+                                  const std::vector<size_t>& index_);
+    static void _sortLayer(const LayeredGraph& layered_,
+                           const bool& downward_,
+                           const bool& use_median_,
+                           std::vector<size_t>& layer_,
+                           std::vector<size_t>& index_);
+
+    const LayoutGraph* _graph             = nullptr;
+    const std::vector<LayoutVec2>* _sizes = nullptr;
+    std::vector<LayoutVec2>* _positions   = nullptr;
+    const std::vector<int>* _levels       = nullptr;
+    std::vector<bool> _visited;
+    LayoutStats _stats;
+    std::vector<LevelBox> _level_boxes;
+    float _curr_y = 0;
+  };
+
+} // namespace srrg2_core
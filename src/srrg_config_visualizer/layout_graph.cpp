@@ -0,0 +1,61 @@
+#include "layout_graph.h"
+
+namespace srrg2_core {
+
+  std::vector<int> computeLevels(const LayoutGraph& graph_) {
+    const size_t num_nodes = graph_.size();
+    std::vector<int> levels(num_nodes, -1);
+    std::vector<size_t> in_degree(num_nodes, 0);
+    for (size_t n = 0; n < num_nodes; ++n) {
+      for (const size_t& c : graph_.children(n)) {
+        ++in_degree[c];
+      }
+    }
+
+    std::vector<size_t> frontier, next_frontier;
+    frontier.reserve(num_nodes);
+    next_frontier.reserve(num_nodes);
+    for (size_t n = 0; n < num_nodes; ++n) {
+      if (!in_degree[n]) {
+        frontier.push_back(n);
+      }
+    }
+
+    int level        = 0;
+    size_t assigned  = 0;
+    size_t cycle_pos = 0;
+    while (assigned < num_nodes) {
+      if (frontier.empty()) {
+        // srrg only cycles are left, break one open at its least constrained node
+        while (levels[cycle_pos] >= 0) {
+          ++cycle_pos;
+        }
+        size_t best = cycle_pos;
+        for (size_t n = cycle_pos + 1; n < num_nodes; ++n) {
+          if (levels[n] < 0 && in_degree[n] < in_degree[best]) {
+            best = n;
+          }
+        }
+        frontier.push_back(best);
+      }
+
+      for (const size_t& n : frontier) {
+        levels[n] = level;
+      }
+      assigned += frontier.size();
+
+      next_frontier.clear();
+      for (const size_t& n : frontier) {
+        for (const size_t& c : graph_.children(n)) {
+          if (levels[c] < 0 && --in_degree[c] == 0) {
+            next_frontier.push_back(c);
+          }
+        }
+      }
+      std::swap(frontier, next_frontier);
+      ++level;
+    }
+    return levels;
+  }
+
+} // namespace srrg2_core
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+namespace srrg2_core {
+
+  // srrg sparse directed graph over dense node indices [0, size()), edges go parent -> child
+  class LayoutGraph {
+  public:
+    LayoutGraph(const size_t& num_nodes_ = 0) {
+      resize(num_nodes_);
+    }
+
+    void resize(const size_t& num_nodes_) {
+      _children.resize(num_nodes_);
+    }
+
+    void clear() {
+      _children.clear();
+      _num_edges = 0;
+    }
+
+    // srrg self loops carry no ordering information and are dropped
+    inline void addEdge(const size_t& parent_, const size_t& child_) {
+      if (parent_ == child_) {
+        return;
+      }
+      _children[parent_].push_back(child_);
+      ++_num_edges;
+    }
+
+    inline size_t size() const {
+      return _children.size();
+    }
+
+    inline size_t numEdges() const {
+      return _num_edges;
+    }
+
+    inline const std::vector<size_t>& children(const size_t& node_) const {
+      return _children[node_];
+    }
+
+  protected:
+    std::vector<std::vector<size_t>> _children;
+    size_t _num_edges = 0;
+  };
+
+  // srrg assigns to each node its level, i.e. the length of the longest path reaching it from a
+  // source (Kahn layering), in O(nodes + edges). When only cycles are left, the pending node with
+  // the fewest unresolved parents is released on the current level, so every node gets a level.
+  std::vector<int> computeLevels(const LayoutGraph& graph_);
+
+} // namespace srrg2_core
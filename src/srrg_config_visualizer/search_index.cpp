@@ -0,0 +1,284 @@
+#include "search_index.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+
+namespace srrg2_core {
+
+  // srrg revisions are unique across indices, a swapped index never looks unchanged
+  static std::atomic<size_t> search_revisions(0);
+
+  static inline bool isWordChar(const char& c_) {
+    return std::isalnum(static_cast<unsigned char>(c_));
+  }
+
+  static inline std::string lowered(const std::string& text_) {
+    std::string result(text_);
+    for (char& c : result) {
+      c = std::tolower(static_cast<unsigned char>(c));
+    }
+    return result;
+  }
+
+  std::vector<std::string> searchWords(const std::string& text_) {
+    std::vector<std::string> words;
+    size_t begin = 0;
+    while (begin < text_.size()) {
+      if (!isWordChar(text_[begin])) {
+        ++begin;
+        continue;
+      }
+      size_t end = begin + 1;
+      while (end < text_.size() && isWordChar(text_[end])) {
+        // srrg a capital after a lower case letter starts a new word
+        if (std::isupper(static_cast<unsigned char>(text_[end])) &&
+            std::islower(static_cast<unsigned char>(text_[end - 1]))) {
+          break;
+        }
+        ++end;
+      }
+      words.push_back(lowered(text_.substr(begin, end - begin)));
+      begin = end;
+    }
+    return words;
+  }
+
+  // srrg spaces around '=' are part of a property term, not separators
+  static std::vector<std::string> queryTerms(const std::string& query_) {
+    std::string compact;
+    compact.reserve(query_.size());
+    for (size_t i = 0; i < query_.size(); ++i) {
+      const char c = query_[i];
+      if (std::isspace(static_cast<unsigned char>(c))) {
+        size_t next = i;
+        while (next < query_.size() && std::isspace(static_cast<unsigned char>(query_[next]))) {
+          ++next;
+        }
+        const bool after_equal  = !compact.empty() && compact.back() == '=';
+        const bool before_equal = next < query_.size() && query_[next] == '=';
+        if (!after_equal && !before_equal && !compact.empty()) {
+          compact.push_back(' ');
+        }
+        i = next - 1;
+        continue;
+      }
+      compact.push_back(c);
+    }
+
+    std::vector<std::string> terms;
+    size_t begin = 0;
+    while (begin < compact.size()) {
+      size_t end = compact.find(' ', begin);
+      if (end == std::string::npos) {
+        end = compact.size();
+      }
+      if (end > begin) {
+        terms.push_back(compact.substr(begin, end - begin));
+      }
+      begin = end + 1;
+    }
+    return terms;
+  }
+
+  void SearchIndex::set(const uint64_t& document_, const std::vector<SearchField>& fields_) {
+    auto d_it = _documents.find(document_);
+    if (d_it != _documents.end()) {
+      if (d_it->second.fields == fields_) {
+        return;
+      }
+      erase(document_);
+    }
+
+    _revision = ++search_revisions;
+    Document& document = _documents[document_];
+    document.fields    = fields_;
+    for (size_t f = 0; f < fields_.size(); ++f) {
+      _insertEntry(document_, f, fields_[f].text);
+    }
+  }
+
+  void SearchIndex::erase(const uint64_t& document_) {
+    auto d_it = _documents.find(document_);
+    if (d_it == _documents.end()) {
+      return;
+    }
+    for (const uint32_t& entry : d_it->second.entries) {
+      _eraseEntry(entry);
+    }
+    _documents.erase(d_it);
+    _revision = ++search_revisions;
+  }
+
+  void SearchIndex::clear() {
+    _documents.clear();
+    _entries.clear();
+    _free_entries.clear();
+    _words.clear();
+    _marks.clear();
+    _revision = ++search_revisions;
+  }
+
+  const std::vector<SearchField>* SearchIndex::fields(const uint64_t& document_) const {
+    auto d_it = _documents.find(document_);
+    if (d_it == _documents.end()) {
+      return nullptr;
+    }
+    return &d_it->second.fields;
+  }
+
+  void SearchIndex::_insertEntry(const uint64_t& document_,
+                                 const size_t& field_,
+                                 const std::string& text_) {
+    uint32_t index = _entries.size();
+    if (!_free_entries.empty()) {
+      index = _free_entries.back();
+      _free_entries.pop_back();
+    } else {
+      _entries.emplace_back();
+      _marks.push_back(0);
+    }
+
+    Entry& entry   = _entries[index];
+    entry.document = document_;
+    entry.field    = field_;
+    entry.lowered  = lowered(text_);
+    entry.words.clear();
+    for (const std::string& word : searchWords(text_)) {
+      auto w_it = _words.insert(std::make_pair(word, std::vector<uint32_t>())).first;
+      // srrg a repeated word is posted once
+      if (std::find(entry.words.begin(), entry.words.end(), w_it) != entry.words.end()) {
+        continue;
+      }
+      w_it->second.push_back(index);
+      entry.words.push_back(w_it);
+    }
+    _documents[document_].entries.push_back(index);
+  }
+
+  void SearchIndex::_eraseEntry(const uint32_t& entry_) {
+    Entry& entry = _entries[entry_];
+    for (const WordMap::iterator& w_it : entry.words) {
+      std::vector<uint32_t>& postings = w_it->second;
+      auto p_it                       = std::find(postings.begin(), postings.end(), entry_);
+      if (p_it != postings.end()) {
+        *p_it = postings.back();
+        postings.pop_back();
+      }
+      if (postings.empty()) {
+        _words.erase(w_it);
+      }
+    }
+    entry.words.clear();
+    entry.lowered.clear();
+    _free_entries.push_back(entry_);
+  }
+
+  void SearchIndex::_matchTerm(const std::string& term_,
+                               std::unordered_map<uint64_t, SearchHit>& matches_) const {
+    const std::vector<std::string> words = searchWords(term_);
+    if (words.empty()) {
+      return;
+    }
+
+    // srrg an entry is a candidate if each word of the term starts one of its words
+    const uint64_t base = _generation;
+    _generation += words.size() + 1;
+    std::vector<uint32_t> candidates;
+    for (size_t w = 0; w < words.size(); ++w) {
+      const std::string& word = words[w];
+      for (auto w_it = _words.lower_bound(word);
+           w_it != _words.end() && !w_it->first.compare(0, word.size(), word);
+           ++w_it) {
+        for (const uint32_t& entry : w_it->second) {
+          uint64_t& mark = _marks[entry];
+          if (!w && mark <= base) {
+            mark = base + 1;
+            candidates.push_back(entry);
+          } else if (w && mark == base + w) {
+            mark = base + w + 1;
+          }
+        }
+      }
+    }
+
+    // srrg the words must also be in sequence, as in the term
+    const std::string lowered_term = lowered(term_);
+    for (const uint32_t& entry : candidates) {
+      if (_marks[entry] != base + words.size()) {
+        continue;
+      }
+      const Entry& e     = _entries[entry];
+      const size_t begin = e.lowered.find(lowered_term);
+      if (begin == std::string::npos) {
+        continue;
+      }
+      SearchHit hit;
+      hit.document    = e.document;
+      hit.field       = e.field;
+      hit.match_begin = begin;
+      hit.match_end   = begin + lowered_term.size();
+
+      auto inserted = matches_.insert(std::make_pair(hit.document, hit));
+      if (!inserted.second && _rank(hit) < _rank(inserted.first->second)) {
+        inserted.first->second = hit;
+      }
+    }
+  }
+
+  int SearchIndex::_rank(const SearchHit& hit_) const {
+    const SearchField& field = _documents.at(hit_.document).fields[hit_.field];
+    int rank                 = static_cast<int>(field.kind);
+    if (hit_.match_begin) {
+      rank += 4;
+    }
+    if (hit_.match_begin || hit_.match_end != field.text.size()) {
+      rank += 8;
+    }
+    return rank;
+  }
+
+  size_t SearchIndex::query(const std::string& query_,
+                            std::vector<SearchHit>& hits_,
+                            const size_t& max_hits_) const {
+    hits_.clear();
+    const std::vector<std::string> terms = queryTerms(query_);
+    if (terms.empty()) {
+      return 0;
+    }
+
+    std::unordered_map<uint64_t, SearchHit> matches;
+    _matchTerm(terms[0], matches);
+    for (size_t t = 1; t < terms.size() && !matches.empty(); ++t) {
+      std::unordered_map<uint64_t, SearchHit> term_matches;
+      _matchTerm(terms[t], term_matches);
+      for (auto m_it = matches.begin(); m_it != matches.end();) {
+        if (term_matches.count(m_it->first)) {
+          ++m_it;
+        } else {
+          m_it = matches.erase(m_it);
+        }
+      }
+    }
+
+    std::vector<std::pair<int, SearchHit>> ranked;
+    ranked.reserve(matches.size());
+    for (const auto& match : matches) {
+      ranked.push_back(std::make_pair(_rank(match.second), match.second));
+    }
+    const size_t num_hits = std::min(max_hits_, ranked.size());
+    auto by_rank = [](const std::pair<int, SearchHit>& a_, const std::pair<int, SearchHit>& b_) {
+      if (a_.first != b_.first) {
+        return a_.first < b_.first;
+      }
+      return a_.second.document < b_.second.document;
+    };
+    std::partial_sort(ranked.begin(), ranked.begin() + num_hits, ranked.end(), by_rank);
+
+    hits_.reserve(num_hits);
+    for (size_t h = 0; h < num_hits; ++h) {
+      hits_.push_back(ranked[h].second);
+    }
+    return matches.size();
+  }
+
+} // namespace srrg2_core
@@ -0,0 +1,103 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace srrg2_core {
+
+  // srrg searchable text of a document, a property is indexed as "name=value"
+  struct SearchField {
+    enum class Kind { Name, Class, Property };
+
+    Kind kind = Kind::Name;
+    std::string text;
+
+    SearchField() = default;
+    SearchField(const Kind& kind_, const std::string& text_) : kind(kind_), text(text_) {
+    }
+    inline bool operator==(const SearchField& other_) const {
+      return kind == other_.kind && text == other_.text;
+    }
+  };
+
+  // srrg field of a document matching a query, with the matched characters of its text
+  struct SearchHit {
+    uint64_t document  = 0;
+    size_t field       = 0;
+    size_t match_begin = 0;
+    size_t match_end   = 0;
+  };
+
+  // srrg inverted index from the words of the fields to the fields containing them. Words split
+  // at punctuation and at camel case, so "MultiTracker" is found by "tracker" and
+  // "max_iterations=5" by "iterations=5", but not by "racker". A query is a list of terms
+  // separated by spaces, a document is a hit if each term is in one of its fields. Spaces around
+  // '=' are dropped, "max_iterations = 5" is a single term
+  class SearchIndex {
+  public:
+    // srrg adds document_ or replaces its fields, unchanged fields leave the index untouched
+    void set(const uint64_t& document_, const std::vector<SearchField>& fields_);
+    void erase(const uint64_t& document_);
+    void clear();
+
+    // srrg fills hits_ with at most max_hits_ documents, best first: the first term matching a
+    // whole field, then at the start of a field, then names before classes before properties.
+    // Returns the number of documents matching. Not thread safe, the search scratch is shared
+    size_t query(const std::string& query_,
+                 std::vector<SearchHit>& hits_,
+                 const size_t& max_hits_ = 100) const;
+
+    // srrg nullptr if document_ is not indexed
+    const std::vector<SearchField>* fields(const uint64_t& document_) const;
+
+    inline size_t size() const {
+      return _documents.size();
+    }
+    inline size_t numWords() const {
+      return _words.size();
+    }
+    // srrg changes at every edit of the index, to know when a query result is stale
+    inline const size_t& revision() const {
+      return _revision;
+    }
+
+  protected:
+    using WordMap = std::map<std::string, std::vector<uint32_t>>;
+
+    struct Entry {
+      uint64_t document = 0;
+      size_t field      = 0;
+      std::string lowered;
+      std::vector<WordMap::iterator> words;
+    };
+
+    struct Document {
+      std::vector<SearchField> fields;
+      std::vector<uint32_t> entries;
+    };
+
+    void _insertEntry(const uint64_t& document_, const size_t& field_, const std::string& text_);
+    void _eraseEntry(const uint32_t& entry_);
+
+    // srrg entries containing term_, best match of each document in matches_
+    void _matchTerm(const std::string& term_,
+                    std::unordered_map<uint64_t, SearchHit>& matches_) const;
+    int _rank(const SearchHit& hit_) const;
+
+    std::unordered_map<uint64_t, Document> _documents;
+    std::vector<Entry> _entries;
+    std::vector<uint32_t> _free_entries;
+    WordMap _words;
+    size_t _revision = 0;
+
+    // srrg per entry word count of the current term, stamped to avoid clearing between queries
+    mutable std::vector<uint64_t> _marks;
+    mutable uint64_t _generation = 0;
+  };
+
+  // srrg lower case words of text_ as indexed, split at punctuation and at camel case
+  std::vector<std::string> searchWords(const std::string& text_);
+
+} // namespace srrg2_core
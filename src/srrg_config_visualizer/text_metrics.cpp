@@ -0,0 +1,52 @@
+#include "text_metrics.h"
+#define IMGUI_DEFINE_MATH_OPERATORS
+#include <imgui_internal.h>
+
+namespace srrg2_core {
+
+  static size_t text_measurements = 0;
+  static bool text_caching        = true;
+
+  const ImVec2& CachedText::size() const {
+    const ImGuiContext& context = *ImGui::GetCurrentContext();
+    if (!text_caching || _font != context.Font || _font_size != context.FontSize) {
+      _size      = ImGui::CalcTextSize(_text.c_str(), _text.c_str() + _text.size());
+      _font      = context.Font;
+      _font_size = context.FontSize;
+      ++text_measurements;
+    }
+    return _size;
+  }
+
+  void CachedText::draw() const {
+    ImGuiWindow* window = ImGui::GetCurrentWindow();
+    if (window->SkipItems) {
+      return;
+    }
+    // srrg wrapped and long texts are measured line by line by imgui, leave them to it
+    if (!text_caching || window->DC.TextWrapPos >= 0.0f || _text.size() > 2000) {
+      ImGui::TextUnformatted(_text.c_str(), _text.c_str() + _text.size());
+      return;
+    }
+
+    // srrg same steps as ImGui::TextEx, with the size from the cache
+    const ImVec2 text_pos(window->DC.CursorPos.x,
+                          window->DC.CursorPos.y + window->DC.CurrLineTextBaseOffset);
+    const ImVec2& text_size = size();
+    const ImRect bb(text_pos, text_pos + text_size);
+    ImGui::ItemSize(text_size);
+    if (!ImGui::ItemAdd(bb, 0)) {
+      return;
+    }
+    ImGui::RenderTextWrapped(bb.Min, _text.c_str(), _text.c_str() + _text.size(), 0.0f);
+  }
+
+  size_t CachedText::measurements() {
+    return text_measurements;
+  }
+
+  void CachedText::setCaching(const bool& enabled_) {
+    text_caching = enabled_;
+  }
+
+} // namespace srrg2_core
@@ -0,0 +1,50 @@
+#pragma once
+#include <string>
+
+#include <imgui.h>
+
+struct ImFont;
+
+namespace srrg2_core {
+
+  // srrg label whose text rarely changes, measured once per font instead of at every frame. The
+  // size depends on the font and its size only: the editor zoom scales the drawn vertices, not
+  // the font, so zooming keeps the cached size valid.
+  class CachedText {
+  public:
+    CachedText(const std::string& text_ = "") : _text(text_) {
+    }
+
+    inline const std::string& text() const {
+      return _text;
+    }
+    inline const char* c_str() const {
+      return _text.c_str();
+    }
+
+    inline void setText(const std::string& text_) {
+      if (_text != text_) {
+        _text = text_;
+        _font = nullptr;
+      }
+    }
+
+    // srrg as ImGui::CalcTextSize(c_str()) in the current font
+    const ImVec2& size() const;
+
+    // srrg as ImGui::TextUnformatted(c_str()), the text is not measured again
+    void draw() const;
+
+    // srrg measurements done so far by all the labels, and a switch to measure at every call
+    // (the behavior of plain ImGui calls) to compare layouts
+    static size_t measurements();
+    static void setCaching(const bool& enabled_);
+
+  protected:
+    std::string _text;
+    mutable ImVec2 _size;
+    mutable const ImFont* _font = nullptr;
+    mutable float _font_size    = 0.f;
+  };
+
+} // namespace srrg2_core
@@ -0,0 +1,195 @@
+#include <crude_json.h>
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+
+using namespace crude_json;
+
+// srrg the document content as a value, to compare both parsers through dump()
+value toValue(const document::view& view_) {
+  switch (view_.type()) {
+    case type_t::object: {
+      value result(type_t::object);
+      for (auto it = view_.begin(); it != view_.end(); ++it) {
+        result[it.key().get_string().str()] = toValue(it.value());
+      }
+      return result;
+    }
+    case type_t::array: {
+      value result(type_t::array);
+      for (const document::view& element : view_) {
+        result.push_back(toValue(element));
+      }
+      return result;
+    }
+    case type_t::string:
+      return value(view_.get_string().str());
+    case type_t::number:
+      return value(view_.get_number());
+    case type_t::boolean:
+      return value(view_.get_boolean());
+    default:
+      return value(nullptr);
+  }
+}
+
+// srrg random json with escapes, surrogate pairs, exponents and irregular whitespace
+std::string randomJson(std::mt19937& rng_, const int& depth_) {
+  const char* strings[]  = {"\"abc\"",
+                            "\"a\\\"b\"",
+                            "\"\\u00e9x\\n\"",
+                            "\"\"",
+                            "\"\\ud83d\\ude00\"",
+                            "\"0123456789abcdefghijklmnop\\\\q\""};
+  const char* literals[] = {"true", "false", "null"};
+  switch (rng_() % (depth_ > 3 ? 5 : 7)) {
+    case 0:
+      return std::to_string(static_cast<int>(rng_() % 2000) - 1000);
+    case 1:
+      return std::to_string((rng_() % 100000) / 77.0);
+    case 2:
+      return strings[rng_() % 6];
+    case 3:
+      return literals[rng_() % 3];
+    case 4:
+      return "-1.5e3";
+    case 5: {
+      std::string result = "[";
+      const int size     = rng_() % 5;
+      for (int i = 0; i < size; ++i) {
+        result += i ? (rng_() % 3 ? "," : " , ") : "";
+        result += randomJson(rng_, depth_ + 1);
+      }
+      return result + (rng_() % 4 ? "]" : " ]");
+    }
+    default: {
+      std::string result = "{";
+      const int size     = rng_() % 5;
+      for (int i = 0; i < size; ++i) {
+        result += i ? "," : "";
+        result += "\"k" + std::to_string(i) + "\"" + (rng_() % 3 ? ":" : " :\n ");
+        result += randomJson(rng_, depth_ + 1);
+      }
+      return result + "}";
+    }
+  }
+}
+
+const char* malformed[] = {"",
+                           "   ",
+                           "{",
+                           "}",
+                           "[1,]",
+                           "[1 2]",
+                           "[}",
+                           "{\"a\" 1}",
+                           "{\"a\":}",
+                           "{\"a\":1,}",
+                           "{1:2}",
+                           "\"abc",
+                           "\"\\x\"",
+                           "\"\\u12\"",
+                           "01",
+                           "1.",
+                           "-",
+                           "1e",
+                           "tru",
+                           "nul",
+                           "1 2",
+                           "{\"a\":1}}",
+                           "[[1]"};
+
+TEST(CrudeJson, ValueRoundTrip) {
+  const std::string text = "{\"name\":\"a \\\"quoted\\\" \\u00e9\\n\",\"list\":[1,-2.5,1e+20,true,"
+                           "false,null],\"nested\":{\"empty\":{},\"none\":[]}}";
+  const value parsed = value::parse(text);
+  ASSERT_FALSE(parsed.is_discarded());
+  EXPECT_EQ(parsed["name"].get<string>(), "a \"quoted\" \xc3\xa9\n");
+  EXPECT_EQ(parsed["list"][1].get<number>(), -2.5);
+  EXPECT_EQ(parsed["list"][2].get<number>(), 1e20);
+  EXPECT_TRUE(parsed["nested"]["empty"].is_object());
+
+  // srrg dumping what was parsed gives the same text back, indented or not
+  const std::string dumped = parsed.dump();
+  EXPECT_EQ(value::parse(dumped).dump(), dumped);
+  EXPECT_EQ(value::parse(parsed.dump(4)).dump(), dumped);
+}
+
+TEST(CrudeJson, DocumentMatchesValue) {
+  std::mt19937 rng(1);
+  document doc;
+  size_t num_accepted = 0;
+  for (int i = 0; i < 20000; ++i) {
+    std::string text = randomJson(rng, 0);
+    // srrg half of the inputs are damaged, both parsers must agree on those too
+    if (i % 2 && !text.empty()) {
+      const char junk[] = "{}[]:,\" x\\0e-.tn";
+      const size_t pos  = rng() % text.size();
+      text[pos]         = junk[rng() % (sizeof(junk) - 1)];
+    }
+    const value parsed  = value::parse(text);
+    const bool accepted = doc.parse(text);
+    ASSERT_EQ(accepted, !parsed.is_discarded()) << text;
+    if (accepted) {
+      ASSERT_EQ(toValue(doc.root()).dump(), parsed.dump()) << text;
+      ++num_accepted;
+    }
+  }
+  EXPECT_GT(num_accepted, 10000u);
+}
+
+TEST(CrudeJson, RejectsMalformed) {
+  document doc;
+  for (const char* text : malformed) {
+    EXPECT_TRUE(value::parse(text).is_discarded()) << "[" << text << "]";
+    EXPECT_FALSE(doc.parse(text)) << "[" << text << "]";
+    EXPECT_TRUE(doc.root().is_null());
+    EXPECT_EQ(doc.node_count(), 0u);
+  }
+}
+
+TEST(CrudeJson, DocumentLookups) {
+  document doc;
+  ASSERT_TRUE(doc.parse("{\"a\":1,\"b\":[1,{\"c\":null}],\"d\":\"x\\ty\",\"e\":true}"));
+  const document::view root = doc.root();
+  ASSERT_TRUE(root.is_object());
+  EXPECT_EQ(root.size(), 4u);
+  EXPECT_EQ(root["a"].get_number(), 1);
+  EXPECT_EQ(root["b"].size(), 2u);
+  EXPECT_TRUE(root["b"][1]["c"].is_null());
+  EXPECT_TRUE(root["b"][1].contains("c"));
+  EXPECT_TRUE(root["d"].get_string() == "x\ty");
+  EXPECT_TRUE(root["e"].get_boolean());
+
+  // srrg missing keys and indices, or lookups on the wrong type, give a null view
+  EXPECT_FALSE(root.contains("z"));
+  EXPECT_TRUE(root["b"][5].is_null());
+  EXPECT_TRUE(root["a"]["x"].is_null());
+  EXPECT_TRUE(root[size_t(0)].is_null());
+
+  // srrg members come in document order
+  std::string keys;
+  for (auto it = root.begin(); it != root.end(); ++it) {
+    keys += it.key().get_string().str();
+  }
+  EXPECT_EQ(keys, "abde");
+}
+
+TEST(CrudeJson, DocumentReuse) {
+  // srrg containers and keys are values too
+  document doc;
+  ASSERT_TRUE(doc.parse("[1,2,3,[4,5]]"));
+  EXPECT_EQ(doc.node_count(), 7u);
+  ASSERT_TRUE(doc.parse("{\"k\":\"v\"}"));
+  EXPECT_EQ(doc.node_count(), 3u);
+  EXPECT_TRUE(doc.root()["k"].get_string() == "v");
+  ASSERT_FALSE(doc.parse("{\"k\":"));
+  EXPECT_EQ(doc.node_count(), 0u);
+  doc.clear();
+  EXPECT_TRUE(doc.root().is_null());
+}
+
+int main(int argc_, char** argv_) {
+  testing::InitGoogleTest(&argc_, argv_);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,125 @@
+#include "srrg_config_visualizer/layout_engine.h"
+#include "srrg_config_visualizer/layout_graph.h"
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+
+using namespace srrg2_core;
+
+// srrg random dag with shared children and links spanning several levels, sizes vary per node
+void makeGraph(const size_t& num_nodes_,
+               const unsigned& seed_,
+               LayoutGraph& graph_,
+               std::vector<LayoutVec2>& sizes_,
+               std::vector<std::string>& keys_) {
+  std::mt19937 rng(seed_);
+  graph_.clear();
+  graph_.resize(num_nodes_);
+  for (size_t n = 1; n < num_nodes_; ++n) {
+    graph_.addEdge(rng() % n, n);
+    if (n % 5 == 0) {
+      graph_.addEdge(rng() % n, n);
+    }
+  }
+  sizes_.resize(num_nodes_);
+  keys_.resize(num_nodes_);
+  for (size_t n = 0; n < num_nodes_; ++n) {
+    sizes_[n] = LayoutVec2(100 + rng() % 80, 40 + rng() % 60);
+    keys_[n]  = "node_" + std::to_string(n);
+  }
+}
+
+bool overlap(const LayoutVec2& a_pos_,
+             const LayoutVec2& a_size_,
+             const LayoutVec2& b_pos_,
+             const LayoutVec2& b_size_) {
+  return a_pos_.x < b_pos_.x + b_size_.x && b_pos_.x < a_pos_.x + a_size_.x &&
+         a_pos_.y < b_pos_.y + b_size_.y && b_pos_.y < a_pos_.y + a_size_.y;
+}
+
+void expectNoOverlaps(const std::vector<LayoutVec2>& positions_,
+                      const std::vector<LayoutVec2>& sizes_) {
+  for (size_t a = 0; a < positions_.size(); ++a) {
+    for (size_t b = a + 1; b < positions_.size(); ++b) {
+      ASSERT_FALSE(overlap(positions_[a], sizes_[a], positions_[b], sizes_[b]))
+        << "nodes " << a << " and " << b << " overlap";
+    }
+  }
+}
+
+TEST(LayoutEngine, LayeredHasNoOverlaps) {
+  LayoutGraph graph;
+  std::vector<LayoutVec2> sizes;
+  std::vector<std::string> keys;
+  for (unsigned seed = 0; seed < 4; ++seed) {
+    makeGraph(300, seed, graph, sizes, keys);
+    LayoutEngine engine;
+    std::vector<LayoutVec2> positions;
+    engine.compute(graph, sizes, keys, LayoutVec2(100, 100), positions);
+    ASSERT_EQ(positions.size(), graph.size());
+    expectNoOverlaps(positions, sizes);
+  }
+}
+
+TEST(LayoutEngine, SubtreeHasNoOverlaps) {
+  LayoutGraph graph;
+  std::vector<LayoutVec2> sizes;
+  std::vector<std::string> keys;
+  makeGraph(300, 7, graph, sizes, keys);
+  LayoutEngine engine;
+  engine.method = LayoutEngine::Method::Subtree;
+  std::vector<LayoutVec2> positions;
+  engine.compute(graph, sizes, keys, LayoutVec2(100, 100), positions);
+  ASSERT_EQ(positions.size(), graph.size());
+  expectNoOverlaps(positions, sizes);
+}
+
+TEST(LayoutEngine, LayeredColumnsFollowLevels) {
+  LayoutGraph graph;
+  std::vector<LayoutVec2> sizes;
+  std::vector<std::string> keys;
+  makeGraph(300, 3, graph, sizes, keys);
+  LayoutEngine engine;
+  std::vector<LayoutVec2> positions;
+  engine.compute(graph, sizes, keys, LayoutVec2(100, 100), positions);
+
+  // srrg a child is always in a column right of its parents
+  for (size_t parent = 0; parent < graph.size(); ++parent) {
+    for (const size_t& child : graph.children(parent)) {
+      EXPECT_GT(positions[child].x, positions[parent].x);
+    }
+  }
+}
+
+TEST(LayoutEngine, LayeredIsDeterministicAcrossThreads) {
+  LayoutGraph graph;
+  std::vector<LayoutVec2> sizes;
+  std::vector<std::string> keys;
+  makeGraph(1000, 11, graph, sizes, keys);
+
+  std::vector<LayoutVec2> reference;
+  size_t reference_crossings = 0;
+  for (const int& num_threads : {1, 2, 4, 16, 0}) {
+    LayoutEngine engine;
+    engine.num_threads  = num_threads;
+    engine.num_restarts = 8;
+    std::vector<LayoutVec2> positions;
+    engine.compute(graph, sizes, keys, LayoutVec2(100, 100), positions);
+    if (reference.empty()) {
+      reference           = positions;
+      reference_crossings = engine.stats().crossings;
+      continue;
+    }
+    EXPECT_EQ(engine.stats().crossings, reference_crossings) << "threads " << num_threads;
+    ASSERT_EQ(positions.size(), reference.size());
+    for (size_t n = 0; n < positions.size(); ++n) {
+      ASSERT_EQ(positions[n].x, reference[n].x) << "threads " << num_threads << " node " << n;
+      ASSERT_EQ(positions[n].y, reference[n].y) << "threads " << num_threads << " node " << n;
+    }
+  }
+}
+
+int main(int argc_, char** argv_) {
+  testing::InitGoogleTest(&argc_, argv_);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,154 @@
+#include "srrg_config_visualizer/search_index.h"
+#include <gtest/gtest.h>
+
+using namespace srrg2_core;
+using Kind = SearchField::Kind;
+
+class SearchIndexTest : public testing::Test {
+protected:
+  void SetUp() override {
+    index.set(1,
+              {{Kind::Name, "tracker"},
+               {Kind::Class, "MultiTrackerBase"},
+               {Kind::Property, "max_iterations=5"},
+               {Kind::Property, "gain=0.5"}});
+    index.set(2,
+              {{Kind::Name, "aligner"},
+               {Kind::Class, "AlignerSliding"},
+               {Kind::Property, "max_iterations=50"},
+               {Kind::Property, "topic=/tracker/out"}});
+    index.set(3,
+              {{Kind::Name, "my_tracker"},
+               {Kind::Class, "Foo"},
+               {Kind::Property, "max_iterations=10"}});
+  }
+
+  // srrg documents of the hits, best first
+  std::vector<uint64_t> query(const std::string& query_, const size_t& max_hits_ = 100) {
+    std::vector<SearchHit> hits;
+    num_matches = index.query(query_, hits, max_hits_);
+    std::vector<uint64_t> documents;
+    for (const SearchHit& hit : hits) {
+      documents.push_back(hit.document);
+    }
+    return documents;
+  }
+
+  SearchIndex index;
+  size_t num_matches = 0;
+};
+
+TEST_F(SearchIndexTest, RanksWholeFieldsAndNamesFirst) {
+  // srrg a whole name, then a name with the term inside, then a property
+  EXPECT_EQ(query("tracker"), std::vector<uint64_t>({1, 3, 2}));
+  EXPECT_EQ(num_matches, 3u);
+  EXPECT_EQ(query("aligner"), std::vector<uint64_t>({2}));
+}
+
+TEST_F(SearchIndexTest, SplitsWordsAtCamelCaseAndPunctuation) {
+  EXPECT_EQ(query("Base"), std::vector<uint64_t>({1}));
+  EXPECT_EQ(query("sliding"), std::vector<uint64_t>({2}));
+  EXPECT_EQ(query("TRACK").size(), 3u);
+  // srrg a term starts at a word, never inside one
+  EXPECT_TRUE(query("racker").empty());
+  EXPECT_TRUE(query("liding").empty());
+}
+
+TEST_F(SearchIndexTest, MatchesPropertyTerms) {
+  EXPECT_EQ(query("max_iterations=5"), std::vector<uint64_t>({1, 2}));
+  EXPECT_EQ(query("max_iterations = 5"), std::vector<uint64_t>({1, 2}));
+  EXPECT_EQ(query("iterations=10"), std::vector<uint64_t>({3}));
+  EXPECT_EQ(query("gain = 0.5"), std::vector<uint64_t>({1}));
+}
+
+TEST_F(SearchIndexTest, EveryTermMustMatch) {
+  EXPECT_EQ(query("aligner 50"), std::vector<uint64_t>({2}));
+  EXPECT_EQ(query("tracker iterations=10"), std::vector<uint64_t>({3}));
+  EXPECT_TRUE(query("tracker foo gain").empty());
+  EXPECT_TRUE(query("").empty());
+  EXPECT_TRUE(query("  = ").empty());
+}
+
+TEST_F(SearchIndexTest, ReportsMatchedCharacters) {
+  std::vector<SearchHit> hits;
+  ASSERT_EQ(index.query("iterations=1", hits), 1u);
+  const std::string& text = (*index.fields(hits[0].document))[hits[0].field].text;
+  EXPECT_EQ(text, "max_iterations=10");
+  EXPECT_EQ(text.substr(hits[0].match_begin, hits[0].match_end - hits[0].match_begin),
+            "iterations=1");
+}
+
+TEST_F(SearchIndexTest, LimitsHitsButCountsAll) {
+  EXPECT_EQ(query("max", 2).size(), 2u);
+  EXPECT_EQ(num_matches, 3u);
+}
+
+TEST_F(SearchIndexTest, SetReplacesFields) {
+  const size_t revision = index.revision();
+  index.set(3,
+            {{Kind::Name, "my_tracker"},
+             {Kind::Class, "Foo"},
+             {Kind::Property, "max_iterations=10"}});
+  EXPECT_EQ(index.revision(), revision);
+
+  index.set(1,
+            {{Kind::Name, "tracker"},
+             {Kind::Class, "MultiTrackerBase"},
+             {Kind::Property, "max_iterations=7"},
+             {Kind::Property, "gain=0.5"}});
+  EXPECT_NE(index.revision(), revision);
+  EXPECT_EQ(query("max_iterations=5"), std::vector<uint64_t>({2}));
+  EXPECT_EQ(query("max_iterations=7"), std::vector<uint64_t>({1}));
+  EXPECT_EQ(index.size(), 3u);
+}
+
+TEST_F(SearchIndexTest, EraseDropsDocumentAndWords) {
+  const size_t num_words = index.numWords();
+  const size_t revision  = index.revision();
+  index.erase(2);
+  EXPECT_NE(index.revision(), revision);
+  EXPECT_EQ(index.size(), 2u);
+  EXPECT_EQ(index.fields(2), nullptr);
+  EXPECT_TRUE(query("aligner").empty());
+  EXPECT_EQ(query("tracker"), std::vector<uint64_t>({1, 3}));
+  EXPECT_LT(index.numWords(), num_words);
+
+  // srrg erasing twice is harmless, the freed entries are reused
+  index.erase(2);
+  index.set(4, {{Kind::Name, "aligner"}, {Kind::Property, "topic=/tracker/out"}});
+  EXPECT_EQ(query("aligner"), std::vector<uint64_t>({4}));
+  EXPECT_EQ(query("tracker"), std::vector<uint64_t>({1, 3, 4}));
+}
+
+TEST_F(SearchIndexTest, ClearEmptiesIndex) {
+  index.clear();
+  EXPECT_EQ(index.size(), 0u);
+  EXPECT_EQ(index.numWords(), 0u);
+  EXPECT_TRUE(query("tracker").empty());
+  index.set(1, {{Kind::Name, "tracker"}});
+  EXPECT_EQ(query("tracker"), std::vector<uint64_t>({1}));
+}
+
+TEST_F(SearchIndexTest, KeepsFullWidthDocuments) {
+  // srrg instances without a node are indexed with the top bit set
+  const uint64_t hidden = (uint64_t(1) << 63) | 0x7f0012345678;
+  index.set(hidden, {{Kind::Name, "hidden_tracker"}, {Kind::Class, "Foo"}});
+  EXPECT_EQ(query("hidden"), std::vector<uint64_t>({hidden}));
+  ASSERT_NE(index.fields(hidden), nullptr);
+  index.erase(hidden);
+  EXPECT_TRUE(query("hidden").empty());
+}
+
+TEST(SearchWords, SplitsAndLowers) {
+  EXPECT_EQ(searchWords("MultiTrackerBase"),
+            std::vector<std::string>({"multi", "tracker", "base"}));
+  EXPECT_EQ(searchWords("max_iterations=50"),
+            std::vector<std::string>({"max", "iterations", "50"}));
+  EXPECT_EQ(searchWords("IMU data"), std::vector<std::string>({"imu", "data"}));
+  EXPECT_TRUE(searchWords(" _=/ ").empty());
+}
+
+int main(int argc_, char** argv_) {
+  testing::InitGoogleTest(&argc_, argv_);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,187 @@
+#include <cstdio>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <imgui.h>
+#include <imgui_node_editor.h>
+#include <string>
+
+namespace ed = ax::NodeEditor;
+
+const std::string settings_path   = "test_settings_journal.json";
+const std::string journal_path    = settings_path + ".journal";
+const std::string compacting_path = settings_path + ".compacting";
+const int num_nodes               = 20;
+
+size_t countLines(const std::string& path_) {
+  std::ifstream file(path_);
+  std::string line;
+  size_t count = 0;
+  while (std::getline(file, line)) {
+    count += !line.empty();
+  }
+  return count;
+}
+
+bool exists(const std::string& path_) {
+  return static_cast<bool>(std::ifstream(path_));
+}
+
+void removeFiles() {
+  std::remove(settings_path.c_str());
+  std::remove(journal_path.c_str());
+  std::remove(compacting_path.c_str());
+}
+
+ImVec2 movedPosition(const int& node_) {
+  return ImVec2(10.f * node_ + 3, 7);
+}
+
+// srrg one session of the editor, the journal is flushed and compacted when it is destroyed
+class Session {
+public:
+  Session(const bool& journal_, const int& compact_limit_) {
+    ed::Config config;
+    config.SettingsFile                = settings_path.c_str();
+    config.SettingsJournal             = journal_;
+    config.SettingsJournalCompactLimit = compact_limit_;
+    _editor                            = ed::CreateEditor(&config);
+    frame(-1);
+  }
+  ~Session() {
+    ed::DestroyEditor(_editor);
+  }
+
+  // srrg submits the nodes, node_ is moved first if it is one of them, i.e. one save
+  void frame(const int& node_) {
+    ImGui::NewFrame();
+    ImGui::SetNextWindowPos(ImVec2(0, 0));
+    ImGui::SetNextWindowSize(ImVec2(800, 600));
+    ImGui::Begin("canvas");
+    ed::SetCurrentEditor(_editor);
+    ed::Begin("editor");
+    for (int n = 1; n <= num_nodes; ++n) {
+      if (n == node_) {
+        ed::SetNodePosition(n, movedPosition(n));
+      }
+      ed::BeginNode(n);
+      ImGui::Text("node");
+      ed::EndNode();
+    }
+    ed::End();
+    ed::SetCurrentEditor(nullptr);
+    ImGui::End();
+    ImGui::Render();
+  }
+
+  ImVec2 position(const int& node_) {
+    ed::SetCurrentEditor(_editor);
+    const ImVec2 position = ed::GetNodePosition(node_);
+    ed::SetCurrentEditor(nullptr);
+    return position;
+  }
+
+protected:
+  ed::EditorContext* _editor = nullptr;
+};
+
+class SettingsJournal : public testing::Test {
+protected:
+  void SetUp() override {
+    removeFiles();
+    ImGui::CreateContext();
+    ImGuiIO& io    = ImGui::GetIO();
+    io.DisplaySize = ImVec2(800, 600);
+    io.IniFilename = nullptr;
+    io.DeltaTime   = 1.f / 60.f;
+    unsigned char* pixels;
+    int width, height;
+    io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+  }
+  void TearDown() override {
+    ImGui::DestroyContext();
+    removeFiles();
+  }
+
+  void expectMoved(Session& session_, const int& num_moved_) {
+    for (int n = 1; n <= num_moved_; ++n) {
+      const ImVec2 position = session_.position(n);
+      EXPECT_EQ(position.x, movedPosition(n).x) << "node " << n;
+      EXPECT_EQ(position.y, movedPosition(n).y) << "node " << n;
+    }
+  }
+};
+
+TEST_F(SettingsJournal, AppendsOneRecordPerSave) {
+  {
+    Session session(true, 1000);
+    // srrg the first frame records the new nodes
+    const size_t initial_records = countLines(journal_path);
+    for (int n = 1; n <= 6; ++n) {
+      session.frame(n);
+      EXPECT_EQ(countLines(journal_path), initial_records + n);
+    }
+  }
+  EXPECT_FALSE(exists(compacting_path));
+
+  Session session(true, 1000);
+  expectMoved(session, 6);
+}
+
+TEST_F(SettingsJournal, CompactsIntoSettingsFile) {
+  const int compact_limit = 5;
+  size_t num_records      = 0;
+  {
+    Session session(true, compact_limit);
+    num_records = countLines(journal_path);
+    for (int n = 1; n <= 12; ++n) {
+      session.frame(n);
+      ++num_records;
+    }
+  }
+  // srrg the folded records left the journal, nothing is left half compacted. How many depends
+  // on the saves made while the worker was running, those wait for the next compaction
+  EXPECT_LE(countLines(journal_path), num_records - compact_limit);
+  EXPECT_FALSE(exists(compacting_path));
+  EXPECT_TRUE(exists(settings_path));
+
+  Session session(true, compact_limit);
+  expectMoved(session, 12);
+}
+
+TEST_F(SettingsJournal, CompactedFileLoadsWithoutJournal) {
+  const int compact_limit = 6;
+  int num_folded          = 0;
+  {
+    Session session(true, compact_limit);
+    // srrg the save filling the journal folds it, later ones stay in the journal
+    num_folded = compact_limit - static_cast<int>(countLines(journal_path));
+    ASSERT_GT(num_folded, 0);
+    for (int n = 1; n <= num_folded + 2; ++n) {
+      session.frame(n);
+    }
+  }
+  std::remove(journal_path.c_str());
+
+  Session session(false, compact_limit);
+  expectMoved(session, num_folded);
+  EXPECT_NE(session.position(num_folded + 1).x, movedPosition(num_folded + 1).x);
+}
+
+TEST_F(SettingsJournal, ReplaysAnInterruptedCompaction) {
+  {
+    Session session(true, 1000);
+    for (int n = 1; n <= 6; ++n) {
+      session.frame(n);
+    }
+  }
+  // srrg as if the process died while folding the journal
+  ASSERT_EQ(std::rename(journal_path.c_str(), compacting_path.c_str()), 0);
+
+  Session session(true, 1000);
+  expectMoved(session, 6);
+}
+
+int main(int argc_, char** argv_) {
+  testing::InitGoogleTest(&argc_, argv_);
+  return RUN_ALL_TESTS();
+}
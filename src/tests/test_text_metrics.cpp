@@ -0,0 +1,113 @@
+#include "srrg_config_visualizer/text_metrics.h"
+#include <gtest/gtest.h>
+
+using namespace srrg2_core;
+
+// srrg a frame with a window open, the text is measured in its font
+class TextMetrics : public testing::Test {
+protected:
+  void SetUp() override {
+    ImGui::CreateContext();
+    ImGuiIO& io    = ImGui::GetIO();
+    io.DisplaySize = ImVec2(800, 600);
+    io.IniFilename = nullptr;
+    io.DeltaTime   = 1.f / 60.f;
+    io.Fonts->AddFontDefault();
+    ImFontConfig config;
+    config.SizePixels = 26.f;
+    _large_font       = io.Fonts->AddFontDefault(&config);
+    unsigned char* pixels;
+    int width, height;
+    io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+
+    CachedText::setCaching(true);
+    ImGui::NewFrame();
+    ImGui::Begin("text");
+  }
+  void TearDown() override {
+    ImGui::End();
+    ImGui::Render();
+    ImGui::DestroyContext();
+    CachedText::setCaching(true);
+  }
+
+  static void expectSize(const CachedText& text_) {
+    const ImVec2 expected = ImGui::CalcTextSize(text_.c_str());
+    EXPECT_EQ(text_.size().x, expected.x) << text_.text();
+    EXPECT_EQ(text_.size().y, expected.y) << text_.text();
+  }
+
+  ImFont* _large_font = nullptr;
+};
+
+TEST_F(TextMetrics, MeasuresOncePerFont) {
+  const CachedText text("MultiTracker");
+  const size_t measurements = CachedText::measurements();
+  expectSize(text);
+  for (int i = 0; i < 10; ++i) {
+    text.size();
+  }
+  EXPECT_EQ(CachedText::measurements(), measurements + 1);
+}
+
+TEST_F(TextMetrics, SetTextInvalidates) {
+  CachedText text("short");
+  expectSize(text);
+  size_t measurements = CachedText::measurements();
+
+  // srrg the same text keeps the cached size
+  text.setText("short");
+  text.size();
+  EXPECT_EQ(CachedText::measurements(), measurements);
+
+  text.setText("a much longer label");
+  expectSize(text);
+  EXPECT_EQ(CachedText::measurements(), measurements + 1);
+}
+
+TEST_F(TextMetrics, FontChangeInvalidates) {
+  const CachedText text("max_iterations");
+  const ImVec2 default_size = text.size();
+  const size_t measurements = CachedText::measurements();
+
+  ImGui::PushFont(_large_font);
+  expectSize(text);
+  EXPECT_GT(text.size().y, default_size.y);
+  ImGui::PopFont();
+  EXPECT_EQ(text.size().x, default_size.x);
+  EXPECT_EQ(CachedText::measurements(), measurements + 2);
+
+  // srrg a scaled window changes the font size, not the font
+  ImGui::SetWindowFontScale(2.f);
+  expectSize(text);
+  EXPECT_GT(text.size().x, default_size.x);
+  ImGui::SetWindowFontScale(1.f);
+  EXPECT_EQ(text.size().x, default_size.x);
+}
+
+TEST_F(TextMetrics, DisabledCachingMeasuresEveryCall) {
+  const CachedText text("label");
+  CachedText::setCaching(false);
+  const size_t measurements = CachedText::measurements();
+  for (int i = 0; i < 5; ++i) {
+    expectSize(text);
+  }
+  EXPECT_GE(CachedText::measurements(), measurements + 5);
+}
+
+TEST_F(TextMetrics, DrawAdvancesLikeTextUnformatted) {
+  const CachedText text("pin_name");
+  const ImVec2 start = ImGui::GetCursorPos();
+  ImGui::TextUnformatted(text.c_str());
+  const ImVec2 plain_advance(ImGui::GetCursorPos().x - start.x, ImGui::GetCursorPos().y - start.y);
+
+  const ImVec2 cached_start = ImGui::GetCursorPos();
+  text.draw();
+  EXPECT_EQ(ImGui::GetCursorPos().x - cached_start.x, plain_advance.x);
+  EXPECT_EQ(ImGui::GetCursorPos().y - cached_start.y, plain_advance.y);
+}
+
+int main(int argc_, char** argv_) {
+  testing::InitGoogleTest(&argc_, argv_);
+  return RUN_ALL_TESTS();
+}
@@ -5,3 +5,8 @@ const char* srrg2_ine_Application_GetName();
 void srrg2_ine_Application_Initialize();
 void srrg2_ine_Application_Finalize();
 void srrg2_ine_Application_Frame();
+// called once per frame after the window is cleared, must call ImGui::Render()
+void srrg2_ine_Application_Render();
+// frames are drawn only after input or window events, unless this returns true (animations,
+// background work, ...)
+bool srrg2_ine_Application_WantsRedraw();
@@ -13,6 +13,83 @@ static void error_callback(int error, const char* description) {
   fprintf(stderr, "Error %d: %s\n", error, description);
 }
 
+// srrg frames still to draw after the last event, imgui needs a few to settle hover and popups
+static const int settle_frames = 3;
+// srrg upper bound of an idle wait, so WantsRedraw() is polled even without events
+static const double idle_timeout = 0.25;
+static int redraw_frames         = settle_frames;
+
+static GLFWmousebuttonfun prev_mouse_button_callback = nullptr;
+static GLFWscrollfun prev_scroll_callback            = nullptr;
+static GLFWkeyfun prev_key_callback                  = nullptr;
+static GLFWcharfun prev_char_callback                = nullptr;
+
+static void markDirty() {
+  redraw_frames = settle_frames;
+}
+
+static void mouse_button_callback(GLFWwindow* window, int button, int action, int mods) {
+  markDirty();
+  if (prev_mouse_button_callback) {
+    prev_mouse_button_callback(window, button, action, mods);
+  }
+}
+
+static void scroll_callback(GLFWwindow* window, double x_offset, double y_offset) {
+  markDirty();
+  if (prev_scroll_callback) {
+    prev_scroll_callback(window, x_offset, y_offset);
+  }
+}
+
+static void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+  markDirty();
+  if (prev_key_callback) {
+    prev_key_callback(window, key, scancode, action, mods);
+  }
+}
+
+static void char_callback(GLFWwindow* window, unsigned int c) {
+  markDirty();
+  if (prev_char_callback) {
+    prev_char_callback(window, c);
+  }
+}
+
+static void cursor_pos_callback(GLFWwindow*, double, double) {
+  markDirty();
+}
+
+static void cursor_enter_callback(GLFWwindow*, int) {
+  markDirty();
+}
+
+static void window_callback(GLFWwindow*, int, int) {
+  markDirty();
+}
+
+static void window_refresh_callback(GLFWwindow*) {
+  markDirty();
+}
+
+static void window_focus_callback(GLFWwindow*, int) {
+  markDirty();
+}
+
+// srrg chains to the imgui callbacks and marks the frame dirty on every window event
+static void installRedrawCallbacks(GLFWwindow* window) {
+  prev_mouse_button_callback = glfwSetMouseButtonCallback(window, mouse_button_callback);
+  prev_scroll_callback       = glfwSetScrollCallback(window, scroll_callback);
+  prev_key_callback          = glfwSetKeyCallback(window, key_callback);
+  prev_char_callback         = glfwSetCharCallback(window, char_callback);
+  glfwSetCursorPosCallback(window, cursor_pos_callback);
+  glfwSetCursorEnterCallback(window, cursor_enter_callback);
+  glfwSetWindowSizeCallback(window, window_callback);
+  glfwSetFramebufferSizeCallback(window, window_callback);
+  glfwSetWindowRefreshCallback(window, window_refresh_callback);
+  glfwSetWindowFocusCallback(window, window_focus_callback);
+}
+
 int main(int argc, char** argv) {
   srrg2_core::srrgInit(argc, argv, "srrg2_config_visualizer");
 
@@ -32,6 +109,7 @@ int main(int argc, char** argv) {
 
   // Setup ImGui binding
   ImGui_ImplGlfwGL3_Init(window, true);
+  installRedrawCallbacks(window);
 
   ImGuiIO& io = ImGui::GetIO();
 
@@ -43,7 +121,19 @@ int main(int argc, char** argv) {
 
   // Main loop
   while (!glfwWindowShouldClose(window)) {
-    glfwPollEvents();
+    // srrg sleep until something happens, an idle window does not redraw
+    if (redraw_frames > 0 || srrg2_ine_Application_WantsRedraw()) {
+      glfwPollEvents();
+    } else {
+      glfwWaitEventsTimeout(idle_timeout);
+      if (redraw_frames == 0 && !srrg2_ine_Application_WantsRedraw()) {
+        continue;
+      }
+    }
+    if (redraw_frames > 0) {
+      --redraw_frames;
+    }
+
     ImGui_ImplGlfwGL3_NewFrame();
 
     ImGui::SetNextWindowPos(ImVec2(0, 0));
@@ -67,7 +157,7 @@ int main(int argc, char** argv) {
     glViewport(0, 0, display_w, display_h);
     glClearColor(clear_color.x, clear_color.y, clear_color.z, clear_color.w);
     glClear(GL_COLOR_BUFFER_BIT);
-    ImGui::Render();
+    srrg2_ine_Application_Render();
     glfwSwapBuffers(window);
   }
 
@@ -43,6 +43,23 @@ struct BlueprintNodeBuilder
     void Footer();
     void EndFooter();
 
+    struct HeaderBand {
+      ImVec2 Min;
+      ImVec2 Max;
+      // Line between header and content, only drawn when the content starts below the header.
+      bool HasSeparator = false;
+      ImVec2 SeparatorBegin;
+      ImVec2 SeparatorEnd;
+
+      void Translate(const ImVec2& offset);
+    };
+
+    // Header band filled by End() for the last node built, false if it had no header.
+    bool GetHeaderBand(HeaderBand& band) const;
+
+    // Draws a header band as End() does, for nodes submitted without the builder.
+    static void DrawHeader(NodeId id, const HeaderBand& band, ImU32 color);
+
 private:
     enum class Stage
     {
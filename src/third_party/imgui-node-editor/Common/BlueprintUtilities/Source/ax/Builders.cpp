@@ -46,30 +46,9 @@ void util::BlueprintNodeBuilder::End() {
   ed::EndNode();
 
   if (ImGui::IsItemVisible()) {
-    auto alpha = static_cast<int>(255 * ImGui::GetStyle().Alpha);
-
-    auto drawList = ed::GetNodeBackgroundDrawList(CurrentNodeId);
-
-    const auto halfBorderWidth = ed::GetStyle().NodeBorderWidth * 0.5f;
-
-    auto headerColor = IM_COL32(0, 0, 0, alpha) | (HeaderColor & IM_COL32(255, 255, 255, 0));
-    if (!HeaderRect.is_empty()) {
-      drawList->AddRectFilled(to_imvec(HeaderRect.top_left()) -
-                                ImVec2(8 - halfBorderWidth, 4 - halfBorderWidth),
-                              to_imvec(HeaderRect.bottom_right()) + ImVec2(8 - halfBorderWidth, 0),
-                              headerColor,
-                              GetStyle().NodeRounding,
-                              1 | 2);
-
-      auto headerSeparatorRect = ax::rect(HeaderRect.bottom_left(), ContentRect.top_right());
-      if (!headerSeparatorRect.is_empty()) {
-        drawList->AddLine(
-          to_imvec(headerSeparatorRect.top_left()) + ImVec2(-(8 - halfBorderWidth), -0.5f),
-          to_imvec(headerSeparatorRect.top_right()) + ImVec2((8 - halfBorderWidth), -0.5f),
-          ImColor(255, 255, 255, 96 * alpha / (3 * 255)),
-          1.0f);
-      }
-    }
+    HeaderBand header;
+    if (GetHeaderBand(header))
+      DrawHeader(CurrentNodeId, header, HeaderColor);
 
     //    drawList->AddRect(
     //      to_imvec(NodeRect.top_left()), to_imvec(NodeRect.bottom_right()), IM_COL32(255, 0, 0,
@@ -91,6 +70,47 @@ void util::BlueprintNodeBuilder::End() {
   SetStage(Stage::Invalid);
 }
 
+void util::BlueprintNodeBuilder::HeaderBand::Translate(const ImVec2& offset) {
+  Min            = Min + offset;
+  Max            = Max + offset;
+  SeparatorBegin = SeparatorBegin + offset;
+  SeparatorEnd   = SeparatorEnd + offset;
+}
+
+bool util::BlueprintNodeBuilder::GetHeaderBand(HeaderBand& band) const {
+  if (HeaderRect.is_empty())
+    return false;
+
+  const auto halfBorderWidth = ed::GetStyle().NodeBorderWidth * 0.5f;
+
+  band.Min = to_imvec(HeaderRect.top_left()) - ImVec2(8 - halfBorderWidth, 4 - halfBorderWidth);
+  band.Max = to_imvec(HeaderRect.bottom_right()) + ImVec2(8 - halfBorderWidth, 0);
+
+  auto headerSeparatorRect = ax::rect(HeaderRect.bottom_left(), ContentRect.top_right());
+  band.HasSeparator        = !headerSeparatorRect.is_empty();
+  band.SeparatorBegin =
+    to_imvec(headerSeparatorRect.top_left()) + ImVec2(-(8 - halfBorderWidth), -0.5f);
+  band.SeparatorEnd =
+    to_imvec(headerSeparatorRect.top_right()) + ImVec2((8 - halfBorderWidth), -0.5f);
+  return true;
+}
+
+void util::BlueprintNodeBuilder::DrawHeader(ed::NodeId id, const HeaderBand& band, ImU32 color) {
+  auto alpha = static_cast<int>(255 * ImGui::GetStyle().Alpha);
+
+  auto drawList = ed::GetNodeBackgroundDrawList(id);
+
+  auto headerColor = IM_COL32(0, 0, 0, alpha) | (color & IM_COL32(255, 255, 255, 0));
+  drawList->AddRectFilled(band.Min, band.Max, headerColor, GetStyle().NodeRounding, 1 | 2);
+
+  if (band.HasSeparator) {
+    drawList->AddLine(band.SeparatorBegin,
+                      band.SeparatorEnd,
+                      ImColor(255, 255, 255, 96 * alpha / (3 * 255)),
+                      1.0f);
+  }
+}
+
 void util::BlueprintNodeBuilder::Header(const ImVec4& color) {
   HeaderColor = ImColor(color);
   SetStage(Stage::Header);
@@ -61,6 +61,9 @@ struct Config
     ConfigSaveNodeSettings  SaveNodeSettings;
     ConfigLoadNodeSettings  LoadNodeSettings;
     void*                   UserPointer;
+    bool                    SharedNodeChannels; // draw all regular nodes in one set of layers, overlapping nodes lose their z-order
+    bool                    SettingsJournal;    // append changes to "<SettingsFile>.journal" instead of rewriting SettingsFile on every save
+    int                     SettingsJournalCompactLimit; // records appended before the journal is folded back into SettingsFile
 
     Config()
         : SettingsFile("NodeEditor.json")
@@ -71,6 +74,9 @@ struct Config
         , SaveNodeSettings(nullptr)
         , LoadNodeSettings(nullptr)
         , UserPointer(nullptr)
+        , SharedNodeChannels(false)
+        , SettingsJournal(false)
+        , SettingsJournalCompactLimit(256)
     {
     }
 };
@@ -14,11 +14,22 @@
 # include <clocale>
 # include <cmath>
 # include <cstring>
+# include <cstdio>
+
+# if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#     define CRUDE_JSON_SSE2() 1
+#     include <emmintrin.h>
+#     if defined(_MSC_VER)
+#         include <intrin.h>
+#     endif
+# else
+#     define CRUDE_JSON_SSE2() 0
+# endif
 
 
 namespace crude_json {
 
-value::value(value&& other)
+value::value(value&& other) noexcept
     : m_Type(other.m_Type)
 {
     switch (m_Type)
@@ -175,13 +186,16 @@ void value::swap(value& other)
 
 string value::dump(const int indent, const char indent_char) const
 {
-    dump_context_t context(indent, indent_char);
+    string result;
+    dump(result, indent, indent_char);
+    return result;
+}
 
-    context.out.precision(std::numeric_limits<double>::max_digits10 + 1);
-    context.out << std::defaultfloat;
+void value::dump(string& out, const int indent, const char indent_char) const
+{
+    dump_context_t context(out, indent, indent_char);
 
     dump(context, 0);
-    return context.out.str();
 }
 
 void value::dump_context_t::write_indent(int level)
@@ -189,10 +203,7 @@ void value::dump_context_t::write_indent(int level)
     if (indent <= 0 || level == 0)
         return;
 
-    out.fill(indent_char);
-    out.width(indent * level);
-    out << indent_char;
-    out.width(0);
+    out.append(static_cast<size_t>(indent * level), indent_char);
 }
 
 void value::dump_context_t::write_separator()
@@ -200,7 +211,7 @@ void value::dump_context_t::write_separator()
     if (indent < 0)
         return;
 
-    out.put(' ');
+    out.push_back(' ');
 }
 
 void value::dump_context_t::write_newline()
@@ -208,7 +219,99 @@ void value::dump_context_t::write_newline()
     if (indent < 0)
         return;
 
-    out.put('\n');
+    out.push_back('\n');
+}
+
+void value::dump_context_t::write_string(const string& value)
+{
+    out.push_back('\"');
+
+    // Characters between escapes are copied in runs.
+    auto run = value.data();
+    auto end = value.data() + value.size();
+    for (auto c = run; c != end; ++c)
+    {
+        const char* escape = nullptr;
+        switch (*c)
+        {
+            case '\"': escape = "\\\"";    break;
+            case '\\': escape = "\\\\";    break;
+            case '/':  escape = "\\/";     break;
+            case '\b': escape = "\\b";     break;
+            case '\f': escape = "\\f";     break;
+            case '\n': escape = "\\n";     break;
+            case '\r': escape = "\\r";     break;
+            case '\t': escape = "\\t";     break;
+            case 0:    escape = "\\u0000"; break;
+            default: continue;
+        }
+
+        out.append(run, c);
+        out.append(escape);
+        run = c + 1;
+    }
+    out.append(run, end);
+
+    out.push_back('\"');
+}
+
+// Exact powers of ten, a double holds them without rounding up to 1e22.
+static const double c_PowersOf10[] =
+{
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Largest integer below which every integer is exact in a double.
+static const double c_MaxExactInteger = 9007199254740992.0;
+
+void value::dump_context_t::write_number(number value)
+{
+    // Integers and decimals with up to six fraction digits are written without going through
+    // snprintf. mantissa / 10^digits rounds the same exact fraction strtod() rounds when
+    // reading the text back, so the value survives the round trip.
+    if (std::fabs(value) < 1e15)
+    {
+        for (int digits = 0; digits <= 6; ++digits)
+        {
+            auto mantissa = std::nearbyint(value * c_PowersOf10[digits]);
+            if (std::fabs(mantissa) >= c_MaxExactInteger)
+                break;
+            if (mantissa / c_PowersOf10[digits] != value)
+                continue;
+
+            // Digits are produced backwards, with a leading zero before the dot if needed.
+            char buffer[32];
+            auto end   = buffer + sizeof(buffer);
+            auto begin = end;
+            auto magnitude = static_cast<uint64_t>(std::fabs(mantissa));
+            for (int i = 0; magnitude || i <= digits; ++i)
+            {
+                if (i == digits && digits > 0)
+                    *--begin = '.';
+                *--begin = static_cast<char>('0' + magnitude % 10);
+                magnitude /= 10;
+            }
+            if (std::signbit(value))
+                *--begin = '-';
+
+            out.append(begin, end);
+            return;
+        }
+    }
+
+    // Same digits as std::ostream with max_digits10 + 1 precision.
+    char buffer[32];
+    auto size = std::snprintf(buffer, sizeof(buffer), "%.*g", std::numeric_limits<double>::max_digits10 + 1, value);
+    if (size <= 0)
+        return;
+
+    // snprintf follows the C locale, JSON wants a dot.
+    for (auto c = buffer; c != buffer + size; ++c)
+        if (*c == ',')
+            *c = '.';
+
+    out.append(buffer, static_cast<size_t>(size));
 }
 
 void value::dump(dump_context_t& context, int level) const
@@ -218,19 +321,20 @@ void value::dump(dump_context_t& context, int level) const
     switch (m_Type)
     {
         case type_t::null:
-            context.out << "null";
+            context.out.append("null");
             break;
 
         case type_t::object:
-            context.out << '{';
+            context.out.push_back('{');
             {
                 context.write_newline();
                 bool first = true;
                 for (auto& entry : *object_ptr(m_Storage))
                 {
-                    if (!first) { context.out << ','; context.write_newline(); } else first = false;
+                    if (!first) { context.out.push_back(','); context.write_newline(); } else first = false;
                     context.write_indent(level + 1);
-                    context.out << '\"' << entry.first << "\":";
+                    context.write_string(entry.first);
+                    context.out.push_back(':');
                     if (!entry.second.is_structured())
                     {
                         context.write_separator();
@@ -246,17 +350,17 @@ void value::dump(dump_context_t& context, int level) const
                     context.write_newline();
             }
             context.write_indent(level);
-            context.out << '}';
+            context.out.push_back('}');
             break;
 
         case type_t::array:
-            context.out << '[';
+            context.out.push_back('[');
             {
                 context.write_newline();
                 bool first = true;
                 for (auto& entry : *array_ptr(m_Storage))
                 {
-                    if (!first) { context.out << ','; context.write_newline(); } else first = false;
+                    if (!first) { context.out.push_back(','); context.write_newline(); } else first = false;
                     if (!entry.is_structured())
                     {
                         context.write_indent(level + 1);
@@ -271,43 +375,22 @@ void value::dump(dump_context_t& context, int level) const
                     context.write_newline();
             }
             context.write_indent(level);
-            context.out << ']';
+            context.out.push_back(']');
             break;
 
         case type_t::string:
-            context.out << '\"';
-
-            if (string_ptr(m_Storage)->find_first_of("\"\\/\b\f\n\r") != string::npos || string_ptr(m_Storage)->find('\0') != string::npos)
-            {
-                for (auto c : *string_ptr(m_Storage))
-                {
-                         if (c == '\"')  context.out << "\\\"";
-                    else if (c == '\\')  context.out << "\\\\";
-                    else if (c == '/')   context.out << "\\/";
-                    else if (c == '\b')  context.out << "\\b";
-                    else if (c == '\f')  context.out << "\\f";
-                    else if (c == '\n')  context.out << "\\n";
-                    else if (c == '\r')  context.out << "\\r";
-                    else if (c == '\t')  context.out << "\\t";
-                    else if (c == 0)     context.out << "\\u0000";
-                    else                 context.out << c;
-                }
-            }
-            else
-                context.out << *string_ptr(m_Storage);
-            context.out << '\"';
+            context.write_string(*string_ptr(m_Storage));
             break;
 
-
         case type_t::boolean:
             if (*boolean_ptr(m_Storage))
-                context.out << "true";
+                context.out.append("true");
             else
-                context.out << "false";
+                context.out.append("false");
             break;
 
         case type_t::number:
-            context.out << *number_ptr(m_Storage);
+            context.write_number(*number_ptr(m_Storage));
             break;
 
         default:
@@ -315,500 +398,917 @@ void value::dump(dump_context_t& context, int level) const
     }
 }
 
-struct value::parser
+// Scanning shared by value and document parsers. Each function reads from p,
+// leaves p past what it consumed and returns false on invalid input.
+
+static const char* find_quote_or_escape(const char* p, const char* end)
 {
-    parser(const char* begin, const char* end)
-        : m_Cursor(begin)
-        , m_End(end)
+# if CRUDE_JSON_SSE2()
+    const auto quote     = _mm_set1_epi8('\"');
+    const auto backslash = _mm_set1_epi8('\\');
+    for (; end - p >= 16; p += 16)
     {
+        const auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        const auto mask  = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)));
+        if (mask)
+        {
+#     if defined(_MSC_VER)
+            unsigned long index;
+            _BitScanForward(&index, static_cast<unsigned long>(mask));
+            return p + index;
+#     else
+            return p + __builtin_ctz(static_cast<unsigned>(mask));
+#     endif
+        }
     }
+# endif
 
-    value parse()
-    {
-        value v;
+    while (p != end && *p != '\"' && *p != '\\')
+        ++p;
 
-        // Switch to C locale to make strtod and strtol work as expected
-        auto previous_locale = std::setlocale(LC_NUMERIC, "C");
+    return p;
+}
 
-        // Accept single value only when end of the stream is reached.
-        if (!accept_element(v) || !eof())
-            v = value(type_t::discarded);
+static bool is_digit(int c)   { return c >= '0' && c <= '9'; }
+static bool is_onenine(int c) { return c >= '1' && c <= '9'; }
 
-        if (previous_locale && strcmp(previous_locale, "C") != 0)
-            std::setlocale(LC_NUMERIC, previous_locale);
+static bool parse_hex4(const char*& p, const char* end, unsigned& result)
+{
+    if (end - p < 4)
+        return false;
 
-        return v;
+    for (int i = 0; i < 4; ++i)
+    {
+        auto c = *p++;
+        unsigned digit;
+             if (c >= '0' && c <= '9') digit = c - '0';
+        else if (c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') digit = c - 'A' + 10;
+        else return false;
+
+        result = (result << 4) | digit;
     }
 
-private:
-    struct cursor_state
+    return true;
+}
+
+// Writes up to 4 bytes, returns their count.
+static size_t encode_utf8(unsigned code_point, char* out)
+{
+    if (code_point < 0x80)
     {
-        cursor_state(parser* p)
-            : m_Owner(p)
-            , m_LastCursor(p->m_Cursor)
-        {
-        }
+        out[0] = static_cast<char>(code_point);
+        return 1;
+    }
+    else if (code_point < 0x800)
+    {
+        out[0] = static_cast<char>(0xC0 | (code_point >> 6));
+        out[1] = static_cast<char>(0x80 | (code_point & 0x3F));
+        return 2;
+    }
+    else if (code_point < 0x10000)
+    {
+        out[0] = static_cast<char>(0xE0 | (code_point >> 12));
+        out[1] = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+        out[2] = static_cast<char>(0x80 | (code_point & 0x3F));
+        return 3;
+    }
+    else
+    {
+        out[0] = static_cast<char>(0xF0 | (code_point >> 18));
+        out[1] = static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+        out[2] = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+        out[3] = static_cast<char>(0x80 | (code_point & 0x3F));
+        return 4;
+    }
+}
 
-        void reset()
-        {
-            m_Owner->m_Cursor = m_LastCursor;
-        }
+// Decodes the escape following a backslash into up to 4 bytes of out. Output
+// is never longer than the escape, so strings can be unescaped in place.
+static bool parse_escape(const char*& p, const char* end, char* out, size_t& out_size)
+{
+    if (p == end)
+        return false;
 
-        bool operator()(bool accept)
-        {
-            if (!accept)
-                reset();
-            else
-                m_LastCursor = m_Owner->m_Cursor;
-            return accept;
-        }
+    out_size = 1;
+    switch (*p++)
+    {
+        case '\"': out[0] = '\"'; return true;
+        case '\\': out[0] = '\\'; return true;
+        case '/':  out[0] = '/';  return true;
+        case 'b':  out[0] = '\b'; return true;
+        case 'f':  out[0] = '\f'; return true;
+        case 'n':  out[0] = '\n'; return true;
+        case 'r':  out[0] = '\r'; return true;
+        case 't':  out[0] = '\t'; return true;
+        case 'u':  break;
+        default:   return false;
+    }
 
-    private:
-        parser*     m_Owner;
-        const char* m_LastCursor;
-    };
+    unsigned code_point = 0;
+    if (!parse_hex4(p, end, code_point))
+        return false;
 
-    cursor_state state()
+    // Surrogate pair, the low half follows as another \u escape.
+    if (code_point >= 0xD800 && code_point <= 0xDBFF && end - p >= 6 && p[0] == '\\' && p[1] == 'u')
     {
-        return cursor_state(this);
+        auto s = p;
+        p += 2;
+
+        unsigned low = 0;
+        if (parse_hex4(p, end, low) && low >= 0xDC00 && low <= 0xDFFF)
+            code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+        else
+            p = s;
     }
 
-    bool accept_value(value& result)
+    out_size = encode_utf8(code_point, out);
+    return true;
+}
+
+static bool parse_number(const char*& p, const char* end, number& result)
+{
+    auto begin  = p;
+    auto peek   = [&p, end]() -> int { return p != end ? *p : -1; };
+    auto accept = [&p, end](char c) { if (p == end || *p != c) return false; ++p; return true; };
+
+    // Validate JSON number grammar first, strtod accepts more than that. Digits are
+    // collected on the way for the fast path below.
+    auto negative = accept('-');
+
+    uint64_t mantissa        = 0;
+    int      digits          = 0;
+    int      fraction_digits = 0;
+    if (accept('0'))
+        digits = 1;
+    else if (is_onenine(peek()))
     {
-        return accept_object(result)
-            || accept_array(result)
-            || accept_string(result)
-            || accept_number(result)
-            || accept_boolean(result)
-            || accept_null(result);
+        for (; is_digit(peek()); ++p, ++digits)
+            mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
     }
+    else
+        return false;
 
-    bool accept_object(value& result)
+    if (accept('.'))
     {
-        auto s = state();
-
-        object o;
-        if (s(accept('{') && accept_ws() && accept('}')))
-        {
-            result = o;
-            return true;
-        }
-        else if (s(accept('{') && accept_members(o) && accept('}')))
-        {
-            result = std::move(o);
-            return true;
-        }
+        if (!is_digit(peek()))
+            return false;
 
-        return false;
+        for (; is_digit(peek()); ++p, ++fraction_digits)
+            mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
     }
 
-    bool accept_members(object& o)
+    bool has_exponent = false;
+    if (accept('e') || accept('E'))
     {
-        if (!accept_member(o))
+        has_exponent = true;
+        if (!accept('+'))
+            accept('-');
+        if (!is_digit(peek()))
             return false;
+        while (is_digit(peek()))
+            ++p;
+    }
 
-        while (true)
-        {
-            auto s = state();
-            if (!s(accept(',') && accept_member(o)))
-                break;
-        }
-
+    // Up to 15 digits the mantissa is exact, and so are powers of ten up to 1e22. Dividing
+    // them rounds once, which is what strtod does.
+    if (!has_exponent && digits + fraction_digits <= 15 && fraction_digits <= 22)
+    {
+        auto v = static_cast<number>(mantissa) / c_PowersOf10[fraction_digits];
+        result = negative ? -v : v;
         return true;
     }
 
-    bool accept_member(object& o)
+    // strtod needs the number to be followed by something that is not a part of it,
+    // copy it if it ends the buffer.
+    string copy;
+    auto text = begin;
+    if (p == end)
     {
-        auto s = state();
+        copy.assign(begin, p);
+        text = copy.c_str();
+    }
 
-        value key;
-        value v;
-        if (s(accept_ws() && accept_string(key) && accept_ws() && accept(':') && accept_element(v)))
-        {
-            o.emplace(std::move(key.get<string>()), std::move(v));
-            return true;
-        }
+    char* number_end = nullptr;
+    auto v = std::strtod(text, &number_end);
+    if (number_end != text + (p - begin))
+        return false;
 
+    if (!std::isfinite(v))
         return false;
-    }
 
-    bool accept_array(value& result)
+    result = v;
+    return true;
+}
+
+// Switches to C locale to make strtod work as expected, for the lifetime of the guard.
+struct c_locale_guard
+{
+    c_locale_guard()
     {
-        auto s = state();
+        // The returned name is overwritten by the next call, keep a copy.
+        auto previous = std::setlocale(LC_NUMERIC, "C");
+        if (previous && strcmp(previous, "C") != 0)
+            m_Previous = previous;
+    }
 
-        if (s(accept('[') && accept_ws() && accept(']')))
-        {
-            result = array();
-            return true;
-        }
+    ~c_locale_guard()
+    {
+        if (!m_Previous.empty())
+            std::setlocale(LC_NUMERIC, m_Previous.c_str());
+    }
 
-        array a;
-        if (s(accept('[') && accept_elements(a) && accept(']')))
-        {
-            result = std::move(a);
-            return true;
-        }
+    string m_Previous;
+};
 
-        return false;
+// Single pass parser. Containers being filled are kept on an explicit stack
+// instead of the call stack, so nesting depth is bounded by memory only. Text
+// of strings without escapes is copied in one go, numbers are read in place.
+struct value::parser
+{
+    parser(const char* begin, const char* end)
+        : m_Cursor(begin)
+        , m_End(end)
+    {
     }
 
-    bool accept_elements(array& a)
+    value parse()
     {
         value v;
-        if (!accept_element(v))
-            return false;
 
-        a.emplace_back(std::move(v));
-        while (true)
-        {
-            auto s = state();
-            v = nullptr;
-            if (!s(accept(',') && accept_element(v)))
-                break;
-            a.emplace_back(std::move(v));
-        }
+        c_locale_guard locale;
 
-        return true;
+        // Accept single value only when end of the stream is reached.
+        if (!accept_document(v))
+            v = value(type_t::discarded);
+
+        return v;
     }
 
-    bool accept_element(value& result)
+private:
+    // Object or array being parsed, with the key of the member being parsed.
+    struct frame
     {
-        auto s = state();
-        return s(accept_ws() && accept_value(result) && accept_ws());
-    }
+        value  container;
+        string key;
+    };
 
-    bool accept_string(value& result)
+    bool accept_document(value& result)
     {
-        auto s = state();
+        std::vector<frame> stack;
+        stack.reserve(16);
 
-        string v;
-        if (s(accept('\"') && accept_characters(v) && accept('\"')))
+        value v;
+
+        skip_ws();
+        while (true)
         {
-            result = std::move(v);
-            return true;
+            // Value: either open a container and continue with its first element or read a primitive.
+            if (accept('{'))
+            {
+                skip_ws();
+                if (!accept('}'))
+                {
+                    stack.push_back(frame{ value(type_t::object), string() });
+                    if (!accept_key(stack.back().key))
+                        return false;
+                    continue;
+                }
+                v = value(type_t::object);
+            }
+            else if (accept('['))
+            {
+                skip_ws();
+                if (!accept(']'))
+                {
+                    stack.push_back(frame{ value(type_t::array), string() });
+                    continue;
+                }
+                v = value(type_t::array);
+            }
+            else if (!accept_primitive(v))
+                return false;
+
+            // Store the value in its container. Containers closed after it are stored in theirs.
+            while (true)
+            {
+                skip_ws();
+
+                if (stack.empty())
+                {
+                    result = std::move(v);
+                    return eof();
+                }
+
+                auto& top = stack.back();
+                if (top.container.is_object())
+                {
+                    // Keys written by dump() are sorted, hinting the end makes each insertion O(1).
+                    auto& o = *object_ptr(top.container.m_Storage);
+                    o.emplace_hint(o.end(), std::move(top.key), std::move(v));
+
+                    if (accept(','))
+                    {
+                        skip_ws();
+                        if (!accept_key(top.key))
+                            return false;
+                        break;
+                    }
+                    else if (!accept('}'))
+                        return false;
+                }
+                else
+                {
+                    array_ptr(top.container.m_Storage)->emplace_back(std::move(v));
+
+                    if (accept(','))
+                    {
+                        skip_ws();
+                        break;
+                    }
+                    else if (!accept(']'))
+                        return false;
+                }
+
+                v = std::move(top.container);
+                stack.pop_back();
+            }
         }
-        else
-            return false;
     }
 
-    bool accept_characters(string& result)
+    bool accept_key(string& key)
     {
-        int c;
-        while (accept_character(c))
-        {
-            CRUDE_ASSERT(c < 128); // #todo: convert characters > 127 to UTF-8
-            result.push_back(static_cast<char>(c));
-        }
+        if (!accept_string(key))
+            return false;
+
+        skip_ws();
+        if (!accept(':'))
+            return false;
 
+        skip_ws();
         return true;
     }
 
-    bool accept_character(int& c)
+    bool accept_primitive(value& result)
     {
-        auto s = state();
-
-        if (accept('\\'))
+        switch (peek())
         {
-            return accept_escape(c);
+            case '\"':
+            {
+                string s;
+                if (!accept_string(s))
+                    return false;
+                result = std::move(s);
+                return true;
+            }
+
+            case 't': return accept_literal("true",  value(true),    result);
+            case 'f': return accept_literal("false", value(false),   result);
+            case 'n': return accept_literal("null",  value(nullptr), result);
+
+            default:
+                return accept_number(result);
         }
-        else if (expect('\"'))
+    }
+
+    bool accept_literal(const char* literal, value&& literal_value, value& result)
+    {
+        auto size = strlen(literal);
+        if (static_cast<size_t>(m_End - m_Cursor) < size || memcmp(m_Cursor, literal, size) != 0)
             return false;
 
-        // #todo: Handle UTF-8 sequences.
-        return s((c = peek()) >= 0) && advance();
+        m_Cursor += size;
+        result = std::move(literal_value);
+        return true;
     }
 
-    bool accept_escape(int& c)
+    bool accept_string(string& result)
     {
-        if (accept('\"')) { c = '\"'; return true; }
-        if (accept('\\')) { c = '\\'; return true; }
-        if (accept('/'))  { c = '/';  return true; }
-        if (accept('b'))  { c = '\b'; return true; }
-        if (accept('f'))  { c = '\f'; return true; }
-        if (accept('n'))  { c = '\n'; return true; }
-        if (accept('r'))  { c = '\r'; return true; }
-        if (accept('t'))  { c = '\t'; return true; }
+        if (!accept('\"'))
+            return false;
 
-        auto s = state();
+        result.clear();
 
-        string hex;
-        hex.reserve(4);
-        if (s(accept('u') && accept_hex(hex) && accept_hex(hex) && accept_hex(hex) && accept_hex(hex)))
+        auto run = m_Cursor;
+        while (true)
         {
-            char* end = nullptr;
-            auto v = std::strtol(hex.c_str(), &end, 16);
-            if (end != hex.c_str() + hex.size())
+            m_Cursor = find_quote_or_escape(m_Cursor, m_End);
+            if (eof())
                 return false;
 
-            c = v;
-            return true;
-        }
+            result.append(run, m_Cursor);
 
-        return false;
-    }
+            if (*m_Cursor++ == '\"')
+                return true;
 
-    bool accept_hex(string& result)
-    {
-        if (accept_digit(result))
-            return true;
+            if (!accept_escape(result))
+                return false;
 
-        auto c = peek();
-        if ((c >= 'A' && c <= 'F') || (c >= 'a' && c <= 'f'))
-        {
-            advance();
-            result.push_back(static_cast<char>(c));
-            return true;
+            run = m_Cursor;
         }
+    }
 
-        return false;
+    bool accept_escape(string& result)
+    {
+        char   utf8[4];
+        size_t size = 0;
+        if (!parse_escape(m_Cursor, m_End, utf8, size))
+            return false;
+
+        result.append(utf8, size);
+        return true;
     }
 
     bool accept_number(value& result)
     {
-        auto s = state();
+        number v;
+        if (!parse_number(m_Cursor, m_End, v))
+            return false;
 
-        string n;
-        if (s(accept_int(n) && accept_frac(n) && accept_exp(n)))
-        {
-            char* end = nullptr;
-            auto v = std::strtod(n.c_str(), &end);
-            if (end != n.c_str() + n.size())
-                return false;
+        result = v;
+        return true;
+    }
 
-            if (!std::isnormal(v))
-                return false;
+    void skip_ws()
+    {
+        while (!eof() && (*m_Cursor == '\x20' || *m_Cursor == '\x0A' || *m_Cursor == '\x0D' || *m_Cursor == '\x09'))
+            ++m_Cursor;
+    }
 
-            result = v;
-            return true;
-        }
+    bool accept(char c)
+    {
+        if (eof() || *m_Cursor != c)
+            return false;
 
-        return false;
+        ++m_Cursor;
+        return true;
     }
 
-    bool accept_int(string& result)
+    int peek() const
     {
-        auto s = state();
+        if (!eof())
+            return *m_Cursor;
+        else
+            return -1;
+    }
 
-        string part;
-        if (s(accept_onenine(part) && accept_digits(part)))
-        {
-            result += std::move(part);
-            return true;
-        }
+    bool eof() const
+    {
+        return m_Cursor == m_End;
+    }
 
-        part.resize(0);
-        if (accept_digit(part))
-        {
-            result += std::move(part);
-            return true;
-        }
+    const char* m_Cursor;
+    const char* m_End;
+};
 
-        part.resize(0);
-        if (s(accept('-') && accept_onenine(part) && accept_digits(part)))
-        {
-            result += '-';
-            result += std::move(part);
-            return true;
-        }
+value value::parse(const string& data)
+{
+    return parse(data.c_str(), data.size());
+}
 
-        part.resize(0);
-        if (s(accept('-') && accept_digit(part)))
-        {
-            result += '-';
-            result += std::move(part);
-            return true;
-        }
+value value::parse(const char* data, size_t size)
+{
+    auto p = parser(data, data + size);
 
-        return false;
+    auto v = p.parse();
+
+    return v;
+}
+
+
+// Index pass, then node pass, see document in the header. The grammar is
+// checked in the node pass, the index pass only has to find where strings end.
+struct document::parser
+{
+    parser(document& owner)
+        : m_Document(owner)
+    {
     }
 
-    bool accept_digits(string& result)
+    bool parse(const char* data, size_t size)
     {
-        string part;
-        if (!accept_digit(part))
+        // Offsets in the index and in the nodes are 32 bit.
+        if (size >= std::numeric_limits<uint32_t>::max())
             return false;
 
-        while (accept_digit(part))
-            ;
+        auto& buffer = m_Document.m_Buffer;
+        buffer.assign(data, size);
+        m_Begin = &buffer[0];
+        m_End   = m_Begin + size;
 
-        result += std::move(part);
+        c_locale_guard locale;
 
-        return true;
+        return build_index() && build_nodes();
     }
 
-    bool accept_digit(string& result)
+private:
+    enum class expect
     {
-        if (accept('0'))
-        {
-            result.push_back('0');
-            return true;
-        }
-        else if (accept_onenine(result))
-            return true;
+        value,
+        value_or_close,
+        key,
+        key_or_close,
+        colon,
+        comma_or_close,
+        done
+    };
 
-        return false;
+    struct frame
+    {
+        uint32_t node;
+        uint32_t size;
+    };
+
+    static bool is_ws(char c)
+    {
+        return c == '\x20' || c == '\x0A' || c == '\x0D' || c == '\x09';
+    }
+
+    static bool is_structural(char c)
+    {
+        return c == '{' || c == '}' || c == '[' || c == ']' || c == ':' || c == ',' || c == '\"';
     }
 
-    bool accept_onenine(string& result)
+    // Returns the byte after the closing quote, nullptr if the string does not end.
+    const char* skip_string(const char* p) const
     {
-        auto c = peek();
-        if (c >= '1' && c <= '9')
+        while (true)
         {
-            result.push_back(static_cast<char>(c));
-            return advance();
+            p = find_quote_or_escape(p, m_End);
+            if (p == m_End)
+                return nullptr;
+
+            if (*p++ == '\"')
+                return p;
+
+            if (p++ == m_End)
+                return nullptr;
         }
+    }
 
-        return false;
+    void add_to_index(const char* p)
+    {
+        m_Document.m_Index.push_back(static_cast<uint32_t>(p - m_Begin));
     }
 
-    bool accept_frac(string& result)
+    // Records structural characters, opening quotes of strings and first
+    // bytes of numbers and literals. Strings are skipped as a whole.
+    bool build_index()
     {
-        auto s = state();
+        m_Document.m_Index.clear();
+
+        // Previous byte belongs to a number or a literal.
+        bool in_scalar = false;
 
-        string part;
-        if (s(accept('.') && accept_digits(part)))
+        const char* p = m_Begin;
+        while (p != m_End)
         {
-            result += '.';
-            result += std::move(part);
+# if CRUDE_JSON_SSE2()
+            if (m_End - p >= 16)
+            {
+                const auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                const auto is = [&chunk](char c) { return _mm_cmpeq_epi8(chunk, _mm_set1_epi8(c)); };
+
+                const auto structural = static_cast<unsigned>(_mm_movemask_epi8(
+                    _mm_or_si128(_mm_or_si128(_mm_or_si128(is('{'), is('}')), _mm_or_si128(is('['), is(']'))),
+                                 _mm_or_si128(_mm_or_si128(is(':'), is(',')), is('\"')))));
+                const auto ws = static_cast<unsigned>(_mm_movemask_epi8(
+                    _mm_or_si128(_mm_or_si128(is('\x20'), is('\x0A')), _mm_or_si128(is('\x0D'), is('\x09')))));
+
+                const auto scalar = ~(structural | ws) & 0xFFFFu;
+                const auto starts = scalar & ~((scalar << 1) | (in_scalar ? 1u : 0u));
+                in_scalar = (scalar & 0x8000u) != 0;
+
+                auto events = structural | starts;
+                auto block  = p;
+                p += 16;
+                while (events)
+                {
+                    auto at = block + first_bit(events);
+                    events &= events - 1;
+
+                    add_to_index(at);
+                    if (*at == '\"')
+                    {
+                        // Classification of the rest of the block is stale, restart after the string.
+                        p = skip_string(at + 1);
+                        if (!p)
+                            return false;
+                        in_scalar = false;
+                        break;
+                    }
+                }
+                continue;
+            }
+# endif
+
+            const auto c = *p;
+            if (c == '\"')
+            {
+                add_to_index(p);
+                p = skip_string(p + 1);
+                if (!p)
+                    return false;
+                in_scalar = false;
+                continue;
+            }
+
+            if (is_structural(c))
+            {
+                add_to_index(p);
+                in_scalar = false;
+            }
+            else if (is_ws(c))
+                in_scalar = false;
+            else
+            {
+                if (!in_scalar)
+                    add_to_index(p);
+                in_scalar = true;
+            }
+            ++p;
         }
 
         return true;
     }
 
-    bool accept_exp(string& result)
+# if CRUDE_JSON_SSE2()
+    static unsigned first_bit(unsigned mask)
     {
-        auto s = state();
+#     if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward(&index, static_cast<unsigned long>(mask));
+        return index;
+#     else
+        return __builtin_ctz(mask);
+#     endif
+    }
+# endif
 
-        string part;
-        if (s(accept('e') && accept_sign(part) && accept_digits(part)))
-        {
-            result += 'e';
-            result += std::move(part);
-            return true;
-        }
-        part.resize(0);
-        if (s(accept('E') && accept_sign(part) && accept_digits(part)))
+    bool build_nodes()
+    {
+        auto& nodes = m_Document.m_Nodes;
+        nodes.clear();
+        m_Stack.clear();
+
+        auto state = expect::value;
+        for (auto offset : m_Document.m_Index)
         {
-            result += 'E';
-            result += std::move(part);
+            char* at = m_Begin + offset;
+            switch (*at)
+            {
+                case '{':
+                case '[':
+                    if (!begin_value(state))
+                        return false;
+                    m_Stack.push_back(frame{ static_cast<uint32_t>(nodes.size()), 0 });
+                    add_node(*at == '{' ? type_t::object : type_t::array);
+                    state = *at == '{' ? expect::key_or_close : expect::value_or_close;
+                    break;
+
+                case '}':
+                case ']':
+                {
+                    if (m_Stack.empty())
+                        return false;
+
+                    auto& container = nodes[m_Stack.back().node];
+                    auto  is_object = container.type == type_t::object;
+                    if (is_object != (*at == '}'))
+                        return false;
+                    if (state != expect::comma_or_close && state != (is_object ? expect::key_or_close : expect::value_or_close))
+                        return false;
+
+                    container.size = m_Stack.back().size;
+                    container.next = static_cast<uint32_t>(nodes.size());
+                    m_Stack.pop_back();
+                    state = end_value();
+                    break;
+                }
+
+                case ',':
+                    if (state != expect::comma_or_close)
+                        return false;
+                    state = nodes[m_Stack.back().node].type == type_t::object ? expect::key : expect::value;
+                    break;
+
+                case ':':
+                    if (state != expect::colon)
+                        return false;
+                    state = expect::value;
+                    break;
+
+                case '\"':
+                    if (state == expect::key || state == expect::key_or_close)
+                    {
+                        ++m_Stack.back().size;
+                        if (!add_string(at + 1))
+                            return false;
+                        state = expect::colon;
+                    }
+                    else
+                    {
+                        if (!begin_value(state) || !add_string(at + 1))
+                            return false;
+                        state = end_value();
+                    }
+                    break;
+
+                default:
+                    if (!begin_value(state) || !add_scalar(at))
+                        return false;
+                    state = end_value();
+                    break;
+            }
         }
 
-        return true;
+        return state == expect::done;
     }
 
-    bool accept_sign(string& result)
+    bool begin_value(expect state)
     {
-        if (accept('+'))
-            result.push_back('+');
-        else if (accept('-'))
-            result.push_back('-');
+        if (state != expect::value && state != expect::value_or_close)
+            return false;
+
+        // Members of an object are counted at their keys.
+        if (!m_Stack.empty() && m_Document.m_Nodes[m_Stack.back().node].type == type_t::array)
+            ++m_Stack.back().size;
 
         return true;
     }
 
-    bool accept_ws()
+    expect end_value() const
     {
-        while (expect('\x09') || expect('\x0A') || expect('\x0D') || expect('\x20'))
-            advance();
-        return true;
+        return m_Stack.empty() ? expect::done : expect::comma_or_close;
     }
 
-    bool accept_boolean(value& result)
+    node& add_node(type_t type)
     {
-        if (accept("true"))
-        {
-            result = true;
-            return true;
-        }
-        else if (accept("false"))
+        auto& nodes = m_Document.m_Nodes;
+        nodes.emplace_back();
+
+        auto& n = nodes.back();
+        n.type         = type;
+        n.next         = static_cast<uint32_t>(nodes.size());
+        n.size         = 0;
+        n.number_value = 0;
+        return n;
+    }
+
+    // Unescapes the string in place, the text never grows.
+    bool add_string(char* begin)
+    {
+        auto read  = begin;
+        auto write = begin;
+        while (true)
         {
-            result = false;
-            return true;
+            auto run_end = read + (find_quote_or_escape(read, m_End) - read);
+            if (run_end == m_End)
+                return false;
+
+            if (write != read)
+                memmove(write, read, run_end - read);
+            write += run_end - read;
+            read   = run_end;
+
+            if (*read++ == '\"')
+                break;
+
+            const char* cursor = read;
+            char        utf8[4];
+            size_t      size = 0;
+            if (!parse_escape(cursor, m_End, utf8, size))
+                return false;
+
+            memcpy(write, utf8, size);
+            write += size;
+            read  += cursor - read;
         }
 
-        return false;
+        auto& n  = add_node(type_t::string);
+        n.offset = static_cast<uint32_t>(begin - m_Begin);
+        n.size   = static_cast<uint32_t>(write - begin);
+        return true;
     }
 
-    bool accept_null(value& result)
+    bool add_scalar(const char* p)
     {
-        if (accept("null"))
+        auto accept_literal = [&p, this](const char* literal)
         {
-            result = nullptr;
+            auto size = strlen(literal);
+            if (static_cast<size_t>(m_End - p) < size || memcmp(p, literal, size) != 0)
+                return false;
+            p += size;
             return true;
-        }
+        };
 
-        return false;
-    }
+        switch (*p)
+        {
+            case 't':
+                if (!accept_literal("true"))
+                    return false;
+                add_node(type_t::boolean).boolean_value = true;
+                break;
 
-    bool accept(char c)
-    {
-        if (expect(c))
-            return advance();
-        else
-            return false;
-    }
+            case 'f':
+                if (!accept_literal("false"))
+                    return false;
+                add_node(type_t::boolean).boolean_value = false;
+                break;
 
-    bool accept(const char* str)
-    {
-        auto last = m_Cursor;
+            case 'n':
+                if (!accept_literal("null"))
+                    return false;
+                add_node(type_t::null);
+                break;
 
-        while (*str)
-        {
-            if (eof() || *str != *m_Cursor)
+            default:
             {
-                m_Cursor = last;
-                return false;
+                number v;
+                if (!parse_number(p, m_End, v))
+                    return false;
+                add_node(type_t::number).number_value = v;
+                break;
             }
-
-            advance();
-            ++str;
         }
 
-        return true;
+        // The index pass starts the next entry where the number or literal ends, anything
+        // left in between is garbage.
+        return p == m_End || is_ws(*p) || is_structural(*p);
     }
 
-    int peek() const
-    {
-        if (!eof())
-            return *m_Cursor;
-        else
-            return -1;
-    }
+    document&          m_Document;
+    char*              m_Begin = nullptr;
+    char*              m_End   = nullptr;
+    std::vector<frame> m_Stack;
+};
 
-    bool expect(char c)
-    {
-        return peek() == c;
-    }
+bool document::parse(const char* data, size_t size)
+{
+    auto p = parser(*this);
+    if (p.parse(data, size))
+        return true;
 
-    bool advance(int count = 1)
-    {
-        if (m_Cursor + count > m_End)
-        {
-            m_Cursor = m_End;
-            return false;
-        }
+    clear();
+    return false;
+}
+
+void document::clear()
+{
+    m_Buffer.clear();
+    m_Index.clear();
+    m_Nodes.clear();
+}
 
-        m_Cursor += count;
+document::view document::root() const
+{
+    if (m_Nodes.empty())
+        return view();
 
-        return true;
-    }
+    return view(this, m_Nodes.data());
+}
 
-    bool eof() const
+document::view document::view::operator[](const char* key) const
+{
+    if (!is_object())
+        return view();
+
+    const auto key_ref = string_ref(key, strlen(key));
+    for (auto it = begin(), e = end(); it != e; ++it)
     {
-        return m_Cursor == m_End;
+        if (it.key().get_string() == key_ref)
+            return it.value();
     }
 
-    const char* m_Cursor;
-    const char* m_End;
-};
+    return view();
+}
 
-value value::parse(const string& data)
+document::view document::view::operator[](size_t index) const
 {
-    auto p = parser(data.c_str(), data.c_str() + data.size());
+    if (!is_array() || index >= size())
+        return view();
 
-    auto v = p.parse();
+    auto it = begin();
+    for (size_t i = 0; i < index; ++i)
+        ++it;
 
-    return v;
+    return *it;
+}
+
+document::iterator document::view::begin() const
+{
+    if (!is_structured())
+        return iterator(m_Document, nullptr, false);
+
+    return iterator(m_Document, m_Node + 1, is_object());
+}
+
+document::iterator document::view::end() const
+{
+    if (!is_structured())
+        return iterator(m_Document, nullptr, false);
+
+    return iterator(m_Document, m_Document->m_Nodes.data() + m_Node->next, is_object());
 }
 
 } // namespace crude_json
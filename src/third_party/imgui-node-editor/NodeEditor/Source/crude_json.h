@@ -16,6 +16,8 @@
 # include <vector>
 # include <map>
 # include <cstddef>
+# include <cstdint>
+# include <cstring>
 # include <algorithm>
 # include <sstream>
 
@@ -49,7 +51,7 @@ enum class type_t
 struct value
 {
     value(type_t type = type_t::null): m_Type(construct(m_Storage, type)) {}
-    value(value&& other);
+    value(value&& other) noexcept;
     value(const value& other);
 
     value(      null)      : m_Type(construct(m_Storage,      null()))  {}
@@ -107,12 +109,16 @@ struct value
 
     string dump(const int indent = -1, const char indent_char = ' ') const;
 
+    // Appends to out, no intermediate strings are built.
+    void dump(string& out, const int indent = -1, const char indent_char = ' ') const;
+
     void swap(value& other);
 
     inline friend void swap(value& lhs, value& rhs) { lhs.swap(rhs); }
 
     // Returns discarded value for invalid inputs.
     static value parse(const string& data);
+    static value parse(const char* data, size_t size);
 
 private:
     struct parser;
@@ -183,13 +189,14 @@ private:
 
     struct dump_context_t
     {
-        std::ostringstream out;
+        string&    out;
         const int  indent = -1;
         const char indent_char = ' ';
 
         // VS2015: Aggregate initialization isn't a thing yet.
-        dump_context_t(const int indent, const char indent_char)
-            : indent(indent)
+        dump_context_t(string& out, const int indent, const char indent_char)
+            : out(out)
+            , indent(indent)
             , indent_char(indent_char)
         {
         }
@@ -197,6 +204,8 @@ private:
         void write_indent(int level);
         void write_separator();
         void write_newline();
+        void write_string(const string& value);
+        void write_number(number value);
     };
 
     void dump(dump_context_t& context, int level) const;
@@ -218,6 +227,147 @@ template <> inline       boolean& value::get<boolean>()       { CRUDE_ASSERT(m_T
 template <> inline       number&  value::get<number>()        { CRUDE_ASSERT(m_Type == type_t::number);  return *number_ptr(m_Storage);  }
 
 
+// Length delimited string inside a document, not null terminated.
+struct string_ref
+{
+    const char* data = nullptr;
+    size_t      size = 0;
+
+    string_ref() = default;
+    string_ref(const char* data, size_t size): data(data), size(size) {}
+
+    string str() const { return string(data, size); }
+
+    bool operator==(const string_ref& other) const { return size == other.size && (!size || memcmp(data, other.data, size) == 0); }
+    bool operator!=(const string_ref& other) const { return !(*this == other); }
+    bool operator==(const char* other)       const { return *this == string_ref(other, strlen(other)); }
+    bool operator!=(const char* other)       const { return !(*this == other); }
+};
+
+// Read-only alternative to value for large inputs.
+//
+// parse() copies the input into one buffer and runs two passes over it. The
+// first records the offset of every structural character and of every
+// string, number or literal into an index, skipping whitespace 16 bytes at a
+// time with SSE2. The second walks the index and lays out all values in one
+// array, in document order. A container knows where its last member ends, so
+// siblings are found without walking their content. Strings are unescaped in
+// place and point into the buffer.
+//
+// Nothing is allocated per value, and a document reused for the next parse
+// keeps its memory. Views stay valid until the next parse() or clear().
+class document
+{
+public:
+    class view;
+    class iterator;
+
+    // Returns false for invalid inputs, the document is left empty then.
+    bool parse(const char* data, size_t size);
+    bool parse(const string& data) { return parse(data.c_str(), data.size()); }
+
+    void clear();
+
+    // Null view when empty.
+    view root() const;
+
+    // Values in the document, keys included.
+    size_t node_count() const { return m_Nodes.size(); }
+
+private:
+    struct node
+    {
+        type_t   type;
+        uint32_t next;   // index of the node after this value and its members
+        uint32_t size;   // members of an object, elements of an array, bytes of a string
+        union
+        {
+            number   number_value;
+            boolean  boolean_value;
+            uint32_t offset; // of the string in the buffer
+        };
+    };
+
+    struct parser;
+
+    string                m_Buffer;
+    std::vector<uint32_t> m_Index;
+    std::vector<node>     m_Nodes;
+};
+
+class document::view
+{
+public:
+    view() = default;
+
+    type_t type() const { return m_Node ? m_Node->type : type_t::null; }
+
+    bool is_primitive()  const { return is_string() || is_number() || is_boolean() || is_null(); }
+    bool is_structured() const { return is_object() || is_array();   }
+    bool is_null()       const { return type() == type_t::null;      }
+    bool is_object()     const { return type() == type_t::object;    }
+    bool is_array()      const { return type() == type_t::array;     }
+    bool is_string()     const { return type() == type_t::string;    }
+    bool is_boolean()    const { return type() == type_t::boolean;   }
+    bool is_number()     const { return type() == type_t::number;    }
+
+    // Members of an object, elements of an array, bytes of a string.
+    size_t size() const { return m_Node ? m_Node->size : 0; }
+
+    string_ref get_string()  const { CRUDE_ASSERT(is_string());  return string_ref(m_Document->m_Buffer.data() + m_Node->offset, m_Node->size); }
+    number     get_number()  const { CRUDE_ASSERT(is_number());  return m_Node->number_value;  }
+    boolean    get_boolean() const { CRUDE_ASSERT(is_boolean()); return m_Node->boolean_value; }
+
+    // Null view when the key or index is missing, or when this is not an
+    // object or array. Both walk the members up to the one found.
+    view operator[](const char* key) const;
+    view operator[](const string& key) const { return (*this)[key.c_str()]; }
+    view operator[](size_t index) const;
+
+    bool contains(const char* key) const { return (*this)[key].m_Node != nullptr; }
+
+    // Members of an object or elements of an array, empty for other values.
+    iterator begin() const;
+    iterator end()   const;
+
+private:
+    friend class document;
+    friend class iterator;
+
+    view(const document* doc, const node* at): m_Document(doc), m_Node(at) {}
+
+    const document* m_Document = nullptr;
+    const node*     m_Node     = nullptr;
+};
+
+// Points to the key of an object member or to an array element.
+class document::iterator
+{
+public:
+    // Valid for object members only.
+    view key() const { CRUDE_ASSERT(m_IsObject); return view(m_Document, m_Node); }
+    view value() const { return view(m_Document, m_IsObject ? m_Node + 1 : m_Node); }
+    view operator*() const { return value(); }
+
+    iterator& operator++()
+    {
+        m_Node = m_Document->m_Nodes.data() + (m_IsObject ? m_Node + 1 : m_Node)->next;
+        return *this;
+    }
+
+    bool operator==(const iterator& other) const { return m_Node == other.m_Node; }
+    bool operator!=(const iterator& other) const { return m_Node != other.m_Node; }
+
+private:
+    friend class view;
+
+    iterator(const document* doc, const node* at, bool is_object): m_Document(doc), m_Node(at), m_IsObject(is_object) {}
+
+    const document* m_Document;
+    const node*     m_Node;
+    bool            m_IsObject;
+};
+
 } // namespace crude_json
 
 # endif // __CRUDE_JSON_H__
\ No newline at end of file
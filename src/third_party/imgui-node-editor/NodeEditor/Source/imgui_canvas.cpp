@@ -2,6 +2,13 @@
 # include "imgui_canvas.h"
 # include <type_traits>
 
+# if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#     define IMGUI_EX_CANVAS_SSE2() 1
+#     include <emmintrin.h>
+# else
+#     define IMGUI_EX_CANVAS_SSE2() 0
+# endif
+
 // https://stackoverflow.com/a/36079786
 # define DECLARE_HAS_MEMBER(__trait_name__, __member_name__)                         \
                                                                                      \
@@ -60,6 +67,124 @@ static inline float& ImFringeScaleRef(ImDrawList* drawList)
 
 static inline ImVec2 ImSelectPositive(const ImVec2& lhs, const ImVec2& rhs) { return ImVec2(lhs.x > 0.0f ? lhs.x : rhs.x, lhs.y > 0.0f ? lhs.y : rhs.y); }
 
+namespace ImCanvasDetails {
+
+static void TransformVerticesScalar(ImDrawVert* vertex, ImDrawVert* vertexEnd, float scale, const ImVec2& offset)
+{
+    while (vertex < vertexEnd)
+    {
+        vertex->pos.x = vertex->pos.x * scale + offset.x;
+        vertex->pos.y = vertex->pos.y * scale + offset.y;
+        ++vertex;
+    }
+}
+
+static void TransformClipRectsScalar(ImDrawCmd* command, ImDrawCmd* commandEnd, float scale, const ImVec2& offset)
+{
+    while (command < commandEnd)
+    {
+        command->ClipRect.x = command->ClipRect.x * scale + offset.x;
+        command->ClipRect.y = command->ClipRect.y * scale + offset.y;
+        command->ClipRect.z = command->ClipRect.z * scale + offset.x;
+        command->ClipRect.w = command->ClipRect.w * scale + offset.y;
+        ++command;
+    }
+}
+
+# if IMGUI_EX_CANVAS_SSE2()
+// Vertices are interleaved, positions of two vertices are gathered in one
+// register with 64-bit loads. Multiply and add are kept separate (no FMA),
+// so results match scalar kernel bit for bit.
+static void TransformVerticesSSE2(ImDrawVert* vertex, ImDrawVert* vertexEnd, float scale, const ImVec2& offset)
+{
+    const auto scale4  = _mm_set1_ps(scale);
+    const auto offset4 = _mm_setr_ps(offset.x, offset.y, offset.x, offset.y);
+
+    for (; vertexEnd - vertex >= 4; vertex += 4)
+    {
+        auto a = _mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(&vertex[0].pos));
+        auto b = _mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(&vertex[2].pos));
+        a = _mm_loadh_pi(a, reinterpret_cast<const __m64*>(&vertex[1].pos));
+        b = _mm_loadh_pi(b, reinterpret_cast<const __m64*>(&vertex[3].pos));
+
+        a = _mm_add_ps(_mm_mul_ps(a, scale4), offset4);
+        b = _mm_add_ps(_mm_mul_ps(b, scale4), offset4);
+
+        _mm_storel_pi(reinterpret_cast<__m64*>(&vertex[0].pos), a);
+        _mm_storeh_pi(reinterpret_cast<__m64*>(&vertex[1].pos), a);
+        _mm_storel_pi(reinterpret_cast<__m64*>(&vertex[2].pos), b);
+        _mm_storeh_pi(reinterpret_cast<__m64*>(&vertex[3].pos), b);
+    }
+
+    TransformVerticesScalar(vertex, vertexEnd, scale, offset);
+}
+
+static void TransformClipRectsSSE2(ImDrawCmd* command, ImDrawCmd* commandEnd, float scale, const ImVec2& offset)
+{
+    const auto scale4  = _mm_set1_ps(scale);
+    const auto offset4 = _mm_setr_ps(offset.x, offset.y, offset.x, offset.y);
+
+    for (; command < commandEnd; ++command)
+    {
+        auto clipRect = _mm_loadu_ps(&command->ClipRect.x);
+        clipRect = _mm_add_ps(_mm_mul_ps(clipRect, scale4), offset4);
+        _mm_storeu_ps(&command->ClipRect.x, clipRect);
+    }
+}
+# endif
+
+static ImGuiEx::CanvasTransformKernel s_TransformKernel = IMGUI_EX_CANVAS_SSE2() ? ImGuiEx::CanvasTransformKernel::SSE2 : ImGuiEx::CanvasTransformKernel::Scalar;
+
+} // namespace ImCanvasDetails
+
+bool ImGuiEx::IsCanvasTransformKernelSupported(CanvasTransformKernel kernel)
+{
+    switch (kernel)
+    {
+        case CanvasTransformKernel::Scalar: return true;
+        case CanvasTransformKernel::SSE2:   return IMGUI_EX_CANVAS_SSE2() != 0;
+    }
+
+    return false;
+}
+
+ImGuiEx::CanvasTransformKernel ImGuiEx::GetCanvasTransformKernel()
+{
+    return ImCanvasDetails::s_TransformKernel;
+}
+
+void ImGuiEx::SetCanvasTransformKernel(CanvasTransformKernel kernel)
+{
+    // Check: Kernel is not compiled in. Use IsCanvasTransformKernelSupported() first.
+    IM_ASSERT(IsCanvasTransformKernelSupported(kernel));
+    if (IsCanvasTransformKernelSupported(kernel))
+        ImCanvasDetails::s_TransformKernel = kernel;
+}
+
+void ImGuiEx::TransformCanvasVertices(ImDrawVert* begin, ImDrawVert* end, float scale, const ImVec2& offset)
+{
+    using namespace ImCanvasDetails;
+
+# if IMGUI_EX_CANVAS_SSE2()
+    if (s_TransformKernel == CanvasTransformKernel::SSE2)
+        return TransformVerticesSSE2(begin, end, scale, offset);
+# endif
+
+    TransformVerticesScalar(begin, end, scale, offset);
+}
+
+void ImGuiEx::TransformCanvasClipRects(ImDrawCmd* begin, ImDrawCmd* end, float scale, const ImVec2& offset)
+{
+    using namespace ImCanvasDetails;
+
+# if IMGUI_EX_CANVAS_SSE2()
+    if (s_TransformKernel == CanvasTransformKernel::SSE2)
+        return TransformClipRectsSSE2(begin, end, scale, offset);
+# endif
+
+    TransformClipRectsScalar(begin, end, scale, offset);
+}
+
 bool ImGuiEx::Canvas::Begin(const char* id, const ImVec2& size)
 {
     return Begin(ImGui::GetID(id), size);
@@ -398,49 +523,14 @@ void ImGuiEx::Canvas::LeaveLocalSpace()
     m_CurrentRange = nullptr;
 # endif
 
-    // Move vertices to screen space.
+    // Move vertices and clip rectangles to screen space.
     auto vertex    = m_DrawList->VtxBuffer.Data + m_DrawListStartVertexIndex;
     auto vertexEnd = m_DrawList->VtxBuffer.Data + m_DrawList->_VtxCurrentIdx;
+    TransformCanvasVertices(vertex, vertexEnd, m_View.Scale, m_ViewTransformPosition);
 
-    // If canvas view is not scaled take a faster path.
-    if (m_View.Scale != 1.0f)
-    {
-        while (vertex < vertexEnd)
-        {
-            vertex->pos.x = vertex->pos.x * m_View.Scale + m_ViewTransformPosition.x;
-            vertex->pos.y = vertex->pos.y * m_View.Scale + m_ViewTransformPosition.y;
-            ++vertex;
-        }
-
-        // Move clip rectangles to screen space.
-        for (int i = m_DrawListCommadBufferSize; i < m_DrawList->CmdBuffer.size(); ++i)
-        {
-            auto& command = m_DrawList->CmdBuffer[i];
-            command.ClipRect.x = command.ClipRect.x * m_View.Scale + m_ViewTransformPosition.x;
-            command.ClipRect.y = command.ClipRect.y * m_View.Scale + m_ViewTransformPosition.y;
-            command.ClipRect.z = command.ClipRect.z * m_View.Scale + m_ViewTransformPosition.x;
-            command.ClipRect.w = command.ClipRect.w * m_View.Scale + m_ViewTransformPosition.y;
-        }
-    }
-    else
-    {
-        while (vertex < vertexEnd)
-        {
-            vertex->pos.x = vertex->pos.x + m_ViewTransformPosition.x;
-            vertex->pos.y = vertex->pos.y + m_ViewTransformPosition.y;
-            ++vertex;
-        }
-
-        // Move clip rectangles to screen space.
-        for (int i = m_DrawListCommadBufferSize; i < m_DrawList->CmdBuffer.size(); ++i)
-        {
-            auto& command = m_DrawList->CmdBuffer[i];
-            command.ClipRect.x = command.ClipRect.x + m_ViewTransformPosition.x;
-            command.ClipRect.y = command.ClipRect.y + m_ViewTransformPosition.y;
-            command.ClipRect.z = command.ClipRect.z + m_ViewTransformPosition.x;
-            command.ClipRect.w = command.ClipRect.w + m_ViewTransformPosition.y;
-        }
-    }
+    auto command    = m_DrawList->CmdBuffer.Data + m_DrawListCommadBufferSize;
+    auto commandEnd = m_DrawList->CmdBuffer.Data + m_DrawList->CmdBuffer.Size;
+    TransformCanvasClipRects(command, commandEnd, m_View.Scale, m_ViewTransformPosition);
 
     auto& fringeScale = ImFringeScaleRef(m_DrawList);
     fringeScale = m_LastFringeScale;
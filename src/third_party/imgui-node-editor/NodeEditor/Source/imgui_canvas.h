@@ -71,6 +71,29 @@ struct CanvasView
     }
 };
 
+// Kernels moving canvas content to screen space when leaving the canvas:
+//   p' = p * scale + offset
+//
+// Default kernel is picked at compile time: SSE2 when the compiler targets it
+// (__SSE2__, x64 or /arch:SSE2), scalar otherwise. There is no runtime CPU
+// detection. Both produce same results. SetCanvasTransformKernel() switches
+// between the compiled in kernels to compare them.
+enum class CanvasTransformKernel
+{
+    Scalar,
+    SSE2
+};
+
+bool IsCanvasTransformKernelSupported(CanvasTransformKernel kernel);
+CanvasTransformKernel GetCanvasTransformKernel();
+void SetCanvasTransformKernel(CanvasTransformKernel kernel);
+
+// Transforms vertex positions in range [begin, end).
+void TransformCanvasVertices(ImDrawVert* begin, ImDrawVert* end, float scale, const ImVec2& offset);
+
+// Transforms clip rectangles of draw commands in range [begin, end).
+void TransformCanvasClipRects(ImDrawCmd* begin, ImDrawCmd* end, float scale, const ImVec2& offset);
+
 // Canvas widget represent view over infinite plane.
 //
 // It acts like a child window without scroll bars with
@@ -1002,6 +1002,100 @@ ImRect ed::Link::GetBounds() const
 
 
 
+//------------------------------------------------------------------------------
+//
+// Spatial Index
+//
+//------------------------------------------------------------------------------
+ed::SpatialIndex::SpatialIndex(float cellSize, int64_t maxObjectCells)
+    : m_InvCellSize(1.0f / cellSize)
+    , m_MaxObjectCells(maxObjectCells)
+{
+}
+
+ed::SpatialCells ed::SpatialIndex::GetCells(const ImRect& bounds) const
+{
+    // Keeps far away objects from overflowing the cell coordinates
+    const float limit = static_cast<float>(1 << 24);
+    auto toCell = [this, limit](float v)
+    {
+        return static_cast<int>(ImClamp(ImFloor(v * m_InvCellSize), -limit, limit));
+    };
+
+    SpatialCells cells;
+    cells.m_MinX = toCell(bounds.Min.x);
+    cells.m_MinY = toCell(bounds.Min.y);
+    cells.m_MaxX = toCell(bounds.Max.x);
+    cells.m_MaxY = toCell(bounds.Max.y);
+    return cells;
+}
+
+void ed::SpatialIndex::Update(Object* object, const ImRect& bounds)
+{
+    SpatialCells cells;
+    if (!ImRect_IsEmpty(bounds))
+    {
+        cells = GetCells(bounds);
+        cells.m_IsOversized = cells.Count() > m_MaxObjectCells;
+    }
+
+    if (cells == object->m_IndexedCells)
+        return;
+
+    Remove(object);
+
+    if (cells.IsEmpty())
+        return;
+
+    object->m_IndexedCells = cells;
+    if (cells.m_IsOversized)
+    {
+        m_Oversized.push_back(object);
+        return;
+    }
+
+    for (int y = cells.m_MinY; y <= cells.m_MaxY; ++y)
+        for (int x = cells.m_MinX; x <= cells.m_MaxX; ++x)
+            m_Cells[CellKey(x, y)].push_back(object);
+}
+
+void ed::SpatialIndex::Remove(Object* object)
+{
+    auto removeFrom = [object](vector<Object*>& objects)
+    {
+        auto objectIt = std::find(objects.begin(), objects.end(), object);
+        if (objectIt == objects.end())
+            return;
+        *objectIt = objects.back();
+        objects.pop_back();
+    };
+
+    auto& cells = object->m_IndexedCells;
+    if (cells.IsEmpty())
+        return;
+
+    if (cells.m_IsOversized)
+        removeFrom(m_Oversized);
+    else
+    {
+        for (int y = cells.m_MinY; y <= cells.m_MaxY; ++y)
+            for (int x = cells.m_MinX; x <= cells.m_MaxX; ++x)
+            {
+                auto cellIt = m_Cells.find(CellKey(x, y));
+                if (cellIt == m_Cells.end())
+                    continue;
+                removeFrom(cellIt->second);
+                if (cellIt->second.empty())
+                    m_Cells.erase(cellIt);
+            }
+    }
+
+    cells = SpatialCells();
+}
+
+
+
+
 //------------------------------------------------------------------------------
 //
 // Editor Context
@@ -1015,8 +1109,11 @@ ed::EditorContext::EditorContext(const ax::NodeEditor::Config* config)
     , m_Nodes()
     , m_Pins()
     , m_Links()
+    , m_AreLinksSorted(true)
+    , m_SpatialIndex()
     , m_SelectionId(1)
     , m_LastActiveLink(nullptr)
+    , m_LastActiveNode(nullptr)
     , m_Canvas()
     , m_IsCanvasVisible(false)
     , m_NodeBuilder(this)
@@ -1041,6 +1138,7 @@ ed::EditorContext::EditorContext(const ax::NodeEditor::Config* config)
     , m_Settings()
     , m_Config(config)
     , m_ExternalChannel(0)
+    , m_SharedNodeChannel(-1)
 {
 }
 
@@ -1119,6 +1217,15 @@ void ed::EditorContext::Begin(const char* id, const ImVec2& size)
     // Reserve channels for background and links
     ImDrawList_ChannelsGrow(drawList, c_NodeStartChannel);
 
+    // Reserve one set of layers for all regular nodes, groups still get their own
+    if (m_Config.SharedNodeChannels)
+    {
+        m_SharedNodeChannel = c_NodeStartChannel;
+        ImDrawList_ChannelsGrow(drawList, c_NodeStartChannel + c_ChannelsPerNode);
+    }
+    else
+        m_SharedNodeChannel = -1;
+
     if (HasSelectionChanged())
         ++m_SelectionId;
 
@@ -1127,6 +1234,14 @@ void ed::EditorContext::Begin(const char* id, const ImVec2& size)
 
 void ed::EditorContext::End()
 {
+    if (!m_AreLinksSorted)
+    {
+        std::sort(m_Links.begin(), m_Links.end());
+        m_AreLinksSorted = true;
+    }
+
+    UpdateSpatialIndex();
+
     //auto& io          = ImGui::GetIO();
     auto  control     = BuildControl(m_CurrentAction && m_CurrentAction->IsDragging()); // NavigateAction.IsMovingOverEdge()
     auto  drawList    = ImGui::GetWindowDrawList();
@@ -1286,18 +1401,22 @@ void ed::EditorContext::End()
     // to hold twice as much of channels and place them in
     // node drawing order.
     {
+        // Shared layers are moved along with the nodes using them, so this follows m_SharedNodeChannel
+        auto hasOwnChannels = [this](Node* node) { return node->m_IsLive && node->m_Channel != m_SharedNodeChannel; };
+
         // Copy group nodes
-        auto liveNodeCount = static_cast<int>(std::count_if(m_Nodes.begin(), m_Nodes.end(), [](Node* node) { return node->m_IsLive; }));
+        auto liveNodeCount = static_cast<int>(std::count_if(m_Nodes.begin(), m_Nodes.end(), hasOwnChannels));
+        auto sharedChannelCount = m_SharedNodeChannel >= 0 ? c_ChannelsPerNode : 0;
 
         // Reserve two additional channels for sorted list of channels
         auto nodeChannelCount = drawList->_Splitter._Count;
-        ImDrawList_ChannelsGrow(drawList, drawList->_Splitter._Count + c_ChannelsPerNode * liveNodeCount + c_LinkChannelCount);
+        ImDrawList_ChannelsGrow(drawList, drawList->_Splitter._Count + c_ChannelsPerNode * liveNodeCount + c_LinkChannelCount + sharedChannelCount);
 
         int targetChannel = nodeChannelCount;
 
-        auto copyNode = [&targetChannel, drawList](Node* node)
+        auto copyNode = [&targetChannel, drawList, &hasOwnChannels](Node* node)
         {
-            if (!node->m_IsLive)
+            if (!hasOwnChannels(node))
                 return;
 
             for (int i = 0; i < c_ChannelsPerNode; ++i)
@@ -1316,6 +1435,21 @@ void ed::EditorContext::End()
         for (int i = 0; i < c_LinkChannelCount; ++i, ++targetChannel)
             ImDrawList_SwapChannels(drawList, c_LinkStartChannel + i, targetChannel);
 
+        // Copy shared layers, every regular node drawn in them is ordered within each layer
+        // by submission, so a layer is a single batch instead of one channel per node
+        if (m_SharedNodeChannel >= 0)
+        {
+            for (int i = 0; i < c_ChannelsPerNode; ++i)
+                ImDrawList_SwapChannels(drawList, m_SharedNodeChannel + i, targetChannel + i);
+
+            for (auto node : m_Nodes)
+                if (node->m_IsLive && node->m_Channel == m_SharedNodeChannel)
+                    node->m_Channel = targetChannel;
+
+            m_SharedNodeChannel = targetChannel;
+            targetChannel += c_ChannelsPerNode;
+        }
+
         // Copy normal nodes
         std::for_each(groupsItEnd, m_Nodes.end(), copyNode);
     }
@@ -1604,11 +1738,27 @@ bool ed::EditorContext::HasSelectionChanged()
 
 ed::Node* ed::EditorContext::FindNodeAt(const ImVec2& p)
 {
-    for (auto node : m_Nodes)
-        if (node->TestHit(p))
-            return node;
+    Node* result    = nullptr;
+    bool  isOverlap = false;
+    m_SpatialIndex.Query(ImRect(p, p), [&result, &isOverlap, &p](Object* object)
+    {
+        auto node = object->AsNode();
+        if (node && node->TestHit(p))
+        {
+            isOverlap = result != nullptr;
+            result    = node;
+        }
+    });
 
-    return nullptr;
+    // Overlapping nodes are resolved in drawing order, as the first one hit
+    if (isOverlap)
+    {
+        for (auto node : m_Nodes)
+            if (node->TestHit(p))
+                return node;
+    }
+
+    return result;
 }
 
 void ed::EditorContext::FindNodesInRect(const ImRect& r, vector<Node*>& result, bool append, bool includeIntersecting)
@@ -1619,9 +1769,12 @@ void ed::EditorContext::FindNodesInRect(const ImRect& r, vector<Node*>& result,
     if (ImRect_IsEmpty(r))
         return;
 
-    for (auto node : m_Nodes)
-        if (node->TestHit(r, includeIntersecting))
+    m_SpatialIndex.Query(r, [&result, &r, includeIntersecting](Object* object)
+    {
+        auto node = object->AsNode();
+        if (node && node->TestHit(r, includeIntersecting))
             result.push_back(node);
+    });
 }
 
 void ed::EditorContext::FindLinksInRect(const ImRect& r, vector<Link*>& result, bool append)
@@ -1632,9 +1785,45 @@ void ed::EditorContext::FindLinksInRect(const ImRect& r, vector<Link*>& result,
     if (ImRect_IsEmpty(r))
         return;
 
-    for (auto link : m_Links)
-        if (link->TestHit(r))
+    m_SpatialIndex.Query(r, [&result, &r](Object* object)
+    {
+        auto link = object->AsLink();
+        if (link && link->TestHit(r))
             result.push_back(link);
+    });
+}
+
+void ed::EditorContext::UpdateSpatialIndex()
+{
+    for (auto node : m_Nodes)
+    {
+        if (node->m_IsLive)
+            m_SpatialIndex.Update(node, node->GetBounds());
+        else
+            m_SpatialIndex.Remove(node);
+    }
+
+    for (auto link : m_Links)
+    {
+        if (!link->m_IsLive)
+        {
+            m_SpatialIndex.Remove(link);
+            continue;
+        }
+
+        // Bezier bounds are costly, recompute them only when the curve changed
+        const auto curve = link->GetCurve();
+        if (!link->m_IndexedCells.IsEmpty()
+            && curve.P0 == link->m_IndexedCurve.P0 && curve.P1 == link->m_IndexedCurve.P1
+            && curve.P2 == link->m_IndexedCurve.P2 && curve.P3 == link->m_IndexedCurve.P3)
+            continue;
+
+        // Indexed with the margin FindLinkAt uses for hovering
+        auto bounds = link->GetBounds();
+        bounds.Expand(c_LinkSelectThickness);
+        m_SpatialIndex.Update(link, bounds);
+        link->m_IndexedCurve = curve;
+    }
 }
 
 void ed::EditorContext::FindLinksForNode(NodeId nodeId, vector<Link*>& result, bool add)
@@ -1704,7 +1893,7 @@ ed::Pin* ed::EditorContext::CreatePin(PinId id, PinKind kind)
     IM_ASSERT(nullptr == FindObject(id));
     auto pin = new Pin(this, id, kind);
     m_Pins.push_back({id, pin});
-    std::sort(m_Pins.begin(), m_Pins.end());
+    m_PinIndex[id.AsPointer()] = pin;
     return pin;
 }
 
@@ -1713,7 +1902,7 @@ ed::Node* ed::EditorContext::CreateNode(NodeId id)
     IM_ASSERT(nullptr == FindObject(id));
     auto node = new Node(this, id);
     m_Nodes.push_back({id, node});
-    //std::sort(Nodes.begin(), Nodes.end());
+    m_NodeIndex[id.AsPointer()] = node;
 
     auto settings = m_Settings.FindNode(id);
     if (!settings)
@@ -1747,66 +1936,38 @@ ed::Link* ed::EditorContext::CreateLink(LinkId id)
     IM_ASSERT(nullptr == FindObject(id));
     auto link = new Link(this, id);
     m_Links.push_back({id, link});
-    std::sort(m_Links.begin(), m_Links.end());
-
-    return link;
-}
+    m_LinkIndex[id.AsPointer()] = link;
 
-template <typename C, typename Id>
-static inline auto FindItemInLinear(C& container, Id id)
-{
-# if defined(_DEBUG)
-    auto start = container.data();
-    auto end   = container.data() + container.size();
-    for (auto it = start; it < end; ++it)
-        if ((*it).m_ID == id)
-            return it->m_Object;
-# else
-    for (auto item : container)
-        if (item.m_ID == id)
-            return item.m_Object;
-# endif
+    // Sorted in End(), links created in increasing id order keep the vector sorted
+    if (m_Links.size() > 1 && m_Links.back() < m_Links[m_Links.size() - 2])
+        m_AreLinksSorted = false;
 
-   return static_cast<decltype(container[0].m_Object)>(nullptr);
+    return link;
 }
 
 template <typename C, typename Id>
-static inline auto FindItemIn(C& container, Id id)
-{
-//# if defined(_DEBUG)
-//    auto start = container.data();
-//    auto end   = container.data() + container.size();
-//    for (auto it = start; it < end; ++it)
-//        if ((*it)->ID == id)
-//            return *it;
-//# else
-//    for (auto item : container)
-//        if (item->ID == id)
-//            return item;
-//# endif
-    auto key = typename C::value_type{ id, nullptr };
-    auto first = container.cbegin();
-    auto last  = container.cend();
-    auto it    = std::lower_bound(first, last, key);
-    if (it != last && (key.m_ID == it->m_ID))
-        return it->m_Object;
+static inline auto FindItemIn(const C& index, Id id)
+{
+    auto it = index.find(id.AsPointer());
+    if (it != index.end())
+        return it->second;
     else
-        return static_cast<decltype(it->m_Object)>(nullptr);
+        return static_cast<typename C::mapped_type>(nullptr);
 }
 
 ed::Node* ed::EditorContext::FindNode(NodeId id)
 {
-    return FindItemInLinear(m_Nodes, id);
+    return FindItemIn(m_NodeIndex, id);
 }
 
 ed::Pin* ed::EditorContext::FindPin(PinId id)
 {
-    return FindItemIn(m_Pins, id);
+    return FindItemIn(m_PinIndex, id);
 }
 
 ed::Link* ed::EditorContext::FindLink(LinkId id)
 {
-    return FindItemIn(m_Links, id);
+    return FindItemIn(m_LinkIndex, id);
 }
 
 ed::Object* ed::EditorContext::FindObject(ObjectId id)
@@ -1852,6 +2013,13 @@ void ed::EditorContext::LoadSettings()
 {
     ed::Settings::Parse(m_Config.Load(), m_Settings);
 
+    if (m_Config.SettingsJournal && m_Config.SettingsFile && !m_Config.SaveSettings)
+    {
+        m_SettingsJournal.Open(m_Config.SettingsFile, m_Config.SettingsJournalCompactLimit);
+        for (auto& record : m_SettingsJournal.Load())
+            ed::Settings::Parse(record, m_Settings);
+    }
+
     m_NavigateAction.m_Scroll = m_Settings.m_ViewScroll;
     m_NavigateAction.m_Zoom   = m_Settings.m_ViewZoom;
 }
@@ -1860,6 +2028,9 @@ void ed::EditorContext::SaveSettings()
 {
     m_Config.BeginSave();
 
+    // Nodes changed since the last save, collected before SaveNode() clears their flags.
+    vector<NodeSettings*> changedNodes;
+
     for (auto& node : m_Nodes)
     {
         auto settings = m_Settings.FindNode(node->m_ID);
@@ -1868,6 +2039,9 @@ void ed::EditorContext::SaveSettings()
         if (IsGroup(node))
             settings->m_GroupSize = node->m_GroupBounds.GetSize();
 
+        if (!node->m_RestoreState && settings->m_IsDirty && m_SettingsJournal.IsOpen())
+            changedNodes.push_back(settings);
+
         if (!node->m_RestoreState && settings->m_IsDirty && m_Config.SaveNodeSettings)
         {
             if (m_Config.SaveNode(node->m_ID, settings->Serialize().dump(), settings->m_DirtyReason))
@@ -1882,7 +2056,23 @@ void ed::EditorContext::SaveSettings()
     m_Settings.m_ViewScroll = m_NavigateAction.m_Scroll;
     m_Settings.m_ViewZoom   = m_NavigateAction.m_Zoom;
 
-    if (m_Config.Save(m_Settings.Serialize(), m_Settings.m_DirtyReason))
+    if (m_SettingsJournal.IsOpen())
+    {
+        auto changes = m_Settings.SerializeChanges(changedNodes);
+        if (changes == "{}" || m_SettingsJournal.Append(changes))
+        {
+            m_Settings.ClearDirty();
+            m_SettingsJournal.CompactIfNeeded(m_Settings);
+        }
+    }
+    else if (!m_Config.SaveSettings && !m_Config.SettingsFile)
+    {
+        // Nowhere to write the whole settings to, do not serialize them again on every frame.
+        // Nodes keep their flags, so the ones SaveNode() failed for are retried.
+        m_Settings.m_IsDirty     = false;
+        m_Settings.m_DirtyReason = SaveReasonFlags::None;
+    }
+    else if (m_Config.Save(m_Settings.Serialize(), m_Settings.m_DirtyReason))
         m_Settings.ClearDirty();
 
     m_Config.EndSave();
@@ -1900,11 +2090,18 @@ void ed::EditorContext::MakeDirty(SaveReasonFlags reason, Node* node)
 
 ed::Link* ed::EditorContext::FindLinkAt(const ImVec2& p)
 {
-    for (auto& link : m_Links)
+    // Among overlapping links the one with the lowest id wins, as in the order of m_Links
+    Link* result = nullptr;
+    m_SpatialIndex.Query(ImRect(p, p), [&result, &p](Object* object)
+    {
+        auto link = object->AsLink();
+        if (!link || (result && result->m_ID.AsPointer() < link->m_ID.AsPointer()))
+            return;
         if (link->TestHit(p, c_LinkSelectThickness))
-            return link;
+            result = link;
+    });
 
-    return nullptr;
+    return result;
 }
 
 ImU32 ed::EditorContext::GetColor(StyleColor colorIndex) const
@@ -2045,6 +2242,11 @@ ed::Control ed::EditorContext::BuildControl(bool allowOffscreen)
 
         if (!node->m_IsLive) continue;
 
+        // Only a node under the mouse can be hovered or clicked, the active one is kept alive
+        // while dragged. Group regions may stick out of tiny groups, those are always processed.
+        if (node->m_Type != NodeType::Group && node != m_LastActiveNode && !node->m_Bounds.Contains(mousePos))
+            continue;
+
         // Check for interactions with live pins in node before
         // processing node itself. Pins does not overlap each other
         // and all are within node bounds.
@@ -2088,6 +2290,11 @@ ed::Control ed::EditorContext::BuildControl(bool allowOffscreen)
             checkInteractionsInArea(node->m_ID, node->m_Bounds, node);
     }
 
+    if (auto activePin = activeObject ? activeObject->AsPin() : nullptr)
+        m_LastActiveNode = activePin->m_Node;
+    else
+        m_LastActiveNode = activeObject ? activeObject->AsNode() : nullptr;
+
     // Links are not regular widgets and must be done manually since
     // ImGui does not support interactive elements with custom hit maps.
     //
@@ -2196,6 +2403,8 @@ void ed::EditorContext::ShowMetrics(const Control& control)
     ImGui::Text("Live Nodes: %d", liveNodeCount);
     ImGui::Text("Live Pins: %d", livePinCount);
     ImGui::Text("Live Links: %d", liveLinkCount);
+    ImGui::Text("Spatial Index: %d cells, %d oversized", (int)m_SpatialIndex.GetCellCount(), (int)m_SpatialIndex.GetOversizedCount());
+    ImGui::Text("Shared Node Layers: %s", m_SharedNodeChannel >= 0 ? "true" : "false");
     ImGui::Text("Hot Object: %s (%p)", getHotObjectName(), control.HotObject ? control.HotObject->ID().AsPointer() : nullptr);
     if (auto node = control.HotObject ? control.HotObject->AsNode() : nullptr)
     {
@@ -2255,43 +2464,41 @@ ed::json::value ed::NodeSettings::Serialize()
     return result;
 }
 
-bool ed::NodeSettings::Parse(const std::string& string, NodeSettings& settings)
+// Reads {"x": number, "y": number}.
+static bool ParseVector(const ed::json::document::view& v, ImVec2& result)
 {
-    auto settingsValue = json::value::parse(string);
-    if (settingsValue.is_discarded())
-        return false;
+    auto xValue = v["x"];
+    auto yValue = v["y"];
 
-    return Parse(settingsValue, settings);
+    if (xValue.is_number() && yValue.is_number())
+    {
+        result.x = static_cast<float>(xValue.get_number());
+        result.y = static_cast<float>(yValue.get_number());
+
+        return true;
+    }
+
+    return false;
 }
 
-bool ed::NodeSettings::Parse(const json::value& data, NodeSettings& result)
+bool ed::NodeSettings::Parse(const std::string& string, NodeSettings& settings)
 {
-    if (!data.is_object())
+    json::document document;
+    if (!document.parse(string))
         return false;
 
-    auto tryParseVector = [](const json::value& v, ImVec2& result) -> bool
-    {
-        if (v.is_object())
-        {
-            auto xValue = v["x"];
-            auto yValue = v["y"];
-
-            if (xValue.is_number() && yValue.is_number())
-            {
-                result.x = static_cast<float>(xValue.get<double>());
-                result.y = static_cast<float>(yValue.get<double>());
-
-                return true;
-            }
-        }
+    return Parse(document.root(), settings);
+}
 
+bool ed::NodeSettings::Parse(const json::document::view& data, NodeSettings& result)
+{
+    if (!data.is_object())
         return false;
-    };
 
-    if (!tryParseVector(data["location"], result.m_Location))
+    if (!ParseVector(data["location"], result.m_Location))
         return false;
 
-    if (data.contains("group_size") && !tryParseVector(data["group_size"], result.m_GroupSize))
+    if (data.contains("group_size") && !ParseVector(data["group_size"], result.m_GroupSize))
         return false;
 
     return true;
@@ -2307,15 +2514,16 @@ bool ed::NodeSettings::Parse(const json::value& data, NodeSettings& result)
 //------------------------------------------------------------------------------
 ed::NodeSettings* ed::Settings::AddNode(NodeId id)
 {
+    m_NodeIndex[id.AsPointer()] = m_Nodes.size();
     m_Nodes.push_back(NodeSettings(id));
     return &m_Nodes.back();
 }
 
 ed::NodeSettings* ed::Settings::FindNode(NodeId id)
 {
-    for (auto& settings : m_Nodes)
-        if (settings.m_ID == id)
-            return &settings;
+    auto it = m_NodeIndex.find(id.AsPointer());
+    if (it != m_NodeIndex.end())
+        return &m_Nodes[it->second];
 
     return nullptr;
 }
@@ -2352,38 +2560,69 @@ void ed::Settings::MakeDirty(SaveReasonFlags reason, Node* node)
     }
 }
 
-std::string ed::Settings::Serialize()
+static std::string SerializeObjectId(ed::ObjectId id)
 {
-    json::value result;
-
-    auto serializeObjectId = [](ObjectId id)
-    {
-        auto value = std::to_string(reinterpret_cast<uintptr_t>(id.AsPointer()));
-        switch (id.Type())
-        {
-            default:
-            case NodeEditor::Detail::ObjectType::None: return value;
-            case NodeEditor::Detail::ObjectType::Node: return "node:" + value;
-            case NodeEditor::Detail::ObjectType::Link: return "link:" + value;
-            case NodeEditor::Detail::ObjectType::Pin:  return "pin:"  + value;
-        }
-    };
-
-    auto& nodes = result["nodes"];
-    for (auto& node : m_Nodes)
+    auto value = std::to_string(reinterpret_cast<uintptr_t>(id.AsPointer()));
+    switch (id.Type())
     {
-        if (node.m_WasUsed)
-            nodes[serializeObjectId(node.m_ID)] = node.Serialize();
+        default:
+        case ed::ObjectType::None: return value;
+        case ed::ObjectType::Node: return "node:" + value;
+        case ed::ObjectType::Link: return "link:" + value;
+        case ed::ObjectType::Pin:  return "pin:"  + value;
     }
+}
 
+void ed::Settings::SerializeSelection(json::value& result)
+{
     auto& selection = result["selection"];
+    // Written as an array even when empty, so replaying a journal record clears the selection.
+    selection = json::value(json::type_t::array);
     for (auto& id : m_Selection)
-        selection.push_back(serializeObjectId(id));
+        selection.push_back(SerializeObjectId(id));
+}
 
+void ed::Settings::SerializeView(json::value& result)
+{
     auto& view = result["view"];
     view["scroll"]["x"] = m_ViewScroll.x;
     view["scroll"]["y"] = m_ViewScroll.y;
     view["zoom"]   = m_ViewZoom;
+}
+
+std::string ed::Settings::Serialize()
+{
+    json::value result;
+
+    auto& nodes = result["nodes"];
+    for (auto& node : m_Nodes)
+    {
+        if (node.m_WasUsed)
+            nodes[SerializeObjectId(node.m_ID)] = node.Serialize();
+    }
+
+    SerializeSelection(result);
+    SerializeView(result);
+
+    return result.dump();
+}
+
+std::string ed::Settings::SerializeChanges(const vector<NodeSettings*>& nodes)
+{
+    json::value result(json::type_t::object);
+
+    if (!nodes.empty())
+    {
+        auto& nodesValue = result["nodes"];
+        for (auto node : nodes)
+            nodesValue[SerializeObjectId(node->m_ID)] = node->Serialize();
+    }
+
+    if ((m_DirtyReason & SaveReasonFlags::Selection) != SaveReasonFlags::None)
+        SerializeSelection(result);
+
+    if ((m_DirtyReason & SaveReasonFlags::Navigation) != SaveReasonFlags::None)
+        SerializeView(result);
 
     return result.dump();
 }
@@ -2392,89 +2631,77 @@ bool ed::Settings::Parse(const std::string& string, Settings& settings)
 {
     Settings result = settings;
 
-    auto settingsValue = json::value::parse(string);
-    if (settingsValue.is_discarded())
+    // Parsed into one arena with strings pointing into the text, settings of
+    // large graphs hold one object per node.
+    json::document document;
+    if (!document.parse(string))
         return false;
 
+    auto settingsValue = document.root();
     if (!settingsValue.is_object())
         return false;
 
-    auto tryParseVector = [](const json::value& v, ImVec2& result) -> bool
+    // Strings of a document are not null terminated, the id is read up to its size.
+    auto deserializeObjectId = [](const json::string_ref& str)
     {
-        if (v.is_object() && v.contains("x") && v.contains("y"))
-        {
-            auto xValue = v["x"];
-            auto yValue = v["y"];
-
-            if (xValue.is_number() && yValue.is_number())
-            {
-                result.x = static_cast<float>(xValue.get<double>());
-                result.y = static_cast<float>(yValue.get<double>());
-
-                return true;
-            }
-        }
+        auto end       = str.data + str.size;
+        auto separator = static_cast<const char*>(memchr(str.data, ':', str.size));
+        auto idStart   = separator ? separator + 1 : str.data;
 
-        return false;
-    };
+        uintptr_t value = 0;
+        for (auto c = idStart; c != end && *c >= '0' && *c <= '9'; ++c)
+            value = value * 10 + static_cast<uintptr_t>(*c - '0');
+        auto id = reinterpret_cast<void*>(value);
 
-    auto deserializeObjectId = [](const std::string& str)
-    {
-        auto separator = str.find_first_of(':');
-        auto idStart   = str.c_str() + ((separator != std::string::npos) ? separator + 1 : 0);
-        auto id        = reinterpret_cast<void*>(strtoull(idStart, nullptr, 16));
-        if (str.compare(0, separator, "node") == 0)
+        auto type = json::string_ref(str.data, separator ? separator - str.data : str.size);
+        if (type == "node")
             return ObjectId(NodeId(id));
-        else if (str.compare(0, separator, "link") == 0)
+        else if (type == "link")
             return ObjectId(LinkId(id));
-        else if (str.compare(0, separator, "pin") == 0)
+        else if (type == "pin")
             return ObjectId(PinId(id));
         else
             // fallback to old format
             return ObjectId(NodeId(id)); //return ObjectId();
     };
 
-    //auto& settingsObject = settingsValue.get<json::object>();
-
-    auto& nodesValue = settingsValue["nodes"];
+    auto nodesValue = settingsValue["nodes"];
     if (nodesValue.is_object())
     {
-        for (auto& node : nodesValue.get<json::object>())
+        for (auto node = nodesValue.begin(); node != nodesValue.end(); ++node)
         {
-            auto id = deserializeObjectId(node.first.c_str()).AsNodeId();
+            auto id = deserializeObjectId(node.key().get_string()).AsNodeId();
 
             auto nodeSettings = result.FindNode(id);
             if (!nodeSettings)
                 nodeSettings = result.AddNode(id);
 
-            NodeSettings::Parse(node.second, *nodeSettings);
+            NodeSettings::Parse(node.value(), *nodeSettings);
         }
     }
 
-    auto& selectionValue = settingsValue["selection"];
+    auto selectionValue = settingsValue["selection"];
     if (selectionValue.is_array())
     {
-        const auto selectionArray = selectionValue.get<json::array>();
-
-        result.m_Selection.reserve(selectionArray.size());
+        result.m_Selection.reserve(selectionValue.size());
         result.m_Selection.resize(0);
-        for (auto& selection : selectionArray)
+        for (auto selection : selectionValue)
         {
             if (selection.is_string())
-                result.m_Selection.push_back(deserializeObjectId(selection.get<json::string>()));
+                result.m_Selection.push_back(deserializeObjectId(selection.get_string()));
         }
     }
 
-    auto& viewValue = settingsValue["view"];
+    auto viewValue = settingsValue["view"];
     if (viewValue.is_object())
     {
-        auto& viewScrollValue = viewValue["scroll"];
-        auto& viewZoomValue   = viewValue["zoom"];
+        auto viewScrollValue = viewValue["scroll"];
+        auto viewZoomValue   = viewValue["zoom"];
 
-        if (!tryParseVector(viewScrollValue, result.m_ViewScroll))
+        if (!ParseVector(viewScrollValue, result.m_ViewScroll))
             result.m_ViewScroll = ImVec2(0, 0);
 
-        result.m_ViewZoom = viewZoomValue.is_number() ? static_cast<float>(viewZoomValue.get<double>()) : 1.0f;
+        result.m_ViewZoom = viewZoomValue.is_number() ? static_cast<float>(viewZoomValue.get_number()) : 1.0f;
     }
 
     settings = std::move(result);
@@ -2484,6 +2711,130 @@ bool ed::Settings::Parse(const std::string& string, Settings& settings)
 
 
 
+//------------------------------------------------------------------------------
+//
+// Settings Journal
+//
+//------------------------------------------------------------------------------
+ed::SettingsJournal::SettingsJournal()
+    : m_RecordCount(0)
+    , m_CompactLimit(0)
+    , m_IsCompacting(false)
+{
+}
+
+ed::SettingsJournal::~SettingsJournal()
+{
+    WaitForCompaction();
+}
+
+void ed::SettingsJournal::Open(const char* settingsFile, int compactLimit)
+{
+    WaitForCompaction();
+
+    m_SettingsPath   = settingsFile;
+    m_JournalPath    = m_SettingsPath + ".journal";
+    m_CompactingPath = m_SettingsPath + ".compacting";
+    m_RecordCount    = 0;
+    m_CompactLimit   = compactLimit;
+}
+
+ed::vector<ed::string> ed::SettingsJournal::Load()
+{
+    vector<string> records;
+
+    // A ".compacting" file is left behind when the last compaction did not finish,
+    // its records are older than the ones in the journal.
+    for (auto path : { &m_CompactingPath, &m_JournalPath })
+    {
+        std::ifstream file(*path);
+        string line;
+        while (std::getline(file, line))
+        {
+            if (line.empty())
+                continue;
+
+            records.push_back(std::move(line));
+            if (path == &m_JournalPath)
+                ++m_RecordCount;
+        }
+    }
+
+    return records;
+}
+
+bool ed::SettingsJournal::Append(const string& record)
+{
+    if (!m_File.is_open())
+        m_File.open(m_JournalPath, std::ios_base::app);
+
+    m_File << record << '\n';
+    m_File.flush();
+
+    if (!m_File)
+    {
+        m_File.close();
+        return false;
+    }
+
+    ++m_RecordCount;
+
+    return true;
+}
+
+void ed::SettingsJournal::CompactIfNeeded(const Settings& settings)
+{
+    if (m_RecordCount < m_CompactLimit || m_IsCompacting)
+        return;
+
+    WaitForCompaction();
+
+    m_File.close();
+
+    // Records of a compaction that failed are not in the settings file yet, keep them.
+    if (std::ifstream(m_CompactingPath))
+    {
+        {
+            std::ofstream compacting(m_CompactingPath, std::ios_base::app);
+            std::ifstream journal(m_JournalPath);
+            compacting << journal.rdbuf();
+            if (!compacting)
+                return;
+        }
+        std::remove(m_JournalPath.c_str());
+    }
+    else if (std::rename(m_JournalPath.c_str(), m_CompactingPath.c_str()) != 0)
+        return;
+
+    m_RecordCount  = 0;
+    m_IsCompacting = true;
+
+    m_CompactThread = std::thread([this, snapshot = settings]() mutable
+    {
+        auto temporaryPath = m_SettingsPath + ".tmp";
+        bool written = false;
+        {
+            std::ofstream file(temporaryPath);
+            file << snapshot.Serialize();
+            written = !!file;
+        }
+
+        if (written && std::rename(temporaryPath.c_str(), m_SettingsPath.c_str()) == 0)
+            std::remove(m_CompactingPath.c_str());
+
+        m_IsCompacting = false;
+    });
+}
+
+void ed::SettingsJournal::WaitForCompaction()
+{
+    if (m_CompactThread.joinable())
+        m_CompactThread.join();
+}
+
+
+
+
 //------------------------------------------------------------------------------
 //
 // Animation
@@ -4732,8 +5083,14 @@ void ed::NodeBuilder::Begin(NodeId nodeId)
     // Grow channel list and select user channel
     if (auto drawList = ImGui::GetWindowDrawList())
     {
-        m_CurrentNode->m_Channel = drawList->_Splitter._Count;
-        ImDrawList_ChannelsGrow(drawList, drawList->_Splitter._Count + c_ChannelsPerNode);
+        // Group type is known from the previous frame or from the settings
+        if (Editor->GetSharedNodeChannel() >= 0 && !IsGroup(m_CurrentNode))
+            m_CurrentNode->m_Channel = Editor->GetSharedNodeChannel();
+        else
+        {
+            m_CurrentNode->m_Channel = drawList->_Splitter._Count;
+            ImDrawList_ChannelsGrow(drawList, drawList->_Splitter._Count + c_ChannelsPerNode);
+        }
         drawList->ChannelsSetCurrent(m_CurrentNode->m_Channel + c_NodeContentChannel);
 
         m_Splitter.Clear();
@@ -28,6 +28,11 @@
 
 # include <vector>
 # include <string>
+# include <unordered_map>
+# include <cstdint>
+# include <fstream>
+# include <thread>
+# include <atomic>
 
 
 //------------------------------------------------------------------------------
@@ -196,6 +201,41 @@ struct ObjectWrapper
     }
 };
 
+// Range of spatial index cells covered by an object, empty when the object is not indexed.
+struct SpatialCells
+{
+    int  m_MinX;
+    int  m_MinY;
+    int  m_MaxX;
+    int  m_MaxY;
+    bool m_IsOversized;
+
+    SpatialCells()
+        : m_MinX(0)
+        , m_MinY(0)
+        , m_MaxX(-1)
+        , m_MaxY(-1)
+        , m_IsOversized(false)
+    {
+    }
+
+    bool IsEmpty() const { return m_MaxX < m_MinX || m_MaxY < m_MinY; }
+
+    int64_t Count() const
+    {
+        if (IsEmpty())
+            return 0;
+        return int64_t(m_MaxX - m_MinX + 1) * int64_t(m_MaxY - m_MinY + 1);
+    }
+
+    bool operator==(const SpatialCells& rhs) const
+    {
+        return m_MinX == rhs.m_MinX && m_MinY == rhs.m_MinY
+            && m_MaxX == rhs.m_MaxX && m_MaxY == rhs.m_MaxY
+            && m_IsOversized == rhs.m_IsOversized;
+    }
+};
+
 struct Object
 {
     enum DrawFlags
@@ -214,9 +254,12 @@ struct Object
 
     bool    m_IsLive;
 
+    SpatialCells m_IndexedCells;
+
     Object(EditorContext* editor)
         : Editor(editor)
         , m_IsLive(true)
+        , m_IndexedCells()
     {
     }
 
@@ -444,6 +487,8 @@ struct Link final: Object
     ImVec2 m_Start;
     ImVec2 m_End;
 
+    ImCubicBezierPoints m_IndexedCurve;
+
     Link(EditorContext* editor, LinkId id)
         : Object(editor)
         , m_ID(id)
@@ -451,6 +496,7 @@ struct Link final: Object
         , m_EndPin(nullptr)
         , m_Color(IM_COL32_WHITE)
         , m_Thickness(1.0f)
+        , m_IndexedCurve()
     {
     }
 
@@ -473,6 +519,77 @@ struct Link final: Object
     virtual Link* AsLink() override final { return this; }
 };
 
+// Uniform grid over canvas space used for hit-testing. Every object is stored in the cells
+// its bounds overlap and moved only when that range changes. Objects spanning too many
+// cells are kept in a separate list visited by every query.
+struct SpatialIndex
+{
+    SpatialIndex(float cellSize = 256.0f, int64_t maxObjectCells = 256);
+
+    void Update(Object* object, const ImRect& bounds);
+    void Remove(Object* object);
+
+    size_t GetCellCount() const { return m_Cells.size(); }
+    size_t GetOversizedCount() const { return m_Oversized.size(); }
+
+    // Visits once every object whose cells overlap rect, candidates still need a TestHit.
+    template <typename F>
+    void Query(const ImRect& rect, F&& visit) const
+    {
+        for (auto object : m_Oversized)
+            visit(object);
+
+        const auto cells = GetCells(rect);
+        if (cells.IsEmpty() || m_Cells.empty())
+            return;
+
+        auto visitCell = [&cells, &visit](int x, int y, const vector<Object*>& objects)
+        {
+            for (auto object : objects)
+            {
+                // An object spanning several cells is reported by the first one it shares with rect
+                const auto& objectCells = object->m_IndexedCells;
+                if (x == ImMax(objectCells.m_MinX, cells.m_MinX) && y == ImMax(objectCells.m_MinY, cells.m_MinY))
+                    visit(object);
+            }
+        };
+
+        // Large queries walk the occupied cells instead of the covered ones
+        if (cells.Count() > static_cast<int64_t>(m_Cells.size()))
+        {
+            for (auto& cell : m_Cells)
+            {
+                const auto x = CellX(cell.first);
+                const auto y = CellY(cell.first);
+                if (x >= cells.m_MinX && x <= cells.m_MaxX && y >= cells.m_MinY && y <= cells.m_MaxY)
+                    visitCell(x, y, cell.second);
+            }
+            return;
+        }
+
+        for (int y = cells.m_MinY; y <= cells.m_MaxY; ++y)
+            for (int x = cells.m_MinX; x <= cells.m_MaxX; ++x)
+            {
+                auto cellIt = m_Cells.find(CellKey(x, y));
+                if (cellIt != m_Cells.end())
+                    visitCell(x, y, cellIt->second);
+            }
+    }
+
+private:
+    SpatialCells GetCells(const ImRect& bounds) const;
+
+    static uint64_t CellKey(int x, int y) { return (uint64_t(uint32_t(x)) << 32) | uint32_t(y); }
+    static int CellX(uint64_t key) { return int(uint32_t(key >> 32)); }
+    static int CellY(uint64_t key) { return int(uint32_t(key)); }
+
+    float   m_InvCellSize;
+    int64_t m_MaxObjectCells;
+
+    std::unordered_map<uint64_t, vector<Object*>> m_Cells;
+    vector<Object*>                               m_Oversized;
+};
+
 struct NodeSettings
 {
     NodeId m_ID;
@@ -503,7 +620,7 @@ struct NodeSettings
     json::value Serialize();
 
     static bool Parse(const std::string& string, NodeSettings& settings);
-    static bool Parse(const json::value& data, NodeSettings& result);
+    static bool Parse(const json::document::view& data, NodeSettings& result);
 };
 
 struct Settings
@@ -516,6 +633,9 @@ struct Settings
     ImVec2               m_ViewScroll;
     float                m_ViewZoom;
 
+    // Position of each node in m_Nodes, by id
+    std::unordered_map<void*, size_t> m_NodeIndex;
+
     Settings()
         : m_IsDirty(false)
         , m_DirtyReason(SaveReasonFlags::None)
@@ -532,7 +652,54 @@ struct Settings
 
     std::string Serialize();
 
+    // Only the given nodes, plus selection and view when they are dirty. Parse() applies
+    // the result over existing settings.
+    std::string SerializeChanges(const vector<NodeSettings*>& nodes);
+
     static bool Parse(const std::string& string, Settings& settings);
+
+private:
+    void SerializeSelection(json::value& result);
+    void SerializeView(json::value& result);
+};
+
+// Append-only log of settings changes next to Config::SettingsFile, used when
+// Config::SettingsJournal is set. Each save appends one record with the dirty
+// nodes only. Once the log holds Config::SettingsJournalCompactLimit records it
+// is folded into the settings file on a background thread. Loading replays the
+// records over the settings file.
+//
+// While compacting, the log being folded is moved aside to "<file>.compacting"
+// and new records go to a fresh "<file>.journal". Records hold absolute values,
+// so replaying one that already made it into the settings file is harmless.
+struct SettingsJournal
+{
+    SettingsJournal();
+    ~SettingsJournal();
+
+    void Open(const char* settingsFile, int compactLimit);
+    bool IsOpen() const { return !m_SettingsPath.empty(); }
+
+    // Records left by previous sessions, oldest first.
+    vector<string> Load();
+
+    bool Append(const string& record);
+
+    // Starts folding the log into the settings file if it is long enough and no
+    // compaction is running. Settings are copied, serialization happens on the worker.
+    void CompactIfNeeded(const Settings& settings);
+
+    void WaitForCompaction();
+
+private:
+    string              m_SettingsPath;
+    string              m_JournalPath;
+    string              m_CompactingPath;
+    std::ofstream       m_File;
+    int                 m_RecordCount;
+    int                 m_CompactLimit;
+    std::thread         m_CompactThread;
+    std::atomic<bool>   m_IsCompacting;
 };
 
 struct Control
@@ -1251,6 +1418,8 @@ struct EditorContext
 
     Style& GetStyle() { return m_Style; }
 
+    int GetSharedNodeChannel() const { return m_SharedNodeChannel; }
+
     void Begin(const char* id, const ImVec2& size = ImVec2(0, 0));
     void End();
 
@@ -1361,6 +1530,7 @@ struct EditorContext
 
     void RegisterAnimation(Animation* animation);
     void UnregisterAnimation(Animation* animation);
+    bool HasLiveAnimations() const { return !m_LiveAnimations.empty(); }
 
     void Flow(Link* link);
 
@@ -1394,6 +1564,8 @@ private:
 
     Control BuildControl(bool allowOffscreen);
 
+    void UpdateSpatialIndex();
+
     void ShowMetrics(const Control& control);
 
     void UpdateAnimations();
@@ -1409,12 +1581,22 @@ private:
     vector<ObjectWrapper<Pin>>  m_Pins;
     vector<ObjectWrapper<Link>> m_Links;
 
+    // Objects by id. m_Nodes keeps the drawing order and m_Links is sorted by id once per
+    // frame, so objects created in bulk are not sorted on every insertion.
+    std::unordered_map<void*, Node*> m_NodeIndex;
+    std::unordered_map<void*, Pin*>  m_PinIndex;
+    std::unordered_map<void*, Link*> m_LinkIndex;
+    bool                             m_AreLinksSorted;
+
+    SpatialIndex        m_SpatialIndex;
+
     vector<Object*>     m_SelectedObjects;
 
     vector<Object*>     m_LastSelectedObjects;
     uint64_t            m_SelectionId;
 
     Link*               m_LastActiveLink;
+    Node*               m_LastActiveNode;
 
     vector<Animation*>  m_LiveAnimations;
     vector<Animation*>  m_LastLiveAnimations;
@@ -1448,9 +1630,13 @@ private:
     Settings            m_Settings;
 
     Config              m_Config;
+    SettingsJournal     m_SettingsJournal;
 
     int                 m_ExternalChannel;
     ImDrawListSplitter  m_Splitter;
+
+    // First of the layers shared by regular nodes when Config::SharedNodeChannels is set, -1 otherwise.
+    int                 m_SharedNodeChannel;
 };
 
 